@@ -5,23 +5,24 @@
 #include "../utilities/ray.h"
 #include <algorithm> // For std::min/max
 
-class AABB {
+template <typename T>
+class AABBT {
 public:
-    Vector3 min_point;
-    Vector3 max_point;
+    Vector3T<T> min_point;
+    Vector3T<T> max_point;
 
     // creates an empty/invalid box
-    AABB() {}
+    AABBT() {}
 
     // Constructor with min and max points
-    AABB(const Vector3& min_p, const Vector3& max_p) : min_point(min_p), max_point(max_p) {}
+    AABBT(const Vector3T<T>& min_p, const Vector3T<T>& max_p) : min_point(min_p), max_point(max_p) {}
 
-    bool intersect(const Ray& ray, double tmin, double tmax) const;
+    bool intersect(const RayT<T>& ray, double tmin, double tmax) const;
 
 
-    static AABB combine(const AABB& box1, const AABB& box2);
+    static AABBT combine(const AABBT& box1, const AABBT& box2);
 
-    static void updateBounds(const Vector3& p, Vector3& min_p, Vector3& max_p) {
+    static void updateBounds(const Vector3T<T>& p, Vector3T<T>& min_p, Vector3T<T>& max_p) {
         min_p.x = std::min(min_p.x, p.x);
         min_p.y = std::min(min_p.y, p.y);
         min_p.z = std::min(min_p.z, p.z);
@@ -31,4 +32,11 @@ public:
     }
 };
 
+// the definitions are compiled once for each scalar type in aabb.cpp.
+extern template class AABBT<float>;
+extern template class AABBT<double>;
+
+// the bounding box type used throughout the renderer, at the precision selected for the build.
+using AABB = AABBT<Real>;
+
 #endif //B216602_AABB_H
\ No newline at end of file
@@ -29,7 +29,7 @@ bool boxCompareZ(const std::shared_ptr<Shape>& a, const std::shared_ptr<Shape>&
     return boxCompare(a, b, 2);
 }
 
-BVHNode::BVHNode(std::vector<std::shared_ptr<Shape>>& objects, size_t start, size_t end) {
+BVHNode::BVHNode(std::vector<std::shared_ptr<Shape>>& objects, size_t start, size_t end, MonotonicArena& arena) {
     AABB span_box;
     bool first_box = true;
 
@@ -79,8 +79,8 @@ BVHNode::BVHNode(std::vector<std::shared_ptr<Shape>>& objects, size_t start, siz
         std::nth_element(objects.begin() + start, mid_iter, objects.begin() + end, comparator);
 
         size_t mid = start + object_span / 2;
-        m_left = std::make_shared<BVHNode>(objects, start, mid);
-        m_right = std::make_shared<BVHNode>(objects, mid, end);
+        m_left = arena_make_shared<BVHNode>(arena, objects, start, mid, arena);
+        m_right = arena_make_shared<BVHNode>(arena, objects, mid, end, arena);
     }
 
     // Calculate this node's bounding box
@@ -4,6 +4,7 @@
 #include "../shapes/hittable.h"
 #include "../shapes/hittable_list.h"
 #include "aabb.h"
+#include "../utilities/arena.h"
 #include <vector>
 #include <memory>
 #include <algorithm>
@@ -13,11 +14,11 @@ public:
 
     // Two constructors, one takes a range from hittable objects and one takes the whole list of hittable objects.
 
-    // Builds the BVH tree from a list of hittable objects.
-    BVHNode(std::vector<std::shared_ptr<Shape>>& objects, size_t start, size_t end);
+    // Builds the BVH tree from a list of hittable objects. the child nodes are allocated from 'arena'.
+    BVHNode(std::vector<std::shared_ptr<Shape>>& objects, size_t start, size_t end, MonotonicArena& arena);
 
     // Alternative constructor that takes a HittableList directly
-    BVHNode(HittableList& list) : BVHNode(list.objects, 0, list.objects.size()) {}
+    BVHNode(HittableList& list, MonotonicArena& arena) : BVHNode(list.objects, 0, list.objects.size(), arena) {}
 
 
     // Checks for intersection by testing the bounding box first, then children.
@@ -0,0 +1,130 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "light_bvh.h"
+#include <algorithm>
+#include <cmath>
+
+// the perceived brightness of a light's colour, used as its power when weighting the tree.
+// equation: luminance = 0.2126 r + 0.7152 g + 0.0722 b
+static double luminance(const Vector3& colour) {
+    return 0.2126 * colour.x + 0.7152 * colour.y + 0.0722 * colour.z;
+}
+
+LightBVH::LightBVH(const std::vector<PointLight>& lights) {
+    if (lights.empty()) {
+        return;
+    }
+    std::vector<uint32_t> order(lights.size());
+    for (size_t i = 0; i < lights.size(); ++i) {
+        order[i] = static_cast<uint32_t>(i);
+    }
+    m_nodes.reserve(2 * lights.size());
+    buildNode(lights, order, 0, lights.size());
+}
+
+// builds the tree by splitting the lights at the median position along the longest axis.
+uint32_t LightBVH::buildNode(const std::vector<PointLight>& lights, std::vector<uint32_t>& order, size_t start, size_t end) {
+    // computes the box around the light centres and their total power.
+    Vector3 min_p = lights[order[start]].position;
+    Vector3 max_p = min_p;
+    double power = 0.0;
+    for (size_t i = start; i < end; ++i) {
+        const PointLight& light = lights[order[i]];
+        AABB::updateBounds(light.position, min_p, max_p);
+        power += std::max(0.0, luminance(light.intensity));
+    }
+
+    uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({AABB(min_p, max_p), power, order[start], true});
+
+    if (end - start == 1) {
+        // base case: the node becomes a leaf holding a single light.
+        return node_index;
+    }
+
+    // picks the axis with the largest extent.
+    Vector3 extent = max_p - min_p;
+    int axis = 0;
+    if (extent.y > extent.x && extent.y > extent.z) {
+        axis = 1;
+    } else if (extent.z > extent.x && extent.z > extent.y) {
+        axis = 2;
+    }
+
+    size_t mid = start + (end - start) / 2;
+    std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+        const Vector3& pa = lights[a].position;
+        const Vector3& pb = lights[b].position;
+        if (axis == 0) return pa.x < pb.x;
+        if (axis == 1) return pa.y < pb.y;
+        return pa.z < pb.z;
+    });
+
+    // the left child is always stored directly after its parent.
+    buildNode(lights, order, start, mid);
+    uint32_t right = buildNode(lights, order, mid, end);
+    m_nodes[node_index].light_or_right = right;
+    m_nodes[node_index].is_leaf = false;
+    return node_index;
+}
+
+double LightBVH::importance(const Node& node, const Vector3& P, const Vector3& N) const {
+    Vector3 center = (node.box.min_point + node.box.max_point) * 0.5;
+    Vector3 half_extent = (node.box.max_point - node.box.min_point) * 0.5;
+    Vector3 to_center = center - P;
+
+    // the largest value of N . (x - P) over the box. if it is not positive, every light in the box is behind the surface.
+    // equation: max_dot = N . (center - P) + |N.x| * h.x + |N.y| * h.y + |N.z| * h.z
+    double max_dot = N.dot(to_center)
+                   + std::abs(N.x) * half_extent.x + std::abs(N.y) * half_extent.y + std::abs(N.z) * half_extent.z;
+    if (max_dot <= 0.0) {
+        return 0.0;
+    }
+
+    // the distance is clamped to the size of the box, so a point inside a cluster does not favour it without bound.
+    double dist_sq = std::max(to_center.dot(to_center), half_extent.dot(half_extent));
+    dist_sq = std::max(dist_sq, 1e-8);
+
+    // a leaf is a single light, so its cosine is exact. interior nodes assume the best orientation.
+    double cos_bound = 1.0;
+    if (node.is_leaf) {
+        cos_bound = max_dot / std::sqrt(dist_sq);
+    }
+    return node.power * cos_bound / dist_sq;
+}
+
+bool LightBVH::sample(const Vector3& P, const Vector3& N, double u, uint32_t& light_index, double& pdf) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+    pdf = 1.0;
+    uint32_t node_index = 0;
+    while (!m_nodes[node_index].is_leaf) {
+        uint32_t left = node_index + 1;
+        uint32_t right = m_nodes[node_index].light_or_right;
+        double left_importance = importance(m_nodes[left], P, N);
+        double right_importance = importance(m_nodes[right], P, N);
+        double total = left_importance + right_importance;
+        if (total <= 0.0) {
+            return false;
+        }
+
+        // picks a child with probability proportional to its importance, then rescales u to [0, 1) so it can be reused below.
+        double left_probability = left_importance / total;
+        if (u < left_probability) {
+            u = u / left_probability;
+            pdf *= left_probability;
+            node_index = left;
+        } else {
+            u = (u - left_probability) / (1.0 - left_probability);
+            pdf *= 1.0 - left_probability;
+            node_index = right;
+        }
+        // keeps u below one after rounding.
+        u = std::min(u, 0.99999999);
+    }
+    light_index = m_nodes[node_index].light_or_right;
+    return importance(m_nodes[node_index], P, N) > 0.0;
+}
@@ -0,0 +1,59 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_LIGHT_BVH_H
+#define B216602_LIGHT_BVH_H
+
+#include "../environment/light.h"
+#include "aabb.h"
+#include <vector>
+#include <cstdint>
+
+// a bounding volume hierarchy over the point lights, used to pick lights in proportion to their likely contribution.
+// each node stores the bounds and total power of the lights below it. sampling walks down from the root,
+// choosing a child with probability proportional to its importance at the shading point, so a light is found
+// in O(log n) steps and its selection probability is known exactly, which keeps the lighting estimate unbiased.
+// lights are treated as points at their centres, so the tree only supports point lights. a light with a radius is
+// still sampled correctly, because its diffuse and specular terms are shaded from its centre and the radius only
+// softens its shadow, but the importance ignores the extra reach of the sphere.
+class LightBVH {
+public:
+    LightBVH() = default;
+
+    // builds the tree over the given lights. the indices returned by sample refer to this vector.
+    explicit LightBVH(const std::vector<PointLight>& lights);
+
+    // picks a light for a shading point with position P and normal N, using u in [0, 1) as the random choice.
+    // returns false if no light can light the point (every light is behind the surface).
+    // 'pdf' is the probability that this light was picked.
+    bool sample(const Vector3& P, const Vector3& N, double u, uint32_t& light_index, double& pdf) const;
+
+    bool empty() const { return m_nodes.empty(); }
+
+private:
+    // a node of the flat tree. interior nodes store their right child index, the left child immediately follows the node.
+    // every leaf holds a single light.
+    struct Node {
+        AABB box;
+        // the summed luminance of every light below this node.
+        double power;
+        // the light index of a leaf, or the right child of an interior node.
+        uint32_t light_or_right;
+        bool is_leaf;
+    };
+
+    // recursively builds the tree over lights [start, end) of 'order', returning the index of the new node.
+    // 'order' holds light indices and is reordered so each subtree covers a contiguous range.
+    uint32_t buildNode(const std::vector<PointLight>& lights, std::vector<uint32_t>& order, size_t start, size_t end);
+
+    // estimates how much the lights under a node could contribute to the shading point, from the distance to the
+    // centre of the box around the light centres. the distance to the nearest point of the box bounds a close cluster
+    // more tightly, but weights the far side of every cluster as heavily as the near side, which made renders noisier.
+    // equation: importance = power * cos_bound / distance^2
+    double importance(const Node& node, const Vector3& P, const Vector3& N) const;
+
+    std::vector<Node> m_nodes;
+};
+
+#endif //B216602_LIGHT_BVH_H
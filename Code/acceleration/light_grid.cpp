@@ -0,0 +1,100 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "light_grid.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+LightGrid::LightGrid(const std::vector<PointLight>& lights, const AABB& bounds, int resolution, double exposure, double threshold)
+    : m_bounds(bounds), m_resolution(std::max(1, resolution)) {
+    // a flat axis (e.g. a scene made of a single plane) still gets cells of non-zero size.
+    Vector3 extent = bounds.max_point - bounds.min_point;
+    m_cell_size = Vector3(extent.x > 0 ? extent.x / m_resolution : 1.0,
+                          extent.y > 0 ? extent.y / m_resolution : 1.0,
+                          extent.z > 0 ? extent.z / m_resolution : 1.0);
+
+    m_positions.reserve(lights.size());
+    m_radius_sq.reserve(lights.size());
+    for (const PointLight& light : lights) {
+        m_positions.push_back(light.position);
+        double brightest = std::max(light.intensity.x, std::max(light.intensity.y, light.intensity.z));
+        // a threshold of zero turns culling off, so every light reaches every cell.
+        if (threshold > 0.0) {
+            m_radius_sq.push_back(std::max(0.0, brightest) * exposure / threshold);
+        } else {
+            m_radius_sq.push_back(std::numeric_limits<double>::infinity());
+        }
+    }
+
+    // converts a coordinate to a cell index along one axis, clamped to the grid.
+    // the clamp happens before the conversion to int, since an unlimited radius gives an infinite coordinate.
+    auto cell_of = [&](double value, double min, double size) {
+        double cell = std::floor((value - min) / size);
+        return static_cast<int>(std::min(std::max(cell, 0.0), static_cast<double>(m_resolution - 1)));
+    };
+
+    // visits every cell overlapped by a light's sphere of influence.
+    // the cell range comes from the sphere's bounding box, then each cell is kept only if its closest point is within the radius.
+    auto for_each_cell = [&](uint32_t light_index, auto&& visit) {
+        const Vector3& p = m_positions[light_index];
+        double radius = std::sqrt(m_radius_sq[light_index]);
+        int x0 = cell_of(p.x - radius, m_bounds.min_point.x, m_cell_size.x), x1 = cell_of(p.x + radius, m_bounds.min_point.x, m_cell_size.x);
+        int y0 = cell_of(p.y - radius, m_bounds.min_point.y, m_cell_size.y), y1 = cell_of(p.y + radius, m_bounds.min_point.y, m_cell_size.y);
+        int z0 = cell_of(p.z - radius, m_bounds.min_point.z, m_cell_size.z), z1 = cell_of(p.z + radius, m_bounds.min_point.z, m_cell_size.z);
+        for (int z = z0; z <= z1; ++z) {
+            for (int y = y0; y <= y1; ++y) {
+                for (int x = x0; x <= x1; ++x) {
+                    Vector3 cell_min = m_bounds.min_point + Vector3(x * m_cell_size.x, y * m_cell_size.y, z * m_cell_size.z);
+                    Vector3 cell_max = cell_min + m_cell_size;
+                    // the closest point of the cell to the light.
+                    Vector3 closest(std::min(std::max(p.x, cell_min.x), cell_max.x),
+                                    std::min(std::max(p.y, cell_min.y), cell_max.y),
+                                    std::min(std::max(p.z, cell_min.z), cell_max.z));
+                    Vector3 d = closest - p;
+                    if (d.dot(d) <= m_radius_sq[light_index]) {
+                        visit((z * m_resolution + y) * m_resolution + x);
+                    }
+                }
+            }
+        }
+    };
+
+    // the cell lists are packed into one array: the first pass counts each cell's lights, the second fills them in.
+    size_t cell_count = static_cast<size_t>(m_resolution) * m_resolution * m_resolution;
+    m_cell_start.assign(cell_count + 1, 0);
+    for (uint32_t i = 0; i < m_positions.size(); ++i) {
+        for_each_cell(i, [&](int cell) { m_cell_start[cell + 1]++; });
+    }
+    for (size_t c = 0; c < cell_count; ++c) {
+        m_cell_start[c + 1] += m_cell_start[c];
+    }
+    m_cell_lights.resize(m_cell_start[cell_count]);
+    std::vector<uint32_t> fill(m_cell_start.begin(), m_cell_start.end() - 1);
+    for (uint32_t i = 0; i < m_positions.size(); ++i) {
+        for_each_cell(i, [&](int cell) { m_cell_lights[fill[cell]++] = i; });
+    }
+}
+
+bool LightGrid::cellLights(const Vector3& P, const uint32_t*& begin, const uint32_t*& end) const {
+    if (m_resolution == 0) {
+        return false;
+    }
+    // points outside the scene bounds (up to a small tolerance) are not covered by any cell.
+    Vector3 slack = m_cell_size * 1e-3;
+    if (P.x < m_bounds.min_point.x - slack.x || P.x > m_bounds.max_point.x + slack.x ||
+        P.y < m_bounds.min_point.y - slack.y || P.y > m_bounds.max_point.y + slack.y ||
+        P.z < m_bounds.min_point.z - slack.z || P.z > m_bounds.max_point.z + slack.z) {
+        return false;
+    }
+
+    int x = std::min(std::max(static_cast<int>((P.x - m_bounds.min_point.x) / m_cell_size.x), 0), m_resolution - 1);
+    int y = std::min(std::max(static_cast<int>((P.y - m_bounds.min_point.y) / m_cell_size.y), 0), m_resolution - 1);
+    int z = std::min(std::max(static_cast<int>((P.z - m_bounds.min_point.z) / m_cell_size.z), 0), m_resolution - 1);
+    size_t cell = (static_cast<size_t>(z) * m_resolution + y) * m_resolution + x;
+
+    begin = m_cell_lights.data() + m_cell_start[cell];
+    end = m_cell_lights.data() + m_cell_start[cell + 1];
+    return true;
+}
@@ -0,0 +1,50 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_LIGHT_GRID_H
+#define B216602_LIGHT_GRID_H
+
+#include "../environment/light.h"
+#include "aabb.h"
+#include <vector>
+#include <cstdint>
+
+// a uniform grid over the scene bounds that stores, for each cell, the lights that can reach it.
+// each light is given a cutoff radius beyond which its 1/d^2 falloff drops below a brightness threshold,
+// so shading a point only visits the lights listed in its cell, and only traces shadow rays to lights in range.
+class LightGrid {
+public:
+    LightGrid() = default;
+
+    // builds the grid over 'bounds' with 'resolution' cells along each axis.
+    // a light's cutoff is where its brightest channel, scaled by the exposure, falls below 'threshold'.
+    // equation: radius^2 = max(intensity) * exposure / threshold
+    LightGrid(const std::vector<PointLight>& lights, const AABB& bounds, int resolution, double exposure, double threshold);
+
+    // finds the lights listed for the cell containing P. returns false if P is outside the grid,
+    // in which case the caller should fall back to every light.
+    bool cellLights(const Vector3& P, const uint32_t*& begin, const uint32_t*& end) const;
+
+    // checks whether P is within the cutoff radius of the light.
+    bool reaches(uint32_t light_index, const Vector3& P) const {
+        Vector3 d = m_positions[light_index] - P;
+        return d.dot(d) <= m_radius_sq[light_index];
+    }
+
+    // returns the total number of light references stored in the cells.
+    size_t referenceCount() const { return m_cell_lights.size(); }
+
+private:
+    AABB m_bounds;
+    int m_resolution = 0;
+    Vector3 m_cell_size;
+    // the light positions and squared cutoff radii, indexed like the scene's lights.
+    std::vector<Vector3> m_positions;
+    std::vector<double> m_radius_sq;
+    // the lights of cell c are m_cell_lights[m_cell_start[c]] to m_cell_lights[m_cell_start[c + 1] - 1].
+    std::vector<uint32_t> m_cell_start;
+    std::vector<uint32_t> m_cell_lights;
+};
+
+#endif //B216602_LIGHT_GRID_H
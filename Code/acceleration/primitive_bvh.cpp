@@ -0,0 +1,175 @@
+//
+// Created by alex on 04/12/2025.
+//
+
+#include "primitive_bvh.h"
+#include <algorithm>
+#include <iostream>
+#include <typeinfo>
+
+// the maximum number of primitives stored in a single leaf, matching the pointer-based bvh.
+static const size_t MAX_LEAF_PRIMITIVES = 2;
+
+PrimitiveBVH::PrimitiveBVH(const std::vector<std::shared_ptr<Shape>>& objects) {
+    std::vector<AABB> boxes;
+    boxes.reserve(objects.size());
+    m_handles.reserve(objects.size());
+
+    for (const auto& object : objects) {
+        AABB box;
+        if (!object->getBoundingBox(box)) {
+            std::cerr << "Error: No bounding box in PrimitiveBVH constructor.\n";
+            continue;
+        }
+
+        // 'typeid' compares the exact runtime type, so derived shapes such as complex spheres are not sliced into their base class.
+        const Shape& shape = *object;
+        if (typeid(shape) == typeid(Sphere)) {
+            m_handles.push_back(PrimitiveHandle::make(PrimitiveType::Sphere, static_cast<uint32_t>(m_spheres.size())));
+            m_spheres.push_back(static_cast<const Sphere&>(shape));
+        } else if (typeid(shape) == typeid(Cube)) {
+            m_handles.push_back(PrimitiveHandle::make(PrimitiveType::Cube, static_cast<uint32_t>(m_cubes.size())));
+            m_cubes.push_back(static_cast<const Cube&>(shape));
+        } else if (typeid(shape) == typeid(Plane)) {
+            m_handles.push_back(PrimitiveHandle::make(PrimitiveType::Plane, static_cast<uint32_t>(m_planes.size())));
+            m_planes.push_back(static_cast<const Plane&>(shape));
+        } else {
+            m_handles.push_back(PrimitiveHandle::make(PrimitiveType::Other, static_cast<uint32_t>(m_others.size())));
+            m_others.push_back(object);
+        }
+        boxes.push_back(box);
+    }
+
+    if (!m_handles.empty()) {
+        m_nodes.reserve(2 * m_handles.size());
+        buildNode(boxes, 0, m_handles.size());
+    }
+}
+
+// builds the tree by splitting the handles at the median box centre along the longest axis.
+uint32_t PrimitiveBVH::buildNode(std::vector<AABB>& boxes, size_t start, size_t end) {
+    // computes the bounding box spanning all primitives in this range.
+    AABB span_box = boxes[start];
+    for (size_t i = start + 1; i < end; ++i) {
+        span_box = AABB::combine(span_box, boxes[i]);
+    }
+
+    uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({span_box, static_cast<uint32_t>(start), static_cast<uint32_t>(end - start)});
+
+    if (end - start <= MAX_LEAF_PRIMITIVES) {
+        // base case: the node becomes a leaf over this range of handles.
+        return node_index;
+    }
+
+    // picks the axis with the largest extent.
+    Vector3 extent = span_box.max_point - span_box.min_point;
+    int axis = 0;
+    if (extent.y > extent.x && extent.y > extent.z) {
+        axis = 1;
+    } else if (extent.z > extent.x && extent.z > extent.y) {
+        axis = 2;
+    }
+
+    // sorts an index range rather than the handles and boxes separately, so both stay paired.
+    std::vector<size_t> order(end - start);
+    for (size_t i = 0; i < order.size(); ++i) order[i] = start + i;
+    size_t mid = order.size() / 2;
+    std::nth_element(order.begin(), order.begin() + mid, order.end(), [&](size_t a, size_t b) {
+        Vector3 center_a = (boxes[a].min_point + boxes[a].max_point) * 0.5;
+        Vector3 center_b = (boxes[b].min_point + boxes[b].max_point) * 0.5;
+        if (axis == 0) return center_a.x < center_b.x;
+        if (axis == 1) return center_a.y < center_b.y;
+        return center_a.z < center_b.z;
+    });
+
+    std::vector<PrimitiveHandle> sorted_handles(order.size());
+    std::vector<AABB> sorted_boxes(order.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        sorted_handles[i] = m_handles[order[i]];
+        sorted_boxes[i] = boxes[order[i]];
+    }
+    std::copy(sorted_handles.begin(), sorted_handles.end(), m_handles.begin() + start);
+    std::copy(sorted_boxes.begin(), sorted_boxes.end(), boxes.begin() + start);
+
+    // the left child is always stored directly after its parent.
+    buildNode(boxes, start, start + mid);
+    uint32_t right = buildNode(boxes, start + mid, end);
+    m_nodes[node_index].first_or_right = right;
+    m_nodes[node_index].count = 0;
+    return node_index;
+}
+
+bool PrimitiveBVH::getBoundingBox(AABB& output_box) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+    output_box = m_nodes[0].box;
+    return true;
+}
+
+size_t PrimitiveBVH::getCount(PrimitiveType type) const {
+    switch (type) {
+        case PrimitiveType::Sphere: return m_spheres.size();
+        case PrimitiveType::Cube: return m_cubes.size();
+        case PrimitiveType::Plane: return m_planes.size();
+        default: return m_others.size();
+    }
+}
+
+bool PrimitiveBVH::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    bool hit_anything = false;
+    double closest_so_far = t_max;
+
+    // traverses the tree with an explicit stack instead of recursion.
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        uint32_t node_index = stack[--stack_size];
+        const Node& node = m_nodes[node_index];
+        // prunes nodes the ray misses or that are further away than the closest hit.
+        if (!node.box.intersect(ray, t_min, closest_so_far)) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            // interior node: visits the left child (stored next) first.
+            stack[stack_size++] = node.first_or_right;
+            stack[stack_size++] = node_index + 1;
+            continue;
+        }
+
+        // leaf node: dispatches on the primitive type. the qualified calls bypass the vtable.
+        for (uint32_t i = node.first_or_right; i < node.first_or_right + node.count; ++i) {
+            PrimitiveHandle handle = m_handles[i];
+            bool hit = false;
+            switch (handle.type()) {
+                case PrimitiveType::Sphere:
+                    hit = m_spheres[handle.index()].Sphere::intersect(ray, t_min, closest_so_far, rec);
+                    break;
+                case PrimitiveType::Cube:
+                    hit = m_cubes[handle.index()].Cube::intersect(ray, t_min, closest_so_far, rec);
+                    break;
+                case PrimitiveType::Plane:
+                    hit = m_planes[handle.index()].Plane::intersect(ray, t_min, closest_so_far, rec);
+                    break;
+                case PrimitiveType::Other:
+                    hit = m_others[handle.index()]->intersect(ray, t_min, closest_so_far, rec);
+                    break;
+            }
+            // the shapes only write to the record on a hit, so only closer hits can replace it.
+            if (hit) {
+                hit_anything = true;
+                closest_so_far = rec.t;
+            }
+        }
+    }
+
+    return hit_anything;
+}
@@ -0,0 +1,77 @@
+//
+// Created by alex on 04/12/2025.
+//
+
+#ifndef B216602_PRIMITIVE_BVH_H
+#define B216602_PRIMITIVE_BVH_H
+
+#include "../shapes/hittable.h"
+#include "../shapes/sphere.h"
+#include "../shapes/cube.h"
+#include "../shapes/plane.h"
+#include "aabb.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+
+// the concrete type of a primitive stored in a primitive bvh.
+// 'Other' covers every shape without its own array (complex shapes, meshes), which keeps the virtual call.
+enum class PrimitiveType : uint32_t {
+    Sphere = 0,
+    Cube = 1,
+    Plane = 2,
+    Other = 3
+};
+
+// a compact reference to a primitive: the type in the top two bits and the index into that type's array below them.
+struct PrimitiveHandle {
+    uint32_t bits;
+
+    static PrimitiveHandle make(PrimitiveType type, uint32_t index) {
+        return {(static_cast<uint32_t>(type) << 30) | index};
+    }
+    PrimitiveType type() const { return static_cast<PrimitiveType>(bits >> 30); }
+    uint32_t index() const { return bits & 0x3FFFFFFF; }
+};
+
+// a bounding volume hierarchy that stores its primitives by value in contiguous per-type arrays.
+// nodes live in a single flat array and the leaf loop dispatches on the primitive type with a switch,
+// so sphere, cube and plane tests are direct calls rather than virtual calls through scattered heap objects.
+class PrimitiveBVH : public Shape {
+public:
+    // copies the shapes into the per-type arrays and builds the tree over them.
+    explicit PrimitiveBVH(const std::vector<std::shared_ptr<Shape>>& objects);
+
+    // traverses the tree with an explicit stack and tests the primitives in each leaf it reaches.
+    virtual bool intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const override;
+    // returns the bounding box of the root node.
+    virtual bool getBoundingBox(AABB& output_box) const override;
+
+    // returns the number of primitives stored with the given type.
+    size_t getCount(PrimitiveType type) const;
+
+private:
+    // a node of the flat tree. interior nodes store their right child index, the left child immediately follows the node.
+    // leaf nodes store a range of handles instead.
+    struct Node {
+        AABB box;
+        // the first handle of a leaf, or the right child of an interior node.
+        uint32_t first_or_right;
+        // the number of handles in a leaf. zero for interior nodes.
+        uint32_t count;
+    };
+
+    // recursively builds the tree over handles [start, end), returning the index of the new node.
+    uint32_t buildNode(std::vector<AABB>& boxes, size_t start, size_t end);
+
+    std::vector<Sphere> m_spheres;
+    std::vector<Cube> m_cubes;
+    std::vector<Plane> m_planes;
+    std::vector<std::shared_ptr<Shape>> m_others;
+
+    // the primitive handles, ordered so each leaf covers a contiguous range.
+    std::vector<PrimitiveHandle> m_handles;
+    std::vector<Node> m_nodes;
+};
+
+#endif //B216602_PRIMITIVE_BVH_H
@@ -61,7 +61,9 @@ void Config::parseLine(std::string line, std::string& currentSection) {
     std::string fullKey = currentSection + "." + key;
 
     // Determine type
-    if (valPart == "true") {
+    if (valPart.size() >= 2 && valPart.front() == '\"' && valPart.back() == '\"') {
+        m_data[fullKey] = valPart.substr(1, valPart.size() - 2);
+    } else if (valPart == "true") {
         m_data[fullKey] = true;
     } else if (valPart == "false") {
         m_data[fullKey] = false;
@@ -76,7 +78,7 @@ void Config::parseLine(std::string line, std::string& currentSection) {
     }
 }
 
-int Config::getInt(const std::string& key, int defaultVal) const {
+int Config::getInt(std::string_view key, int defaultVal) const {
     auto it = m_data.find(key);
     if (it != m_data.end()) {
         if (std::holds_alternative<int>(it->second)) return std::get<int>(it->second);
@@ -85,7 +87,7 @@ int Config::getInt(const std::string& key, int defaultVal) const {
     return defaultVal;
 }
 
-double Config::getDouble(const std::string& key, double defaultVal) const {
+double Config::getDouble(std::string_view key, double defaultVal) const {
     auto it = m_data.find(key);
     if (it != m_data.end()) {
         if (std::holds_alternative<double>(it->second)) return std::get<double>(it->second);
@@ -94,10 +96,18 @@ double Config::getDouble(const std::string& key, double defaultVal) const {
     return defaultVal;
 }
 
-bool Config::getBool(const std::string& key, bool defaultVal) const {
+bool Config::getBool(std::string_view key, bool defaultVal) const {
     auto it = m_data.find(key);
     if (it != m_data.end() && std::holds_alternative<bool>(it->second)) {
         return std::get<bool>(it->second);
     }
     return defaultVal;
-}
\ No newline at end of file
+}
+
+std::string Config::getString(std::string_view key, const std::string& defaultVal) const {
+    auto it = m_data.find(key);
+    if (it != m_data.end() && std::holds_alternative<std::string>(it->second)) {
+        return std::get<std::string>(it->second);
+    }
+    return defaultVal;
+}
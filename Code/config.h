@@ -2,6 +2,7 @@
 #define B216602_CONFIG_H
 
 #include <string>
+#include <string_view>
 #include <map>
 #include <variant>
 #include <iostream>
@@ -18,13 +19,15 @@ public:
     bool load(const std::string& filepath);
 
     // Getters with default fallbacks
-    int getInt(const std::string& key, int defaultVal = 0) const;
-    double getDouble(const std::string& key, double defaultVal = 0.0) const;
-    bool getBool(const std::string& key, bool defaultVal = false) const;
+    // the keys are looked up as string views, so the getters called while rendering do not allocate a std::string.
+    int getInt(std::string_view key, int defaultVal = 0) const;
+    double getDouble(std::string_view key, double defaultVal = 0.0) const;
+    bool getBool(std::string_view key, bool defaultVal = false) const;
+    std::string getString(std::string_view key, const std::string& defaultVal = "") const;
 
 private:
     Config() = default;
-    std::map<std::string, std::variant<int, double, bool, std::string>> m_data;
+    std::map<std::string, std::variant<int, double, bool, std::string>, std::less<>> m_data;
 
     void parseLine(std::string line, std::string& currentSection);
 };
@@ -7,21 +7,8 @@
 #include <sstream>
 #include <iostream>
 #include "../utilities/vector3.h"
-#include <cstdlib>
-
-// generates a random point inside a 2d unit disk on the xy-plane.
-inline Vector3 random_in_unit_disk() {
-    // uses rejection sampling to find a point within the disk.
-    while (true) {
-        // generates a random point within a 2x2 square centered at the origin.
-        auto p = Vector3 ( (rand() / (RAND_MAX + 1.0)) * 2.0 - 1.0,
-                            (rand() / (RAND_MAX + 1.0)) * 2.0 - 1.0,
-                            0.0);
-        // if the point's squared length is less than 1, it is inside the unit disk.
-        if (p.dot(p) < 1.0)
-            return p;
-    }
-}
+#include "../utilities/random_utils.h"
+#include <algorithm>
 
 // constructor that initialises the camera with its position, orientation, and lens properties.
 Camera::Camera(
@@ -85,8 +72,42 @@ void Camera::computeCameraBasis() {
     m_camera_v = m_camera_u.cross(m_camera_w);
 }
 
-// converts normalised pixel coordinates to a ray in world coordinates.
+// converts normalised pixel coordinates to a ray in world coordinates, with a random point on the lens.
 Ray Camera::generateRay(float px, float py, double time) const {
+    // the lens point is only drawn for a thin lens, a pinhole camera ignores it.
+    if (m_aperture_radius <= 0.0) {
+        return generateRayThroughLens(px, py, time, Vector3(0, 0, 0));
+    }
+    double lens_u = random_double();
+    double lens_v = random_double();
+    return generateRay(px, py, time, lens_u, lens_v);
+}
+
+// converts normalised pixel coordinates to a ray in world coordinates, through the lens point given by (lens_u, lens_v).
+Ray Camera::generateRay(float px, float py, double time, double lens_u, double lens_v) const {
+    // maps the unit square to the unit disk with shirley and chiu's concentric mapping, which keeps
+    // stratified points stratified, unlike rejection sampling.
+    // equation: r = a, phi = (pi / 4) * (b / a) when |a| > |b|, otherwise r = b, phi = pi / 2 - (pi / 4) * (a / b)
+    double a = 2.0 * lens_u - 1.0;
+    double b = 2.0 * lens_v - 1.0;
+    Vector3 disk_point(0, 0, 0);
+    if (a != 0.0 || b != 0.0) {
+        const double quarter_pi = 0.78539816339744830962;
+        double r, phi;
+        if (std::abs(a) > std::abs(b)) {
+            r = a;
+            phi = quarter_pi * (b / a);
+        } else {
+            r = b;
+            phi = 2.0 * quarter_pi - quarter_pi * (a / b);
+        }
+        disk_point = Vector3(r * std::cos(phi), r * std::sin(phi), 0.0);
+    }
+    return generateRayThroughLens(px, py, time, disk_point);
+}
+
+// converts normalised pixel coordinates to a ray in world coordinates, leaving the lens through a point of the unit disk.
+Ray Camera::generateRayThroughLens(float px, float py, double time, const Vector3& disk_point) const {
 
     // maps normalised pixel coordinates (px, py in [0,1]) to sensor plane coordinates.
 
@@ -118,8 +139,8 @@ Ray Camera::generateRay(float px, float py, double time) const {
     // equation: focal_point = camera_location + pinhole_dir * focal_distance
     Vector3 focal_point = m_location + pinhole_dir * m_focal_distance;
 
-    // generates a random point on the lens (a disk with radius m_aperture_radius).
-    Vector3 random_disk_pt = random_in_unit_disk() * m_aperture_radius;
+    // scales the point on the unit disk to the lens (a disk with radius m_aperture_radius).
+    Vector3 random_disk_pt = disk_point * m_aperture_radius;
     // maps the 2d disk point to the 3d lens plane using the camera's u and v basis vectors.
     Vector3 lens_offset = m_camera_u * random_disk_pt.x + m_camera_v * random_disk_pt.y;
     // calculates the new ray origin on the lens surface.
@@ -133,3 +154,16 @@ Ray Camera::generateRay(float px, float py, double time) const {
     // returns the final ray for depth of field.
     return Ray(ray_origin, new_dir, time);
 }
+
+// returns the approximate number of pixels covered by one world unit at the point of a box closest to the camera.
+double Camera::pixelsPerUnitWithin(const AABB& box) const {
+    // finds the closest point in the box by clamping the camera location to it.
+    Vector3 closest(std::clamp(m_location.x, box.min_point.x, box.max_point.x),
+                    std::clamp(m_location.y, box.min_point.y, box.max_point.y),
+                    std::clamp(m_location.z, box.min_point.z, box.max_point.z));
+    // clamps the distance so a camera inside the box does not produce an infinite density.
+    double distance = std::max<double>((closest - m_location).length(), 1e-3);
+    // the sensor maps to the full image width, so one unit at 'distance' covers focal_length / (sensor_width * distance) of it.
+    // equation: pixels_per_unit = (m_focal_length / m_sensor_width) * m_resolution_x / distance
+    return (m_focal_length / m_sensor_width) * m_resolution_x / distance;
+}
@@ -10,6 +10,7 @@
 #include <stdexcept>
 #include "../utilities/vector3.h"
 #include "../utilities/ray.h"
+#include "../acceleration/aabb.h"
 #include <cmath>
 
 // it handles reading camera parameters and performing coordinate transformations.
@@ -30,12 +31,17 @@ public:
         );
     // converts normalised pixel coordinates (px, py) to a ray in world coordinates, accounting for depth of field and motion blur.
     Ray generateRay(float px, float py, double time = 0.0) const;
+    // the same, with the point on the lens given by (lens_u, lens_v) in [0, 1)^2 instead of chosen at random.
+    Ray generateRay(float px, float py, double time, double lens_u, double lens_v) const;
 
     // returns the horizontal resolution of the camera in pixels.
     int getResolutionX() const { return m_resolution_x; }
     // returns the vertical resolution of the camera in pixels.
     int getResolutionY() const { return m_resolution_y; }
 
+    // returns the approximate number of pixels covered by one world unit at the point of a box closest to the camera.
+    double pixelsPerUnitWithin(const AABB& box) const;
+
 private:
     // the world-space position of the camera.
     Vector3 m_location;
@@ -68,6 +74,9 @@ private:
 
     // a helper method to compute the orthonormal basis (u, v, w) from the provided hint vectors.
     void computeCameraBasis();
+
+    // traces the ray for pixel coordinates (px, py) through a point of the unit disk, scaled to the lens.
+    Ray generateRayThroughLens(float px, float py, double time, const Vector3& disk_point) const;
 };
 
 #endif //B216602_CAMERA_H
@@ -9,6 +9,16 @@
 #include "utilities/tracer.h"
 #include <stdexcept>
 #include "utilities/random_utils.h"
+#include "utilities/sampler.h"
+#include "utilities/tile_scheduler.h"
+#include "utilities/render_progress.h"
+#include "utilities/numa.h"
+#include "utilities/distributed.h"
+#include "utilities/batch.h"
+#include "utilities/timing_stats.h"
+#include "utilities/allocation_counter.h"
+#include "utilities/arena.h"
+#include "utilities/streaming_image_writer.h"
 #include "config.h"
 
 #include <chrono>
@@ -23,14 +33,24 @@
 #include <regex>
 #include <algorithm>
 #include <numeric>
+#include <limits>
+#include <csignal>
+#include <thread>
+#include <optional>
+#include <memory>
+#include <future>
 
-// This will only include the non-standard c library if it's compiled with OpenMP.
-#ifdef _OPENMP
-    #include <omp.h>
-#endif
+#include <unistd.h>
 
 namespace fs = std::filesystem;
 
+// set by the interrupt handler during a progressive render, which then stops after the current pass.
+static volatile std::sig_atomic_t g_stop_requested = 0;
+
+static void request_stop(int) {
+    g_stop_requested = 1;
+}
+
 // generates a timestamp string for file naming.
 std::string get_current_timestamp() {
     // get current time point.
@@ -64,8 +84,39 @@ int main(int argc, char* argv[]) {
     int run_count = 1;
     bool enable_timing = false;
     bool render_normals = false;
+    bool enable_tessellation = false;
+    bool use_virtual_bvh = false;
     bool enable_bvh_testing = false;
+    bool enable_dispatch_testing = false;
+    int ray_benchmark_passes = 0;
+    // the number of lights sampled per shading point. zero evaluates every light.
+    int light_samples = 0;
+    bool enable_light_culling = false;
+    bool enable_roulette = false;
+    // adaptive anti-aliasing: the sample count range per pixel and the error at which a pixel stops being sampled.
+    bool enable_adaptive_aa = false;
+    int adaptive_min_samples = 4;
+    int adaptive_max_samples = 64;
+    double adaptive_threshold = 0.01;
+    // the generator of the pixel, lens, time, light and glossy samples.
+    SamplerType sampler_type = SamplerType::Sobol;
+    if (!parse_sampler_type(Config::Instance().getString("render.sampler", "sobol"), sampler_type)) {
+        std::cerr << "Warning: Unknown sampler in config. Using sobol." << std::endl;
+    }
+    // the frame number mixed into every random number, so the frames of an animation get different noise.
+    int frame_number = 0;
+    // progressive rendering: the target samples per pixel and an optional time limit in seconds (zero for none).
+    bool enable_progressive = false;
+    int progressive_samples = 64;
+    double progressive_time_limit = 0.0;
+    std::vector<std::string> compare_paths;
+    double compare_tolerance = 2.0;
     int tonemap_mode = 0; // 0=None, 1=Reinhard, 2=ACES, 3=Filmic
+    // distributed rendering: the address a coordinator listens on for workers, or the coordinator a worker connects to.
+    std::string coordinator_address;
+    std::string worker_address;
+    // a job list of frames to render from this one process.
+    std::string batch_path;
     std::string all_args = "";
 
     // concatenate all command line arguments for logging purposes.
@@ -123,6 +174,84 @@ int main(int argc, char* argv[]) {
         }
     };
 
+    // handler for '--aa-adaptive' flag.
+    arg_handlers["--aa-adaptive"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 3 < argc) {
+            try {
+                // reads the minimum and maximum samples per pixel, then the error threshold.
+                adaptive_min_samples = std::stoi(argv[i + 1]);
+                adaptive_max_samples = std::stoi(argv[i + 2]);
+                adaptive_threshold = std::stod(argv[i + 3]);
+                i += 3;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid values for --aa-adaptive flag. Expected <min> <max> <threshold>." << std::endl;
+                exit(1);
+            }
+            // the error estimate needs at least two samples.
+            adaptive_min_samples = std::max(2, adaptive_min_samples);
+            adaptive_max_samples = std::max(adaptive_min_samples, adaptive_max_samples);
+            enable_adaptive_aa = true;
+            std::cout << "Adaptive antialiasing enabled: " << adaptive_min_samples << " to " << adaptive_max_samples
+                      << " samples/pixel, threshold " << adaptive_threshold << "." << std::endl;
+        } else {
+            std::cerr << "Error: --aa-adaptive flag requires <min> <max> <threshold> (e.g., --aa-adaptive 4 64 0.01)." << std::endl;
+            exit(1);
+        }
+    };
+
+    // handler for '--progressive' flag, with a target sample count and an optional time limit.
+    arg_handlers["--progressive"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc) {
+            try {
+                progressive_samples = std::max(1, std::stoi(argv[i + 1]));
+                i++;
+                // the time limit is optional, so only a following number is consumed.
+                if (i + 1 < argc && argv[i + 1][0] != '-') {
+                    progressive_time_limit = std::stod(argv[i + 1]);
+                    i++;
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid values for --progressive flag. Expected <samples> [seconds]." << std::endl;
+                exit(1);
+            }
+            enable_progressive = true;
+            std::cout << "Progressive rendering enabled: up to " << progressive_samples << " samples/pixel";
+            if (progressive_time_limit > 0.0) std::cout << " or " << progressive_time_limit << " seconds";
+            std::cout << "." << std::endl;
+        } else {
+            std::cerr << "Error: --progressive flag requires a number of samples (e.g., --progressive 64 30)." << std::endl;
+            exit(1);
+        }
+    };
+
+    // handler for '--sampler' flag.
+    arg_handlers["--sampler"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc && parse_sampler_type(argv[i + 1], sampler_type)) {
+            std::cout << "Sampler: " << argv[i + 1] << std::endl;
+            i++;
+        } else {
+            std::cerr << "Error: --sampler flag requires one of random, stratified, sobol or bluenoise." << std::endl;
+            exit(1);
+        }
+    };
+
+    // handler for '--frame' flag.
+    arg_handlers["--frame"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc) {
+            try {
+                frame_number = std::max(0, std::stoi(argv[i + 1]));
+                i++;
+                std::cout << "Frame: " << frame_number << std::endl;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid value for --frame flag. Must be an integer." << std::endl;
+                exit(1);
+            }
+        } else {
+            std::cerr << "Error: --frame flag requires a frame number." << std::endl;
+            exit(1);
+        }
+    };
+
     // handler for '--exposure' flag.
     arg_handlers["--exposure"] = [&](int& i, int argc, char* argv[]) {
         if (i + 1 < argc) {
@@ -159,6 +288,39 @@ int main(int argc, char* argv[]) {
         std::cout << "Parallel rendering enabled" << std::endl;
     };
 
+    // handler for '--batch' flag, which renders every frame of a job list.
+    arg_handlers["--batch"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc) {
+            batch_path = argv[i + 1];
+            i++;
+        } else {
+            std::cerr << "Error: --batch flag requires a job list file (e.g., --batch ../../ASCII/frames.txt)." << std::endl;
+            exit(1);
+        }
+    };
+
+    // handler for '--coordinator' flag, which hands the tiles of each render out to worker processes.
+    arg_handlers["--coordinator"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc) {
+            coordinator_address = argv[i + 1];
+            i++;
+        } else {
+            std::cerr << "Error: --coordinator flag requires an address to listen on (e.g., --coordinator 0.0.0.0:7000 or unix:/tmp/render.sock)." << std::endl;
+            exit(1);
+        }
+    };
+
+    // handler for '--worker' flag, which renders tiles for the coordinator at the given address.
+    arg_handlers["--worker"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 1 < argc) {
+            worker_address = argv[i + 1];
+            i++;
+        } else {
+            std::cerr << "Error: --worker flag requires the coordinator's address (e.g., --worker 127.0.0.1:7000)." << std::endl;
+            exit(1);
+        }
+    };
+
     // handler for '--motion-blur' flag.
     arg_handlers["--motion-blur"] = [&](int& i, int argc, char* argv[]) {
         if (i + 1 < argc) {
@@ -188,6 +350,90 @@ int main(int argc, char* argv[]) {
         std::cout << "Debug: Rendering surface normals." << std::endl;
     };
 
+    // handler for '--tessellate' flag, which converts displaced shapes into triangle meshes at load time.
+    arg_handlers["--tessellate"] = [&](int& i, int argc, char* argv[]) {
+        enable_tessellation = true;
+        std::cout << "Displacement pre-tessellation enabled." << std::endl;
+    };
+
+    // handler for '--virtual-bvh' flag, which uses the pointer-based bvh with virtual intersection calls.
+    arg_handlers["--virtual-bvh"] = [&](int& i, int argc, char* argv[]) {
+        use_virtual_bvh = true;
+        std::cout << "Virtual shape dispatch enabled." << std::endl;
+    };
+
+    // handler for '--dispatch_testing' flag, which compares the per-type primitive bvh against the virtual bvh.
+    arg_handlers["--dispatch_testing"] = [&](int& i, int argc, char* argv[]) {
+        enable_dispatch_testing = true;
+        std::cout << "Dispatch testing mode enabled." << std::endl;
+    };
+
+    // handler for '--light-samples' flag, which picks a fixed number of lights per hit from a light bvh.
+    arg_handlers["--light-samples"] = [&](int& i, int argc, char* argv[]) {
+        light_samples = Config::Instance().getInt("render.light_samples", 4);
+        // the number of samples is optional.
+        if (i + 1 < argc && argv[i + 1][0] != '-') {
+            try {
+                light_samples = std::stoi(argv[i + 1]);
+                i++;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid value for --light-samples flag. Must be an integer." << std::endl;
+                exit(1);
+            }
+        }
+        light_samples = std::max(1, light_samples);
+        std::cout << "Light sampling enabled: " << light_samples << " lights per hit." << std::endl;
+    };
+
+    // handler for '--light-cull' flag, which skips lights whose falloff is below the cutoff using a light grid.
+    arg_handlers["--light-cull"] = [&](int& i, int argc, char* argv[]) {
+        enable_light_culling = true;
+        std::cout << "Light culling enabled" << std::endl;
+    };
+
+    // handler for '--roulette' flag, which randomly terminates weak secondary rays after 'render.roulette_depth' bounces.
+    arg_handlers["--roulette"] = [&](int& i, int argc, char* argv[]) {
+        enable_roulette = true;
+        std::cout << "Russian roulette enabled" << std::endl;
+    };
+
+    // handler for '--ray_benchmark' flag, which measures ray_colour throughput on pre-generated primary rays.
+    arg_handlers["--ray_benchmark"] = [&](int& i, int argc, char* argv[]) {
+        ray_benchmark_passes = 5;
+        // the number of passes is optional.
+        if (i + 1 < argc && argv[i + 1][0] != '-') {
+            try {
+                ray_benchmark_passes = std::max(1, std::stoi(argv[i + 1]));
+                i++;
+            } catch (const std::exception& e) {
+                std::cerr << "Error: Invalid value for --ray_benchmark flag. Must be an integer." << std::endl;
+                exit(1);
+            }
+        }
+        std::cout << "Ray benchmark enabled: " << ray_benchmark_passes << " passes." << std::endl;
+    };
+
+    // handler for '--compare' flag, which checks that two rendered images match within a tolerance.
+    arg_handlers["--compare"] = [&](int& i, int argc, char* argv[]) {
+        if (i + 2 < argc) {
+            compare_paths = {argv[i + 1], argv[i + 2]};
+            i += 2;
+            // the tolerance is optional.
+            if (i + 1 < argc && argv[i + 1][0] != '-') {
+                try {
+                    compare_tolerance = std::stod(argv[i + 1]);
+                    i++;
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Invalid tolerance for --compare." << std::endl;
+                    exit(1);
+                }
+            }
+        } else {
+            std::cerr << "Error: --compare requires two image paths." << std::endl;
+            exit(1);
+        }
+    };
+
     // handler for '--bvh_testing' flag.
     arg_handlers["--bvh_testing"] = [&](int& i, int argc, char* argv[]) {
         enable_bvh_testing = true;
@@ -215,25 +461,208 @@ int main(int argc, char* argv[]) {
         }
     };
 
-    // parse command-line arguments.
-    for (int i = 1; i < argc; ++i) {
-        std::string arg = argv[i];
-        // check if a handler exists for the current argument.
-        if (arg_handlers.count(arg)) {
-            // call the handler.
-            arg_handlers[arg](i, argc, argv);
+    // parses command-line arguments. a worker also parses the arguments of the coordinator it renders for.
+    auto parse_args = [&](int count, char* values[]) {
+        for (int i = 1; i < count; ++i) {
+            std::string arg = values[i];
+            // check if a handler exists for the current argument.
+            if (arg_handlers.count(arg)) {
+                // call the handler.
+                arg_handlers[arg](i, count, values);
+            }
         }
+    };
+    parse_args(argc, argv);
+
+    if (!coordinator_address.empty() && !worker_address.empty()) {
+        std::cerr << "Error: --coordinator and --worker cannot be used together." << std::endl;
+        return 1;
+    }
+    if (!coordinator_address.empty() && enable_progressive) {
+        std::cerr << "Error: --progressive cannot be used with --coordinator." << std::endl;
+        return 1;
     }
 
-    // Encapsulated rendering logic used by both standard and test modes
-    auto render_scene_func = [&](const std::string& scene_path, bool current_use_bvh, const std::string& output_path) -> double {
-        auto start_time = std::chrono::high_resolution_clock::now();
+    // image comparison mode. used to check that a render matches a reference, e.g. the float build against the double build.
+    if (!compare_paths.empty()) {
+        try {
+            Image image_a(compare_paths[0]);
+            Image image_b(compare_paths[1]);
+            if (image_a.getWidth() != image_b.getWidth() || image_a.getHeight() != image_b.getHeight()) {
+                std::cerr << "Images have different sizes." << std::endl;
+                return 1;
+            }
+
+            // accumulates the per-channel differences over every pixel.
+            double total_difference = 0.0;
+            int max_difference = 0;
+            long long differing_pixels = 0;
+            for (int y = 0; y < image_a.getHeight(); ++y) {
+                for (int x = 0; x < image_a.getWidth(); ++x) {
+                    Pixel a = image_a.getPixel(x, y);
+                    Pixel b = image_b.getPixel(x, y);
+                    int pixel_difference = std::max({std::abs(a.r - b.r), std::abs(a.g - b.g), std::abs(a.b - b.b)});
+                    total_difference += std::abs(a.r - b.r) + std::abs(a.g - b.g) + std::abs(a.b - b.b);
+                    max_difference = std::max(max_difference, pixel_difference);
+                    // counts pixels that differ by more than a few levels in any channel.
+                    if (pixel_difference > 8) differing_pixels++;
+                }
+            }
 
-        std::cout << "Loading scene: " << scene_path << (current_use_bvh ? " [BVH ON]" : " [BVH OFF]") << std::endl;
+            long long pixel_count = static_cast<long long>(image_a.getWidth()) * image_a.getHeight();
+            // equation: mean = total_difference / (3 * pixel_count)
+            double mean_difference = total_difference / (3.0 * pixel_count);
+            std::cout << "Mean absolute difference: " << mean_difference << " (tolerance " << compare_tolerance << ")" << std::endl;
+            std::cout << "Max channel difference: " << max_difference << std::endl;
+            std::cout << "Pixels differing by more than 8: " << (100.0 * differing_pixels / pixel_count) << "%" << std::endl;
+
+            bool match = mean_difference <= compare_tolerance;
+            std::cout << (match ? "Images match." : "Images differ.") << std::endl;
+            return match ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error comparing images: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // ray_colour microbenchmark. the scene is loaded once and one primary ray per pixel centre is generated up front,
+    // so each pass times only the tracing and shading of the same rays on a single thread.
+    if (ray_benchmark_passes > 0) {
+        try {
+            Scene scene("../../ASCII/scene.txt", use_bvh, exposure, enable_shadows, glossy_samples, shutter_time, enable_fresnel, render_normals, enable_tessellation, use_virtual_bvh, light_samples, enable_light_culling, enable_roulette);
+            const Camera& camera = scene.getCamera();
+            const HittableList& world = scene.getWorld();
+            const int width = camera.getResolutionX();
+            const int height = camera.getResolutionY();
+            const int MAX_DEPTH = Config::Instance().getInt("settings.max_bounces", 10);
+
+            std::vector<Ray> rays;
+            rays.reserve(static_cast<size_t>(width) * height);
+            for (int y = 0; y < height; ++y) {
+                for (int x = 0; x < width; ++x) {
+                    rays.push_back(camera.generateRay((x + 0.5f) / width, (y + 0.5f) / height, 0.0));
+                }
+            }
+
+            #ifdef B216602_SIMD_ENABLED
+            const char* vector_math = "simd";
+            #else
+            const char* vector_math = "scalar";
+            #endif
+            std::cout << "Tracing " << rays.size() << " primary rays per pass (" << vector_math << " vector maths, "
+                      << sizeof(Vector3) << " bytes per vector)." << std::endl;
+
+            // the checksum keeps the results live and shows whether two builds shade the rays the same way.
+            double best_time = std::numeric_limits<double>::infinity();
+            double checksum = 0.0;
+            for (int pass = 0; pass < ray_benchmark_passes; ++pass) {
+                Vector3 sum(0, 0, 0);
+                auto start_time = std::chrono::high_resolution_clock::now();
+                for (const Ray& ray : rays) {
+                    sum = sum + ray_colour(ray, scene, world, MAX_DEPTH);
+                }
+                std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start_time;
+                checksum = sum.x + sum.y + sum.z;
+                best_time = std::min(best_time, elapsed.count());
+                std::cout << "Pass " << (pass + 1) << ": " << elapsed.count() << "s, "
+                          << rays.size() / elapsed.count() / 1e6 << " Mrays/s" << std::endl;
+            }
+
+            std::cout << "Best pass: " << best_time << "s, " << rays.size() / best_time / 1e6 << " Mrays/s" << std::endl;
+            // formatted on its own stream, so the precision does not carry over to later output.
+            std::ostringstream checksum_text;
+            checksum_text << std::setprecision(10) << checksum;
+            std::cout << "Checksum: " << checksum_text.str() << std::endl;
+        } catch (const std::exception& e) {
+            std::cerr << "Error during ray benchmark: " << e.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // with --parallel, renders on every hardware thread unless the config sets a thread count.
+    auto render_thread_count = [&]() -> int {
+        int threads = 1;
+        if (enable_parallel) {
+            threads = Config::Instance().getInt("render.threads", 0);
+            if (threads <= 0) {
+                threads = std::max(1u, std::thread::hardware_concurrency());
+            }
+        }
+        return threads;
+    };
+
+    // set when --coordinator is given, to hand the tiles of each standard render to the workers,
+    // along with the command line the workers render with.
+    std::unique_ptr<TileCoordinator> coordinator;
+    std::vector<std::string> coordinator_args;
+    // set while this process is a worker rendering a job: the connection to the coordinator and the job's id.
+    Socket* worker_connection = nullptr;
+    uint32_t worker_job_id = 0;
+    bool worker_connection_lost = false;
+    // set when the coordinator told the worker to shut down while it was rendering a job.
+    bool worker_shutdown = false;
+    // the scene of the last render, which a worker keeps loaded between jobs, with the file and settings it came from.
+    std::unique_ptr<Scene> loaded_scene;
+    std::string loaded_scene_key;
+
+    // describes a scene file as it was last modified, with the overrides applied to it,
+    // so a scene already loaded can be recognised.
+    auto scene_key = [&](const std::string& scene_path, bool build_bvh, const std::vector<SceneOverride>& overrides) -> std::string {
+        std::error_code modified_error;
+        auto modified = fs::last_write_time(scene_path, modified_error);
+        std::string key = scene_path + (build_bvh ? "|bvh|" : "|no-bvh|")
+                        + std::to_string(modified_error ? 0 : modified.time_since_epoch().count());
+        for (const SceneOverride& override : overrides) {
+            key += "|" + override.block + " " + std::to_string(override.index) + " " + override.key + " " + override.values;
+        }
+        return key;
+    };
+
+    // loads a scene, building a virtual BVH instead of the primitive one if virtual_bvh is set.
+    // may be called on a thread other than the one rendering, while another scene renders.
+    auto load_scene = [&](const std::string& scene_path, bool build_bvh, bool virtual_bvh, const std::vector<SceneOverride>& overrides) -> std::unique_ptr<Scene> {
+        std::cout << "Loading scene: " << scene_path << (build_bvh ? (virtual_bvh ? " [BVH ON, VIRTUAL]" : " [BVH ON]") : " [BVH OFF]") << std::endl;
+
+        // on a multi-socket machine, the scene can be spread over every node's memory while it loads,
+        // so the threads on each socket share the cost of reading it instead of one socket serving them all.
+        std::optional<MemoryInterleaveScope> interleave;
+        if (enable_parallel && Config::Instance().getBool("render.numa_interleave", false)) {
+            const NumaTopology topology = detect_numa_topology();
+            interleave.emplace(topology);
+            if (interleave->active()) {
+                std::cout << "Interleaving scene memory across " << topology.node_ids.size() << " NUMA nodes." << std::endl;
+            }
+        }
 
         // initialises a scene. prepares the objects, materials, and object matrices in preparation for calculations.
-        Scene scene(scene_path, current_use_bvh, exposure, enable_shadows, glossy_samples, shutter_time, enable_fresnel, render_normals);
+        return std::make_unique<Scene>(scene_path, build_bvh, exposure, enable_shadows, glossy_samples, shutter_time, enable_fresnel, render_normals, enable_tessellation, virtual_bvh, light_samples, enable_light_culling, enable_roulette, overrides);
+    };
+
+    // the time and work of one render. 'total' is from the start time given to the render until the image is ready,
+    // 'render' covers only the rendering, and 'write' the time spent writing or queueing images after it.
+    // 'render_begin' and 'write_end' place the render on the same clock as the scene's load stages.
+    struct RenderTimes {
+        double total = 0.0;
+        double render = 0.0;
+        double write = 0.0;
+        std::chrono::steady_clock::time_point render_begin;
+        std::chrono::steady_clock::time_point write_end;
+        uint64_t samples = 0;
+        uint64_t rays = 0;
+    };
 
+    // renders a loaded scene and writes the image to output_path, unless it is empty. the scene's path, bvh setting
+    // and overrides are passed on to the workers of a coordinator. with an image writer, the images are written in
+    // the background. 'stream_output' writes the image while the tiles finish; benchmarks turn it off, so the
+    // write is timed on its own after the render.
+    auto render_loaded_scene = [&](const Scene& scene, const std::string& scene_path, bool current_use_bvh, const std::vector<SceneOverride>& overrides,
+                                   const std::string& output_path, std::chrono::high_resolution_clock::time_point start_time, AsyncImageWriter* image_writer,
+                                   bool stream_output) -> RenderTimes {
+        auto render_start = std::chrono::high_resolution_clock::now();
+        RenderTimes times;
+        times.render_begin = std::chrono::steady_clock::now();
+        const NumaTopology topology = detect_numa_topology();
         const Camera& camera = scene.getCamera();
         const HittableList& world = scene.getWorld();
 
@@ -248,118 +677,646 @@ int main(int argc, char* argv[]) {
         // maximum number of ray bounces for path tracing.
         const int MAX_DEPTH = Config::Instance().getInt("settings.max_bounces", 10);
 
-        std::cout << "Rendering scene (" << width << "x" << height << ") with "
-                    << SAMPLES_PER_PIXEL << " samples per pixel..." << std::endl;
+        if (enable_progressive) {
+            std::cout << "Rendering scene (" << width << "x" << height << ") progressively, one sample per pixel per pass..." << std::endl;
+        } else if (enable_adaptive_aa) {
+            std::cout << "Rendering scene (" << width << "x" << height << ") with "
+                        << adaptive_min_samples << " to " << adaptive_max_samples << " samples per pixel..." << std::endl;
+        } else {
+            std::cout << "Rendering scene (" << width << "x" << height << ") with "
+                        << SAMPLES_PER_PIXEL << " samples per pixel..." << std::endl;
+        }
 
-        int num_threads = 1;
+        const int num_threads = render_thread_count();
+        std::cout << "Number of threads: " << num_threads << std::endl;
 
-        // if compiled with openmp and --parallel flag is present, enable multi-threading.
-        #ifdef _OPENMP
-        if (!enable_parallel) {
-            // explicitly set to single-threaded if parallel is not requested.
-            omp_set_num_threads(1);
+        // the image is rendered in small tiles, handed out to the threads by a work-stealing pool.
+        // each worker keeps its own sampler and tile buffer for the whole render.
+        const int tile_size = std::max(1, Config::Instance().getInt("render.tile_size", 16));
+        const std::vector<Tile> tiles = make_tiles(width, height, tile_size);
+        WorkStealingPool pool(num_threads);
+        std::vector<std::unique_ptr<Sampler>> worker_samplers(num_threads);
+        // the pixels of each worker's current tile, copied into the image once the tile is finished.
+        std::vector<std::vector<Pixel>> tile_buffers(num_threads);
+        // the temporaries each worker allocates while tracing, reset at the start of every tile.
+        std::vector<std::unique_ptr<MonotonicArena>> scratch_arenas(num_threads);
+
+        // optionally pins each worker to a cpu, spread evenly over the numa nodes. the thread calling the pool
+        // is pinned only for this render. each worker then allocates its own sampler, tile buffer and scratch arena,
+        // so they are placed in memory local to it.
+        const bool pin_threads = enable_parallel && Config::Instance().getBool("render.pin_threads", false);
+        const std::vector<int> cpus = pin_threads ? worker_cpus(topology, num_threads) : std::vector<int>();
+        std::optional<CpuPinScope> caller_pin;
+        pool.runOnEachWorker([&](int worker) {
+            if (!cpus.empty()) {
+                if (worker == 0) {
+                    caller_pin.emplace(cpus[0]);
+                } else {
+                    pin_current_thread(cpus[worker]);
+                }
+            }
+            worker_samplers[worker] = make_sampler(sampler_type, static_cast<uint32_t>(frame_number));
+            tile_buffers[worker].assign(static_cast<size_t>(tile_size) * tile_size, Pixel{0, 0, 0});
+            scratch_arenas[worker] = std::make_unique<MonotonicArena>();
+        });
+        if (!cpus.empty()) {
+            std::cout << "Pinned " << num_threads << " threads across " << topology.node_cpus.size() << " NUMA node(s)." << std::endl;
         }
-        // get the number of threads that will be used.
-        num_threads = omp_get_max_threads();
-        std::cout << "Number of threads: " << num_threads << std::endl;
 
-        #else
-                    if (enable_parallel) {
-                        std::cout << "Warning: --parallel flag ignored. Program was not compiled with OpenMP." << std::endl;
+        // traces sample 'index' of the 'count' samples of pixel (x, y) and returns its colour.
+        // the calling thread must have a sampler installed, which provides the jitter, time and lens position.
+        auto trace_sample = [&](int x, int y, int index, int count) -> Vector3 {
+            Sampler* sampler = thread_sampler();
+            sampler->startPixelSample(x, y, static_cast<uint32_t>(index), static_cast<uint32_t>(count));
+
+            // generate an offset within the pixel for anti-aliasing.
+            double jitter_u, jitter_v;
+            sampler->get2D(SAMPLE_DIM_PIXEL, jitter_u, jitter_v);
+
+            // calculate the normalized (u,v) coordinate for the ray, with jitter.
+            float px = (static_cast<float>(x) + static_cast<float>(jitter_u)) / width;
+            float py = (static_cast<float>(y) + static_cast<float>(jitter_v)) / height;
+
+            // calculate a time for the ray for motion blur.
+            double ray_time = sampler->get1D(SAMPLE_DIM_TIME) * scene.get_shutter_time();
+
+            // generate a ray for the current sample. defines the origin, direction and time, and the point on the lens.
+            double lens_u, lens_v;
+            sampler->get2D(SAMPLE_DIM_LENS, lens_u, lens_v);
+            Ray ray = camera.generateRay(px, py, ray_time, lens_u, lens_v);
+
+            // trace the ray and return the resulting color.
+            return ray_colour(ray, scene, world, MAX_DEPTH);
+        };
+
+        // applies the selected tonemapping to a pixel's averaged colour and converts it to 8-bit.
+        auto resolve_pixel = [&](Vector3 averaged_color_vec) -> Pixel {
+            if (tonemap_mode == 1) {
+                averaged_color_vec = tonemap_reinhard(averaged_color_vec);
+            } else if (tonemap_mode == 2) {
+                averaged_color_vec = tonemap_aces(averaged_color_vec);
+            } else if (tonemap_mode == 3) {
+                averaged_color_vec = tonemap_filmic(averaged_color_vec);
+            }
+            return final_colour_to_pixel(averaged_color_vec);
+        };
+
+        if (enable_progressive) {
+            // renders passes of one sample per pixel into a floating point accumulation buffer, so the running average
+            // can be written out at any point. the current estimate is saved every few seconds or passes, and the render
+            // stops at the target sample count, at the time limit, or after the pass in progress when interrupted.
+            FirstTouchArray<Vector3> accumulation(static_cast<size_t>(width) * height);
+            // each worker clears the pixels of the tiles it starts with, so those pages are placed on its own node.
+            // the buffer is read and written on every pass, so this keeps most of those accesses local.
+            pool.runOnEachWorker([&](int worker) {
+                uint32_t first, last;
+                pool.initialShare(static_cast<uint32_t>(tiles.size()), worker, first, last);
+                for (uint32_t t = first; t < last; ++t) {
+                    for (int y = tiles[t].y0; y < tiles[t].y1; ++y) {
+                        for (int x = tiles[t].x0; x < tiles[t].x1; ++x) {
+                            accumulation.initialise(static_cast<size_t>(y) * width + x, Vector3(0, 0, 0));
+                        }
                     }
-        #endif
-
-        // atomic counter for tracking progress across threads.
-        std::atomic<int> scanlines_completed(0);
-        int total_scanlines = height;
-        int last_reported_progress = -1;
-
-        // openmp pragma to parallelize the outer loop over scanlines.
-        #ifdef _OPENMP
-        #pragma omp parallel for schedule(dynamic, 10)
-        #endif
-        for (int y = 0; y < height; ++y) {
-            // for every pixel in the current scanline.
-            for (int x = 0; x < width; ++x) {
-                // initialises the colour accumulator for the pixel.
-                Vector3 pixel_color_vec(0, 0, 0);
-
-                // anti-aliasing loop: cast multiple rays per pixel.
-                for (int s = 0; s < SAMPLES_PER_PIXEL; ++s) {
-
-                    // generate a random offset within the pixel for anti-aliasing.
-                    float random_u = random_double();
-                    float random_v = random_double();
-
-                    // calculate the normalized (u,v) coordinate for the ray, with random jitter.
-                    float px = (static_cast<float>(x) + random_u) / width;
-                    float py = (static_cast<float>(y) + random_v) / height;
-
-                    // calculate a random time for the ray for motion blur.
-                    double ray_time = random_double() * scene.get_shutter_time();
-
-                    // generate a ray for the current sample. defines the origin, direction and time.
-                    Ray ray = camera.generateRay(px, py, ray_time);
-
-                    // trace the ray and accumulate the resulting color.
-                    pixel_color_vec = pixel_color_vec + ray_colour(ray, scene, world, MAX_DEPTH);
-                }
-                // calculate the average color from all samples for the pixel.
-                Vector3 averaged_color_vec = pixel_color_vec * (1.0 / SAMPLES_PER_PIXEL);
-                // apply tonemapping
-                if (tonemap_mode == 1) {
-                    averaged_color_vec = tonemap_reinhard(averaged_color_vec);
-                } else if (tonemap_mode == 2) {
-                    averaged_color_vec = tonemap_aces(averaged_color_vec);
-                } else if (tonemap_mode == 3) {
-                    averaged_color_vec = tonemap_filmic(averaged_color_vec);
-                }
-                // convert the final vector color to a pixel format (e.g., 8-bit rgb).
-                Pixel final_color = final_colour_to_pixel(averaged_color_vec);
-                // set the pixel color in the image buffer.
-                image.setPixel(x, y, final_color);
-
-            }
-            // progress reporting logic.
-            #ifdef _OPENMP
-            // only thread 0 reports progress to avoid garbled output.
-            if (omp_get_thread_num() == 0) {
-            #endif
-                // atomically increment the completed scanlines counter.
-                int completed = scanlines_completed.fetch_add(1) + 1;
-                // calculate the percentage of completion.
-                int percent = (static_cast<long long>(completed) * 100) / total_scanlines;
-                // report progress every 5% or on completion.
-                if (percent > last_reported_progress && (percent % 5 == 0 || completed == total_scanlines)) {
-                    last_reported_progress = percent;
-                    std::stringstream ss;
-                    // build the progress string.
-                    ss << "\rRendering: " << percent << "% [" << completed << "/" << total_scanlines << "]";
-                    // add a newline on completion.
-                    if (completed == total_scanlines) ss << std::endl;
-                    // print the progress string to the console.
-                    std::cout << ss.str() << std::flush;
-                }
-            #ifdef _OPENMP
-            } else {
-                scanlines_completed.fetch_add(1);
+                }
+            });
+            const double refresh_seconds = Config::Instance().getDouble("render.progressive_refresh_seconds", 5.0);
+            const int refresh_passes = Config::Instance().getInt("render.progressive_refresh_passes", 0);
+
+            // writes the average of the passes so far to the output image.
+            auto write_estimate = [&](int passes) {
+                double inverse = 1.0 / passes;
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        image.setPixel(x, y, resolve_pixel(accumulation[static_cast<size_t>(y) * width + x] * inverse));
+                    }
+                }
+                if (!output_path.empty()) {
+                    image.write(output_path);
+                }
+            };
+
+            g_stop_requested = 0;
+            auto previous_handler = std::signal(SIGINT, request_stop);
+
+            int passes = 0;
+            int passes_at_last_write = 0;
+            auto last_write = std::chrono::high_resolution_clock::now();
+            while (passes < progressive_samples) {
+                // the tiles cover separate pixels, so each adds straight into its part of the accumulation buffer.
+                pool.run(static_cast<uint32_t>(tiles.size()), [&](uint32_t tile_index, int worker) {
+                    const Tile& tile = tiles[tile_index];
+                    SamplerScope sampler_scope(worker_samplers[worker].get());
+                    ScratchArenaScope scratch_scope(scratch_arenas[worker].get());
+                    for (int y = tile.y0; y < tile.y1; ++y) {
+                        for (int x = tile.x0; x < tile.x1; ++x) {
+                            Vector3& sum = accumulation[static_cast<size_t>(y) * width + x];
+                            sum = sum + trace_sample(x, y, passes, progressive_samples);
+                        }
+                    }
+                });
+                passes++;
+
+                auto now = std::chrono::high_resolution_clock::now();
+                double elapsed_total = std::chrono::duration<double>(now - start_time).count();
+                // formatted on its own stream, so the precision does not carry over to later output.
+                std::ostringstream elapsed_text;
+                elapsed_text << std::fixed << std::setprecision(1) << elapsed_total;
+                std::cout << "\rProgressive: pass " << passes << "/" << progressive_samples << " ("
+                          << elapsed_text.str() << "s)" << std::flush;
+
+                bool out_of_time = progressive_time_limit > 0.0 && elapsed_total >= progressive_time_limit;
+                if (g_stop_requested || out_of_time || passes == progressive_samples) {
+                    break;
+                }
+                // saves the estimate when either refresh interval has passed.
+                bool time_due = refresh_seconds > 0.0 && std::chrono::duration<double>(now - last_write).count() >= refresh_seconds;
+                bool passes_due = refresh_passes > 0 && passes - passes_at_last_write >= refresh_passes;
+                if (time_due || passes_due) {
+                    write_estimate(passes);
+                    passes_at_last_write = passes;
+                    last_write = now;
+                }
             }
-            #endif
+            std::cout << std::endl;
+            std::signal(SIGINT, previous_handler);
+            if (g_stop_requested) {
+                std::cout << "Interrupted: stopping after " << passes << " passes." << std::endl;
+            }
+
+            auto write_start = std::chrono::high_resolution_clock::now();
+            write_estimate(passes);
+            auto end_time = std::chrono::high_resolution_clock::now();
+            times.write_end = std::chrono::steady_clock::now();
+            if (!output_path.empty()) {
+                std::cout << "Image saved to '" << output_path << "' with " << passes << " samples per pixel." << std::endl;
+            }
+            times.total = std::chrono::duration<double>(end_time - start_time).count();
+            times.render = std::chrono::duration<double>(write_start - render_start).count();
+            times.write = std::chrono::duration<double>(end_time - write_start).count();
+            times.samples = static_cast<uint64_t>(passes) * width * height;
+            return times;
+        }
+
+        // the number of samples each pixel took, kept for the heatmap when sampling adaptively.
+        std::vector<int> sample_counts;
+        if (enable_adaptive_aa) {
+            sample_counts.assign(static_cast<size_t>(width) * height, 0);
+        }
+
+        // renders a tile into the worker's tile buffer, row by row, and returns the number of samples it took.
+        // each worker draws from its own sampler and scratch arena, installed for the tile.
+        auto render_tile = [&](const Tile& tile, int worker) -> uint64_t {
+            std::vector<Pixel>& tile_buffer = tile_buffers[worker];
+            SamplerScope sampler_scope(worker_samplers[worker].get());
+            ScratchArenaScope scratch_scope(scratch_arenas[worker].get());
+            uint64_t tile_samples = 0;
+            for (int y = tile.y0; y < tile.y1; ++y) {
+                // for every pixel in the current row of the tile.
+                for (int x = tile.x0; x < tile.x1; ++x) {
+                    // initialises the colour accumulator for the pixel.
+                    Vector3 pixel_color_vec(0, 0, 0);
+                    int samples_taken = 0;
+
+                    if (enable_adaptive_aa) {
+                        // samples the pixel in batches of the minimum count, stopping once the standard error of its mean
+                        // luminance falls below the threshold. luminance is clamped to the displayable range first,
+                        // so a pixel that is brighter than white in every sample counts as converged.
+                        // the running mean and squared deviations are updated with welford's method.
+                        // equation: error = sqrt(m2 / ((n - 1) * n))
+                        double mean = 0.0;
+                        double m2 = 0.0;
+                        while (samples_taken < adaptive_max_samples) {
+                            int batch = std::min(adaptive_min_samples, adaptive_max_samples - samples_taken);
+                            for (int s = 0; s < batch; ++s) {
+                                Vector3 sample = trace_sample(x, y, samples_taken, adaptive_max_samples);
+                                pixel_color_vec = pixel_color_vec + sample;
+                                samples_taken++;
+                                double luminance = std::min(1.0, 0.2126 * sample.x + 0.7152 * sample.y + 0.0722 * sample.z);
+                                double delta = luminance - mean;
+                                mean += delta / samples_taken;
+                                m2 += delta * (luminance - mean);
+                            }
+                            double error = std::sqrt(m2 / ((samples_taken - 1.0) * samples_taken));
+                            if (error <= adaptive_threshold) {
+                                break;
+                            }
+                        }
+                        sample_counts[static_cast<size_t>(y) * width + x] = samples_taken;
+                    } else {
+                        // anti-aliasing loop: cast multiple rays per pixel.
+                        for (int s = 0; s < SAMPLES_PER_PIXEL; ++s) {
+                            pixel_color_vec = pixel_color_vec + trace_sample(x, y, s, SAMPLES_PER_PIXEL);
+                        }
+                        samples_taken = SAMPLES_PER_PIXEL;
+                    }
+                    // calculate the average color from all samples for the pixel.
+                    Vector3 averaged_color_vec = pixel_color_vec * (1.0 / samples_taken);
+                    // apply tonemapping and convert the final vector color to a pixel format (e.g., 8-bit rgb).
+                    Pixel final_color = resolve_pixel(averaged_color_vec);
+                    tile_samples += samples_taken;
+                    // store the pixel in the worker's tile buffer.
+                    tile_buffer[static_cast<size_t>(y - tile.y0) * tile.width() + (x - tile.x0)] = final_color;
+                }
+            }
+            return tile_samples;
+        };
+
+        if (worker_connection) {
+            // renders tiles for the coordinator until it finishes the job. each batch of tiles received is split
+            // into tiles of the usual size, so all of this worker's threads share it.
+            MessageWriter ready;
+            ready.u32(worker_job_id);
+            if (!send_message(*worker_connection, MSG_READY, ready)) {
+                worker_shutdown = received_shutdown(*worker_connection);
+                worker_connection_lost = true;
+                return times;
+            }
+            std::vector<ProgressCounters> worker_counters(num_threads);
+            std::vector<TileRequest> batch;
+            bool done = false;
+            bool shutdown = false;
+            while (receive_tile_batch(*worker_connection, batch, done, shutdown)) {
+                if (done) {
+                    worker_shutdown = shutdown;
+                    times.total = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start_time).count();
+                    return times;
+                }
+
+                std::vector<TileResult> results(batch.size());
+                // the pieces each requested tile is split into: the index of the request and the piece's pixels.
+                std::vector<std::pair<size_t, Tile>> pieces;
+                for (size_t b = 0; b < batch.size(); ++b) {
+                    const Tile& tile = batch[b].tile;
+                    if (tile.x0 < 0 || tile.y0 < 0 || tile.x1 > width || tile.y1 > height || tile.x0 >= tile.x1 || tile.y0 >= tile.y1) {
+                        std::cerr << "Error: The coordinator sent a tile outside the " << width << "x" << height << " image." << std::endl;
+                        worker_connection_lost = true;
+                        return times;
+                    }
+                    results[b].job = batch[b].job;
+                    results[b].tile_index = batch[b].tile_index;
+                    results[b].pixels.resize(static_cast<size_t>(tile.width()) * tile.height());
+                    results[b].sample_counts.resize(results[b].pixels.size());
+                    for (const Tile& piece : make_tiles(tile.width(), tile.height(), tile_size)) {
+                        pieces.push_back({b, Tile{tile.x0 + piece.x0, tile.y0 + piece.y0, tile.x0 + piece.x1, tile.y0 + piece.y1}});
+                    }
+                }
+
+                std::vector<uint64_t> piece_samples(pieces.size());
+                std::vector<uint64_t> piece_rays(pieces.size());
+                pool.run(static_cast<uint32_t>(pieces.size()), [&](uint32_t piece_index, int worker) {
+                    const Tile& piece = pieces[piece_index].second;
+                    TileResult& result = results[pieces[piece_index].first];
+                    const Tile& tile = batch[pieces[piece_index].first].tile;
+                    ProgressScope progress_scope(&worker_counters[worker]);
+                    uint64_t rays_before = worker_counters[worker].rays.load(std::memory_order_relaxed);
+                    piece_samples[piece_index] = render_tile(piece, worker);
+                    piece_rays[piece_index] = worker_counters[worker].rays.load(std::memory_order_relaxed) - rays_before;
+
+                    // copies the piece into its place in the requested tile.
+                    for (int y = piece.y0; y < piece.y1; ++y) {
+                        size_t row = static_cast<size_t>(y - tile.y0) * tile.width() + (piece.x0 - tile.x0);
+                        std::copy_n(tile_buffers[worker].data() + static_cast<size_t>(y - piece.y0) * piece.width(), piece.width(), result.pixels.data() + row);
+                        for (int x = piece.x0; x < piece.x1; ++x) {
+                            result.sample_counts[row + (x - piece.x0)] = enable_adaptive_aa
+                                ? static_cast<uint32_t>(sample_counts[static_cast<size_t>(y) * width + x])
+                                : static_cast<uint32_t>(SAMPLES_PER_PIXEL);
+                        }
+                    }
+                });
+
+                for (size_t p = 0; p < pieces.size(); ++p) {
+                    results[pieces[p].first].samples += piece_samples[p];
+                    results[pieces[p].first].rays += piece_rays[p];
+                }
+                for (const TileResult& result : results) {
+                    MessageWriter writer;
+                    write_tile_result(writer, result);
+                    if (!send_message(*worker_connection, MSG_RESULT, writer)) {
+                        // the coordinator may have finished while this worker rendered a tile another worker also had.
+                        worker_shutdown = received_shutdown(*worker_connection);
+                        worker_connection_lost = true;
+                        return times;
+                    }
+                }
+            }
+            worker_connection_lost = true;
+            return times;
         }
 
+        // the workers count their pixels, samples and rays, which a separate thread reports while they render.
+        ProgressReporter progress(num_threads, static_cast<uint64_t>(width) * height,
+                                  Config::Instance().getDouble("render.progress_interval", 1.0));
+
+        // without a writer thread, the image is written a band of rows at a time as the tiles finish.
+        std::optional<StreamingImageWriter> stream;
+        if (!output_path.empty() && !image_writer && stream_output) {
+            stream.emplace(image, output_path);
+        }
+
+        if (coordinator) {
+            // the workers render larger tiles than the local threads, so each message carries enough work
+            // to hide the round trip. the results are copied into the image as they arrive.
+            RenderJob job;
+            job.scene_path = scene_path;
+            job.use_bvh = current_use_bvh;
+            job.args = coordinator_args;
+            job.frame_number = static_cast<uint32_t>(frame_number);
+            job.overrides = overrides;
+            const std::vector<Tile> distributed_tiles = make_tiles(width, height, std::max(1, Config::Instance().getInt("render.distributed_tile_size", 64)));
+            ProgressCounters& counters = progress.counters(0);
+            coordinator->render(job, distributed_tiles, [&](const TileResult& result) {
+                const Tile& tile = distributed_tiles[result.tile_index];
+                image.setBlock(tile.x0, tile.y0, tile.width(), tile.height(), result.pixels.data());
+                if (enable_adaptive_aa) {
+                    for (int y = tile.y0; y < tile.y1; ++y) {
+                        for (int x = tile.x0; x < tile.x1; ++x) {
+                            sample_counts[static_cast<size_t>(y) * width + x] = static_cast<int>(result.sample_counts[static_cast<size_t>(y - tile.y0) * tile.width() + (x - tile.x0)]);
+                        }
+                    }
+                }
+                if (stream) {
+                    stream->blockFinished(tile.x0, tile.y0, tile.x1, tile.y1);
+                }
+                add_count(counters.pixels, static_cast<uint64_t>(tile.width()) * tile.height());
+                add_count(counters.samples, result.samples);
+                add_count(counters.rays, result.rays);
+            });
+        } else {
+            pool.run(static_cast<uint32_t>(tiles.size()), [&](uint32_t tile_index, int worker) {
+                const Tile& tile = tiles[tile_index];
+                // each worker counts into its own counters, installed for the tile.
+                ProgressCounters& counters = progress.counters(worker);
+                ProgressScope progress_scope(&counters);
+                uint64_t allocations_before = thread_allocation_count();
+                uint64_t tile_samples = render_tile(tile, worker);
+                add_count(counters.allocations, thread_allocation_count() - allocations_before);
+                image.setBlock(tile.x0, tile.y0, tile.width(), tile.height(), tile_buffers[worker].data());
+                if (stream) {
+                    stream->blockFinished(tile.x0, tile.y0, tile.x1, tile.y1);
+                }
+
+                add_count(counters.pixels, static_cast<uint64_t>(tile.width()) * tile.height());
+                add_count(counters.samples, tile_samples);
+            });
+        }
+        progress.finish();
+
         auto end_time = std::chrono::high_resolution_clock::now();
-        std::chrono::duration<double> elapsed = end_time - start_time;
+        times.total = std::chrono::duration<double>(end_time - start_time).count();
+        times.render = std::chrono::duration<double>(end_time - render_start).count();
+        times.samples = progress.totals().samples;
+        times.rays = progress.totals().rays;
+        if (allocation_counting_enabled() && !coordinator) {
+            std::cout << "Heap allocations while rendering tiles: " << progress.totals().allocations << std::endl;
+        }
 
-        if (!output_path.empty()) {
-            image.write(output_path);
+        // writes an image, or hands it to the writer thread when there is one.
+        auto save_image = [&](Image& target, const std::string& path, const std::string& description) {
+            if (image_writer) {
+                image_writer->write(std::move(target), path);
+                std::cout << description << " queued for writing to '" << path << "'." << std::endl;
+            } else {
+                target.write(path);
+                std::cout << description << " saved to '" << path << "'." << std::endl;
+            }
+        };
+
+        auto write_start = std::chrono::high_resolution_clock::now();
+        if (stream) {
+            // only the rows of the last tiles are left to write.
+            stream->finish();
             std::cout << "Image saved to '" << output_path << "'." << std::endl;
+        } else if (!output_path.empty()) {
+            save_image(image, output_path, "Image");
         }
 
-        return elapsed.count();
+        if (enable_adaptive_aa) {
+            long long total_samples = std::accumulate(sample_counts.begin(), sample_counts.end(), 0LL);
+            // formatted on its own stream, so the precision does not carry over to later output.
+            std::ostringstream average;
+            average << std::fixed << std::setprecision(2) << static_cast<double>(total_samples) / sample_counts.size();
+            std::cout << "Adaptive antialiasing: " << average.str() << " samples/pixel on average." << std::endl;
+
+            if (!output_path.empty()) {
+                // writes a heatmap of the sample counts next to the image, from blue at the minimum through green to red at the maximum.
+                Image heatmap(width, height);
+                double range = std::max(1, adaptive_max_samples - adaptive_min_samples);
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        double t = (sample_counts[static_cast<size_t>(y) * width + x] - adaptive_min_samples) / range;
+                        Vector3 heat(std::max(0.0, 2.0 * t - 1.0), 1.0 - std::abs(2.0 * t - 1.0), std::max(0.0, 1.0 - 2.0 * t));
+                        heatmap.setPixel(x, y, final_colour_to_pixel(heat));
+                    }
+                }
+                fs::path heatmap_path(output_path);
+                heatmap_path.replace_filename(heatmap_path.stem().string() + "_samples" + heatmap_path.extension().string());
+                save_image(heatmap, heatmap_path.string(), "Sample heatmap");
+            }
+        }
+
+        times.write = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - write_start).count();
+        times.write_end = std::chrono::steady_clock::now();
+        return times;
+    };
+
+    // Encapsulated rendering logic used by both standard and test modes
+    auto render_scene_func = [&](const std::string& scene_path, bool current_use_bvh, const std::vector<SceneOverride>& overrides, const std::string& output_path) -> RenderTimes {
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        // a worker reuses its scene while the file and overrides are unchanged. the coordinator only needs
+        // the resolution, so it loads the scene without building a BVH.
+        const bool build_bvh = current_use_bvh && !coordinator;
+        const std::string key = scene_key(scene_path, build_bvh, overrides);
+        if (worker_connection && loaded_scene && loaded_scene_key == key) {
+            std::cout << "Reusing loaded scene: " << scene_path << std::endl;
+        } else {
+            // the previous scene is released first, so the two are not held in memory at once.
+            loaded_scene.reset();
+            loaded_scene = load_scene(scene_path, build_bvh, use_virtual_bvh, overrides);
+            loaded_scene_key = key;
+        }
+        return render_loaded_scene(*loaded_scene, scene_path, current_use_bvh, overrides, output_path, start_time, nullptr, true);
+    };
+
+    // prints when each stage of loading and rendering a scene started and how long it took, in seconds from the
+    // start of loading. stages that overlap, such as decoding textures while the bvh builds, ran at the same time.
+    auto print_stage_timings = [&](const Scene& scene, const RenderTimes& times) {
+        auto since_load = [&](std::chrono::steady_clock::time_point point) {
+            return std::chrono::duration<double>(point - scene.load_start()).count();
+        };
+        std::vector<TaskTiming> stages = scene.load_timings();
+        stages.push_back(TaskTiming{"render", since_load(times.render_begin), times.render});
+        stages.push_back(TaskTiming{"write (after render)", since_load(times.write_end) - times.write, times.write});
+
+        size_t name_width = 0;
+        for (const TaskTiming& stage : stages) {
+            name_width = std::max(name_width, stage.name.size());
+        }
+        // formatted on its own stream, so the alignment and precision do not carry over to later output.
+        std::ostringstream table;
+        table << std::fixed << std::setprecision(4);
+        for (const TaskTiming& stage : stages) {
+            table << "  " << std::left << std::setw(static_cast<int>(name_width)) << stage.name << std::right
+                  << "  " << stage.start << " + " << stage.seconds << "\n";
+        }
+        std::cout << "\nStage timings (start + duration, seconds from the start of loading):\n" << table.str() << std::flush;
     };
 
-    // BVH testing
-    if (enable_bvh_testing) {
+    // the phases of a benchmark: loading its scene once, then rendering it several times.
+    struct BenchmarkResult {
+        double load = 0.0;
+        double parse = 0.0;
+        double bvh = 0.0;
+        std::vector<double> render_seconds;
+        TimingStats render;
+        double rays_per_second = 0.0;
+        double write = 0.0;
+    };
+
+    // loads a scene once, renders it untimed to warm up the caches, page tables and allocator, then times 'runs'
+    // renders of the same loaded scene, so the timings measure only the rendering. output_for(run) gives the image
+    // path of each timed run, or an empty path for none. the BVH is virtual if virtual_bvh is set.
+    auto benchmark_scene = [&](const std::string& scene_path, bool current_use_bvh, bool virtual_bvh, int runs, const std::function<std::string(int)>& output_for) -> BenchmarkResult {
+        BenchmarkResult result;
+        // releases the scene of any earlier render, so the two are not held in memory at once.
+        loaded_scene.reset();
+        loaded_scene_key.clear();
+
+        auto load_start = std::chrono::high_resolution_clock::now();
+        std::unique_ptr<Scene> scene = load_scene(scene_path, current_use_bvh && !coordinator, virtual_bvh, {});
+        result.load = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - load_start).count();
+        result.parse = scene->parse_seconds();
+        result.bvh = scene->bvh_build_seconds();
+
+        const int warmup_runs = std::max(0, Config::Instance().getInt("render.benchmark_warmup_runs", 1));
+        for (int w = 0; w < warmup_runs; ++w) {
+            std::cout << "Warm-up run " << (w + 1) << "/" << warmup_runs << std::endl;
+            render_loaded_scene(*scene, scene_path, current_use_bvh, {}, "", std::chrono::high_resolution_clock::now(), nullptr, false);
+        }
+
+        uint64_t rays = 0;
+        double render_total = 0.0;
+        double write_total = 0.0;
+        for (int r = 0; r < runs; ++r) {
+            std::cout << "Run " << (r + 1) << "/" << runs << std::endl;
+            RenderTimes times = render_loaded_scene(*scene, scene_path, current_use_bvh, {}, output_for(r), std::chrono::high_resolution_clock::now(), nullptr, false);
+            result.render_seconds.push_back(times.render);
+            rays += times.rays;
+            render_total += times.render;
+            write_total += times.write;
+        }
+        result.render = summarise_timings(result.render_seconds);
+        result.rays_per_second = render_total > 0.0 ? rays / render_total : 0.0;
+        result.write = runs > 0 ? write_total / runs : 0.0;
+        return result;
+    };
+
+    // prints each phase of a benchmark.
+    auto print_benchmark = [&](std::ostream& out, const BenchmarkResult& result) {
+        out << "  Scene load: " << result.load << "s (parsing " << result.parse << "s, BVH build " << result.bvh << "s)\n";
+        out << "  Render: min " << result.render.min << "s, median " << result.render.median << "s, mean " << result.render.mean
+            << "s, stddev " << result.render.stddev << "s over " << result.render_seconds.size() << " runs\n";
+        out << "  Throughput: " << result.rays_per_second / 1e6 << " Mrays/s\n";
+        out << "  Image write: " << result.write << "s per run" << std::endl;
+    };
+
+    // worker mode. connects to the coordinator, retrying every second until it is reachable, and renders the tiles of
+    // each job it is sent with the coordinator's command line. the scene stays loaded between jobs.
+    // the worker exits when the coordinator shuts down, or once it has been unreachable for worker_reconnect_seconds.
+    if (!worker_address.empty()) {
+        std::optional<std::vector<std::string>> applied_args;
+        const double reconnect_seconds = Config::Instance().getDouble("render.worker_reconnect_seconds", 300.0);
+        auto unreachable_since = std::chrono::steady_clock::now();
+        bool reported_waiting = false;
+        while (true) {
+            Socket connection;
+            try {
+                connection = connect_to(worker_address);
+            } catch (const std::exception& e) {
+                if (!reported_waiting) {
+                    std::cout << "Waiting for the coordinator at " << worker_address << "..." << std::endl;
+                    reported_waiting = true;
+                }
+                double waited = std::chrono::duration<double>(std::chrono::steady_clock::now() - unreachable_since).count();
+                if (reconnect_seconds > 0.0 && waited >= reconnect_seconds) {
+                    std::cerr << "Error: The coordinator at " << worker_address << " has been unreachable for "
+                              << reconnect_seconds << " seconds." << std::endl;
+                    return 1;
+                }
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
+            }
+            reported_waiting = false;
+            std::cout << "Connected to the coordinator at " << worker_address << "." << std::endl;
+
+            MessageWriter hello;
+            hello.u32(PROTOCOL_VERSION);
+            hello.u32(static_cast<uint32_t>(render_thread_count()));
+            worker_connection_lost = !send_message(connection, MSG_HELLO, hello);
+            while (!worker_connection_lost) {
+                uint32_t type;
+                std::vector<unsigned char> payload;
+                if (!receive_message(connection, type, payload)) {
+                    break;
+                }
+                if (type == MSG_SHUTDOWN) {
+                    std::cout << "The coordinator has finished; exiting." << std::endl;
+                    return 0;
+                }
+                // anything other than a job belongs to a job this worker has given up on.
+                if (type != MSG_JOB) {
+                    continue;
+                }
+                RenderJob job;
+                try {
+                    MessageReader reader(payload);
+                    job = read_job(reader);
+                } catch (const std::exception& e) {
+                    std::cerr << "Error: Malformed job from the coordinator: " << e.what() << std::endl;
+                    break;
+                }
+
+                if (!applied_args) {
+                    std::vector<char*> job_argv{argv[0]};
+                    for (std::string& arg : job.args) {
+                        job_argv.push_back(arg.data());
+                    }
+                    parse_args(static_cast<int>(job_argv.size()), job_argv.data());
+                    applied_args = job.args;
+                } else if (*applied_args != job.args) {
+                    // the arguments set flags that cannot be unset, so the worker restarts to render with different ones.
+                    std::cout << "The coordinator's settings changed; restarting the worker." << std::endl;
+                    connection.close();
+                    execv("/proc/self/exe", argv);
+                    std::cerr << "Error: Could not restart the worker." << std::endl;
+                    return 1;
+                }
+
+                frame_number = static_cast<int>(job.frame_number);
+                worker_connection = &connection;
+                worker_job_id = job.id;
+                try {
+                    double seconds = render_scene_func(job.scene_path, job.use_bvh, job.overrides, "").total;
+                    if (!worker_connection_lost) {
+                        std::cout << "Job " << job.id << " finished in " << seconds << " seconds." << std::endl;
+                    }
+                } catch (const std::exception& e) {
+                    std::cerr << "Error rendering job " << job.id << ": " << e.what() << std::endl;
+                    worker_connection_lost = true;
+                }
+                worker_connection = nullptr;
+                if (worker_shutdown) {
+                    std::cout << "The coordinator has finished; exiting." << std::endl;
+                    return 0;
+                }
+            }
+            std::cout << "Lost the connection to the coordinator." << std::endl;
+            unreachable_since = std::chrono::steady_clock::now();
+        }
+    }
+
+    // BVH testing. dispatch testing reuses the same scenes, comparing the two BVH layouts instead of BVH on and off.
+    if (enable_bvh_testing || enable_dispatch_testing) {
         std::string timestamp_str = get_current_timestamp();
         std::string output_dir = "../../Output/testing/" + timestamp_str;
         std::string source_bvh_dir = "../../ASCII/BVH_tests";
@@ -430,10 +1387,22 @@ int main(int argc, char* argv[]) {
                 return a.x < b.x;
             });
 
-            std::ofstream bvh_out(output_dir + "/bvh_test.txt");
-            std::ofstream no_bvh_out(output_dir + "/no_bvh_test.txt");
+            // the two configurations being compared: the first is timed against the second.
+            struct TestConfig {
+                std::string name;
+                bool bvh;
+                bool virtual_bvh;
+            };
+            TestConfig first_config = {"bvh", true, false};
+            TestConfig second_config = enable_dispatch_testing ? TestConfig{"virtual_bvh", true, true} : TestConfig{"no_bvh", false, false};
+
+            std::ofstream bvh_out(output_dir + "/" + first_config.name + "_test.txt");
+            std::ofstream no_bvh_out(output_dir + "/" + second_config.name + "_test.txt");
+
+            std::ofstream phases_out(output_dir + "/phases.txt");
+            phases_out << "# config x load_s parse_s bvh_s render_min_s render_median_s render_mean_s render_stddev_s mrays_per_s" << std::endl;
 
-            if (!bvh_out.is_open() || !no_bvh_out.is_open()) {
+            if (!bvh_out.is_open() || !no_bvh_out.is_open() || !phases_out.is_open()) {
                 std::cerr << "Error opening output result files." << std::endl;
                 return 1;
             }
@@ -443,29 +1412,35 @@ int main(int argc, char* argv[]) {
                 std::cout << "\n--- Testing Scene X=" << scene.x << " ---" << std::endl;
 
                 // Construct output paths for images
-                std::string bvh_img_path = output_dir + "/bvh_" + std::to_string(scene.x) + ".ppm";
-                std::string no_bvh_img_path = output_dir + "/no_bvh_" + std::to_string(scene.x) + ".ppm";
+                std::string bvh_img_path = output_dir + "/" + first_config.name + "_" + std::to_string(scene.x) + ".ppm";
+                std::string no_bvh_img_path = output_dir + "/" + second_config.name + "_" + std::to_string(scene.x) + ".ppm";
 
-                // Run 5 times with BVH
-                double total_time_bvh = 0;
-                for (int i = 0; i < 3; ++i) {
-                    std::cout << "Run " << (i+1) << "/3 [BVH ON]" << std::endl;
-                    std::string current_output = (i == 0) ? bvh_img_path : "";
-                    total_time_bvh += render_scene_func(scene.path, true, current_output);
-                }
-                double avg_time_bvh = total_time_bvh / 3.0;
+                // loads the scene once per configuration and times 3 renders of it, only writing the image on the first run.
+                std::cout << "[" << first_config.name << "]" << std::endl;
+                BenchmarkResult first_result = benchmark_scene(scene.path, first_config.bvh, first_config.virtual_bvh, 3, [&](int run) { return run == 0 ? bvh_img_path : ""; });
+                double avg_time_bvh = first_result.render.mean;
                 bvh_out << avg_time_bvh << " " << scene.x << std::endl;
 
-                // Run 5 times without BVH
-                double total_time_no_bvh = 0;
-                for (int i = 0; i < 3; ++i) {
-                    std::cout << "Run " << (i+1) << "/3 [BVH OFF]" << std::endl;
-                    // Only write the image on the first run
-                    std::string current_output = (i == 0) ? no_bvh_img_path : "";
-                    total_time_no_bvh += render_scene_func(scene.path, false, current_output);
-                }
-                double avg_time_no_bvh = total_time_no_bvh / 3.0;
+                std::cout << "[" << second_config.name << "]" << std::endl;
+                BenchmarkResult second_result = benchmark_scene(scene.path, second_config.bvh, second_config.virtual_bvh, 3, [&](int run) { return run == 0 ? no_bvh_img_path : ""; });
+                double avg_time_no_bvh = second_result.render.mean;
                 no_bvh_out << avg_time_no_bvh << " " << scene.x << std::endl;
+
+                // every phase of both configurations, for comparing the load and BVH build costs as well.
+                auto report = [&](const TestConfig& config, const BenchmarkResult& result) {
+                    std::cout << "Scene X=" << scene.x << " [" << config.name << "]:" << std::endl;
+                    print_benchmark(std::cout, result);
+                    phases_out << config.name << " " << scene.x << " " << result.load << " " << result.parse << " " << result.bvh << " "
+                               << result.render.min << " " << result.render.median << " " << result.render.mean << " "
+                               << result.render.stddev << " " << result.rays_per_second / 1e6 << std::endl;
+                };
+                report(first_config, first_result);
+                report(second_config, second_result);
+
+                if (enable_dispatch_testing) {
+                    std::cout << "Scene X=" << scene.x << ": primitive BVH " << avg_time_bvh << "s, virtual BVH " << avg_time_no_bvh
+                              << "s (speedup " << avg_time_no_bvh / avg_time_bvh << "x)" << std::endl;
+                }
             }
 
             std::cout << "\nBVH Testing Complete. Results saved to " << output_dir << std::endl;
@@ -480,6 +1455,95 @@ int main(int argc, char* argv[]) {
 
     // standard mode
 
+    // with --coordinator, the tiles are rendered by worker processes, which are sent every other argument.
+    if (!coordinator_address.empty()) {
+        for (int i = 1; i < argc; ++i) {
+            // the batch's frames are sent to the workers one job at a time.
+            if (std::string(argv[i]) == "--coordinator" || std::string(argv[i]) == "--batch") {
+                i++;
+            } else {
+                coordinator_args.push_back(argv[i]);
+            }
+        }
+        try {
+            coordinator = std::make_unique<TileCoordinator>(coordinator_address, Config::Instance().getDouble("render.worker_timeout", 120.0));
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
+    // batch mode. renders the frames of a job list one after another from this process, so the config is read once
+    // and textures and hdr backgrounds stay loaded while consecutive frames use them. each frame's scene is loaded
+    // and its BVH built on a thread of its own while the frame before it renders, and the images are written
+    // in the background, so a frame only waits for its own render.
+    if (!batch_path.empty()) {
+        try {
+            const std::vector<BatchFrame> frames = read_batch_file(batch_path, "../../Output/batch");
+            for (const BatchFrame& frame : frames) {
+                fs::path parent = fs::path(frame.output_path).parent_path();
+                if (!parent.empty()) {
+                    fs::create_directories(parent);
+                }
+            }
+            std::cout << "Rendering " << frames.size() << " frames from " << batch_path << "." << std::endl;
+
+            const bool build_bvh = use_bvh && !coordinator;
+            // starts loading a frame's scene. a frame with the same scene file and overrides as the one
+            // before it renders the same scene again.
+            auto start_loading = [&](size_t f, const std::shared_ptr<Scene>& previous) -> std::future<std::shared_ptr<Scene>> {
+                if (previous && f > 0 && scene_key(frames[f].scene_path, build_bvh, frames[f].overrides)
+                                         == scene_key(frames[f - 1].scene_path, build_bvh, frames[f - 1].overrides)) {
+                    std::promise<std::shared_ptr<Scene>> reused;
+                    reused.set_value(previous);
+                    return reused.get_future();
+                }
+                return std::async(std::launch::async, [&, f]() -> std::shared_ptr<Scene> {
+                    return load_scene(frames[f].scene_path, build_bvh, use_virtual_bvh, frames[f].overrides);
+                });
+            };
+
+            AsyncImageWriter image_writer;
+            auto batch_start = std::chrono::high_resolution_clock::now();
+            double total_waiting = 0.0;
+            // the most materials held at once. at most two scenes are loaded at a time, so this stays bounded
+            // however many frames there are.
+            size_t peak_materials = 0;
+            std::shared_ptr<Scene> scene;
+            std::future<std::shared_ptr<Scene>> next_scene = start_loading(0, nullptr);
+            for (size_t f = 0; f < frames.size(); ++f) {
+                const BatchFrame& frame = frames[f];
+                auto frame_start = std::chrono::high_resolution_clock::now();
+                // the scene of the frame before is released here, once this frame's scene is ready.
+                scene = next_scene.get();
+                double waiting = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - frame_start).count();
+                total_waiting += waiting;
+                if (f + 1 < frames.size()) {
+                    next_scene = start_loading(f + 1, scene);
+                }
+
+                std::cout << "\n--- Frame " << frame.frame_number << " (" << (f + 1) << " of " << frames.size() << ") ---" << std::endl;
+                frame_number = frame.frame_number;
+                double seconds = render_loaded_scene(*scene, frame.scene_path, use_bvh, frame.overrides, frame.output_path, frame_start, &image_writer, false).total;
+                std::cout << "Frame " << frame.frame_number << " finished in " << seconds << " seconds ("
+                          << waiting << " waiting for its scene)." << std::endl;
+                peak_materials = std::max(peak_materials, MaterialLibrary::Instance().size());
+            }
+            scene.reset();
+            int failed_writes = image_writer.flush();
+
+            double total = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - batch_start).count();
+            std::cout << "\nBatch complete: " << frames.size() << " frames in " << total << " seconds, "
+                      << total / std::max<size_t>(1, frames.size()) << " seconds per frame, "
+                      << total_waiting << " seconds waiting for scenes to load, at most "
+                      << peak_materials << " materials loaded at once." << std::endl;
+            return failed_writes == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << "Error during batch rendering: " << e.what() << std::endl;
+            return 1;
+        }
+    }
+
     std::string timestamp_str;
     std::string output_dir;
     // if timing is enabled, set up a directory for test outputs.
@@ -506,58 +1570,40 @@ int main(int argc, char* argv[]) {
         }
     }
 
-    // structure to store statistics for each render run.
-    struct RunStats {
-        double duration;
-        std::string output_path;
-    };
-    std::vector<RunStats> timing_results;
-
-    // main render loop, runs multiple times if timing is enabled.
+    // main render. with --time, the scene is loaded once and rendered several times, timing each phase separately.
     try {
         const std::string scene_file = "../../ASCII/scene.txt";
 
-        for (int i = 0; i < run_count; ++i) {
-            if (enable_timing) {
-                std::cout << "\n--- Starting Run " << (i + 1) << " of " << run_count << " ---" << std::endl;
-            }
-
-            std::string output_file;
-            if (enable_timing) {
-                // construct a unique filename for each timed run.
-                output_file = output_dir + "/output_" + timestamp_str + "_" + std::to_string(i + 1) + ".ppm";
-            } else {
-                output_file = "../../Output/scene_test.ppm";
-            }
-
-            // Call the encapsulated render function
-            double elapsed = render_scene_func(scene_file, use_bvh, output_file);
-
-            if (enable_timing) {
-                std::cout << "Run " << (i + 1) << " completed in " << elapsed << " seconds." << std::endl;
-                // store the results of the timed run.
-                timing_results.push_back({elapsed, output_file});
-            } else {
-                std::cout << "Render complete! Image saved to '" << output_file << "'." << std::endl;
-            }
-        }
-
-        // after all runs, if timing was enabled, write a log file.
         if (enable_timing) {
+            BenchmarkResult result = benchmark_scene(scene_file, use_bvh, use_virtual_bvh, run_count, [&](int run) {
+                // a unique filename for each timed run.
+                return output_dir + "/output_" + timestamp_str + "_" + std::to_string(run + 1) + ".ppm";
+            });
+            std::cout << "\nTiming results:" << std::endl;
+            print_benchmark(std::cout, result);
+
+            // after all runs, write a log file.
             std::string log_path = output_dir + "/timing_log.txt";
             std::ofstream log_file(log_path);
             if (log_file.is_open()) {
                 // log the command-line arguments used for the test.
                 log_file << "args: [" << all_args << "]\n";
-                // log the duration and output path for each run.
-                for (const auto& res : timing_results) {
-                    log_file << "[" << res.duration << ", " << res.output_path << "]\n";
+                // log the render time and output path for each run.
+                for (int run = 0; run < run_count; ++run) {
+                    log_file << "[" << result.render_seconds[run] << ", " << output_dir + "/output_" + timestamp_str + "_" + std::to_string(run + 1) + ".ppm" << "]\n";
                 }
+                print_benchmark(log_file, result);
                 log_file.close();
                 std::cout << "Timing log saved to: " << log_path << std::endl;
             } else {
                 std::cerr << "Failed to write log file to: " << log_path << std::endl;
             }
+        } else {
+            const std::string output_file = "../../Output/scene_test.ppm";
+            // Call the encapsulated render function
+            RenderTimes times = render_scene_func(scene_file, use_bvh, {}, output_file);
+            std::cout << "Render complete! Image saved to '" << output_file << "'." << std::endl;
+            print_stage_timings(*loaded_scene, times);
         }
     } catch (const std::exception& e) {
         std::cerr << "An error occurred: " << e.what() << std::endl;
@@ -6,16 +6,17 @@
 #include <limits>
 #include <cmath>
 #include <algorithm>
-#include "../utilities/Image.h"
+#include "../utilities/HeightField.h"
 #include "../config.h"
+#include "../environment/camera.h"
 
 // constructor for a complex cube.
 // initialises the base cube class and sets the maximum displacement for the bump map.
 // 'const' specifies that a variable's value is constant and tells the compiler to prevent anything from modifying it.
 // '&' declares a reference variable. a reference is an alias for an already existing variable.
-ComplexCube::ComplexCube(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time)
+ComplexCube::ComplexCube(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time)
     // initialises the base class 'cube' with the provided parameters.
-    : Cube(transform, inv_transform, mat, velocity, shutter_time)
+    : Cube(inv_transform, material_id, velocity, shutter_time)
 {
     // retrieves the maximum displacement value from the configuration, defaulting to 0.2 if not found.
     m_max_displacement = Config::Instance().getDouble("advanced.displacement_strength", 0.2);
@@ -37,14 +38,50 @@ double ComplexCube::signed_distance_box(const Vector3& p) const {
     Vector3 d = Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)) - Vector3(1,1,1);
     // calculates the distance for a point inside the box (negative value).
     // equation: inside_dist = min(max(d.x, d.y, d.z), 0.0)
-    double inside_dist = std::min(std::max(d.x, std::max(d.y, d.z)), 0.0);
+    double inside_dist = std::min<double>(std::max<double>(d.x, std::max<double>(d.y, d.z)), 0.0);
     // calculates the distance for a point outside the box (positive value).
     // equation: outside_dist = length(max(d, 0.0))
-    double outside_dist = Vector3(std::max(d.x, 0.0), std::max(d.y, 0.0), std::max(d.z, 0.0)).length();
+    double outside_dist = Vector3(std::max<double>(d.x, 0.0), std::max<double>(d.y, 0.0), std::max<double>(d.z, 0.0)).length();
     // returns the exact signed distance by combining inside and outside distances.
     return inside_dist + outside_dist;
 }
 
+// calculates the gradient of the signed distance to the unit box at point 'p'.
+Vector3 ComplexCube::gradient_box(const Vector3& p) const {
+    // equation: d = abs(p) - (1,1,1)
+    Vector3 d = Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)) - Vector3(1,1,1);
+    // gets the sign of each coordinate so the gradient points away from the centre.
+    Vector3 sign((p.x < 0) ? -1.0 : 1.0, (p.y < 0) ? -1.0 : 1.0, (p.z < 0) ? -1.0 : 1.0);
+    if (d.x > 0.0 || d.y > 0.0 || d.z > 0.0) {
+        // outside the box the gradient points from the nearest surface point towards p.
+        // equation: grad = normalize(max(d, 0) * sign(p))
+        return Vector3(std::max<double>(d.x, 0.0) * sign.x, std::max<double>(d.y, 0.0) * sign.y, std::max<double>(d.z, 0.0) * sign.z).normalize();
+    }
+    // inside the box the gradient is the normal of the nearest face.
+    if (d.x >= d.y && d.x >= d.z) return Vector3(sign.x, 0, 0);
+    if (d.y >= d.z) return Vector3(0, sign.y, 0);
+    return Vector3(0, 0, sign.z);
+}
+
+// calculates the gradients of the atlas uv coordinates on the face with the given base normal.
+void ComplexCube::get_uv_gradients(const Vector3& normal, Vector3& grad_u, Vector3& grad_v) const {
+    // each face maps two local axes linearly onto [0, 1], which is then scaled into a 4x3 atlas cell.
+    // equation: grad u = grad raw_u * 0.25, grad v = grad raw_v * (1.0/3.0)
+    if (normal.x != 0.0) {
+        // x-face: raw_u follows y (flipped on the positive face), raw_v follows z.
+        grad_u = Vector3(0, (normal.x > 0 ? -0.5 : 0.5) * 0.25, 0);
+        grad_v = Vector3(0, 0, 0.5 * (1.0/3.0));
+    } else if (normal.y != 0.0) {
+        // y-face: raw_u follows x (flipped on the negative face), raw_v follows z.
+        grad_u = Vector3((normal.y > 0 ? 0.5 : -0.5) * 0.25, 0, 0);
+        grad_v = Vector3(0, 0, 0.5 * (1.0/3.0));
+    } else {
+        // z-face: raw_u follows x, raw_v follows y.
+        grad_u = Vector3(0.5 * 0.25, 0, 0);
+        grad_v = Vector3(0, 0.5 * (1.0/3.0), 0);
+    }
+}
+
 // calculates the uv coordinates and base normal for a given point on the cube's surface.
 void ComplexCube::get_uv_and_normal(const Vector3& p, double& u, double& v, Vector3& normal) const {
     // creates a vector with the absolute values of the point's coordinates.
@@ -117,11 +154,82 @@ void ComplexCube::get_uv_and_normal(const Vector3& p, double& u, double& v, Vect
     v = (raw_v + v_offset) * (1.0/3.0);
 }
 
+// calculates the gradient of the signed distance to the displaced cube at object-space point 'p'.
+// the uv mapping is linear on each face, so the gradient only needs the baked derivatives at p.
+Vector3 ComplexCube::displaced_gradient(const Vector3& p, const Vector3& face_normal, const HeightSample& bump) const {
+    // equation: grad f = grad box(p) - s * (dh/du * grad u - dh/dy * grad v)
+    Vector3 gradient = gradient_box(p);
+    if (material().bump_map) {
+        Vector3 grad_u, grad_v;
+        get_uv_gradients(face_normal, grad_u, grad_v);
+        gradient = gradient - (grad_u * bump.du - grad_v * bump.dv) * m_max_displacement;
+    }
+    return gradient;
+}
+
+// converts the displaced cube into a mesh of micro-triangles, one grid per face.
+std::shared_ptr<Shape> ComplexCube::tessellate(const Camera& camera, double edge_pixels, int max_resolution) const {
+    if (!material().bump_map) {
+        return nullptr;
+    }
+
+    // estimates the on-screen size of a face from the cube's world-space bounds.
+    AABB box;
+    getBoundingBox(box);
+    double pixels_per_unit = camera.pixelsPerUnitWithin(box);
+    // the mesh is built in world space, so the object-to-world transform is recovered from the stored inverse.
+    AffineTransform transform = objectToWorld();
+    double half_size = std::max({transform.transformDirection(Vector3(1, 0, 0)).length(),
+                                 transform.transformDirection(Vector3(0, 1, 0)).length(),
+                                 transform.transformDirection(Vector3(0, 0, 1)).length()});
+    double extent_pixels = 2.0 * half_size * pixels_per_unit;
+    double relief_pixels = m_max_displacement * half_size * pixels_per_unit;
+    // each face covers a quarter of the atlas width, which limits the detail it can show.
+    int texels = material().bump_map->getWidth() / 4;
+    int resolution = TessellatedMesh::chooseResolution(extent_pixels, relief_pixels, edge_pixels, texels, max_resolution);
+
+    std::vector<TessellatedMesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (int axis = 0; axis < 3; ++axis) {
+        for (double sign : {-1.0, 1.0}) {
+            TessellatedMesh::appendGrid(vertices, indices, resolution, resolution, [&](double a, double b) {
+                // places the grid point on the face, spanning [-1, 1] along the other two axes.
+                double fa = a * 2.0 - 1.0;
+                double fb = b * 2.0 - 1.0;
+                Vector3 q = (axis == 0) ? Vector3(sign, fa, fb) : ((axis == 1) ? Vector3(fa, sign, fb) : Vector3(fa, fb, sign));
+
+                // uses the same face selection as the ray marcher, so vertices on shared edges match exactly and leave no cracks.
+                double u, v;
+                Vector3 face_normal;
+                get_uv_and_normal(q, u, v, face_normal);
+                HeightSample bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+                // equation: p = q + face_normal * height * s
+                Vector3 p = q + face_normal * (bump.height * m_max_displacement);
+
+                // the texture coordinates always come from this face, pulled just inside its edges, so the atlas regions do not bleed.
+                double face_u, face_v;
+                Vector3 own_normal;
+                Vector3 q_inside = (axis == 0) ? Vector3(sign, fa * 0.999999, fb * 0.999999)
+                                 : ((axis == 1) ? Vector3(fa * 0.999999, sign, fb * 0.999999) : Vector3(fa * 0.999999, fb * 0.999999, sign));
+                get_uv_and_normal(q_inside, face_u, face_v, own_normal);
+
+                TessellatedMesh::Vertex vertex;
+                vertex.position = transform * p;
+                vertex.normal = m_inverse_transform.transformNormal(displaced_gradient(q, face_normal, bump).normalize()).normalize();
+                vertex.uv = Vector2(face_u, face_v);
+                return vertex;
+            });
+        }
+    }
+
+    return std::make_shared<TessellatedMesh>(std::move(vertices), std::move(indices), m_material_id, velocity(), m_shutter_time);
+}
+
 // checks for intersection between a ray and the complex cube using ray marching.
 bool ComplexCube::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
     // adjusts the ray origin for motion blur based on the object's velocity and ray time.
-    // equation: ray_origin_at_t0 = ray.origin - m_velocity * ray.time
-    Vector3 ray_origin_at_t0 = ray.origin - m_velocity * ray.time;
+    // equation: ray_origin_at_t0 = ray.origin - velocity() * ray.time
+    Vector3 ray_origin_at_t0 = ray.origin - velocity() * ray.time;
     // transforms the ray origin and direction into the object's local space.
     Vector3 obj_origin = m_inverse_transform * ray_origin_at_t0;
     Vector3 obj_dir = m_inverse_transform.transformDirection(ray.direction);
@@ -179,36 +287,22 @@ bool ComplexCube::intersect(const Ray& ray, double t_min, double t_max, HitRecor
         // calculates the signed distance to the base (undisplaced) cube.
         double dist_to_base = signed_distance_box(p);
 
-        // gets the uv coordinates and a dummy normal for the current point.
+        // gets the uv coordinates and the base face normal for the current point.
         double u, v;
-        Vector3 normal_dummy;
-        get_uv_and_normal(p, u, v, normal_dummy);
+        Vector3 face_normal;
+        get_uv_and_normal(p, u, v, face_normal);
 
-        // calculates displacement based on the bump map, if present.
+        // calculates displacement based on the baked bump map, if present.
         double displacement = 0.0;
-        if (m_material.bump_map) {
-            // gets the dimensions of the bump map.
-            int w = m_material.bump_map->getWidth();
-            int h = m_material.bump_map->getHeight();
-            // converts uv coordinates to pixel coordinates, flipping v.
-            int x = static_cast<int>(u * (w - 1));
-            int y = static_cast<int>((1.0 - v) * (h - 1)); // flip v
-
-            // clamps pixel coordinates to be within the image bounds.
-            x = std::max(0, std::min(x, w-1));
-            y = std::max(0, std::min(y, h-1));
-
-            // gets the pixel colour from the bump map.
-            Pixel pix = m_material.bump_map->getPixel(x, y);
-            // calculates intensity from the pixel's rgb components.
-            // equation: intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0)
-            double intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0);
-            // scales the intensity by the maximum displacement.
-            // equation: displacement = intensity * m_max_displacement
-            displacement = intensity * m_max_displacement;
+        HeightSample bump = {0.0f, 0.0f, 0.0f};
+        if (material().bump_map) {
+            // gets the interpolated height and its derivatives in a single lookup, flipping v.
+            bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+            // scales the height by the maximum displacement.
+            // equation: displacement = height * m_max_displacement
+            displacement = bump.height * m_max_displacement;
         }
 
-
         // calculates the signed distance to the displaced surface.
         // equation: dist_to_surface = dist_to_base - displacement
         double dist_to_surface = dist_to_base - displacement;
@@ -218,47 +312,15 @@ bool ComplexCube::intersect(const Ray& ray, double t_min, double t_max, HitRecor
             // fills the hit record with intersection details.
             rec.t = t_current;
             rec.point = ray.point_at_parameter(t_current);
-            rec.mat = m_material;
-
-            // defines a small step for calculating the gradient.
-            double d = 0.005;
-            // 'auto' allows the compiler to deduce the type of a variable from its initialiser.
-            // deduces that 'sample_scene' is a lambda function that calculates the signed distance at a given point.
-            auto sample_scene = [&](Vector3 q) {
-                double qu, qv; Vector3 qn;
-                get_uv_and_normal(q, qu, qv, qn);
-                double q_disp = 0.0;
-                if (m_material.bump_map) {
-                    // gets bump map dimensions.
-                    int w = m_material.bump_map->getWidth();
-                    int h = m_material.bump_map->getHeight();
-                    // converts uv to pixel coordinates.
-                    int x = static_cast<int>(qu * (w - 1));
-                    int y = static_cast<int>((1.0 - qv) * (h - 1));
-                    // clamps coordinates.
-                     x = std::max(0, std::min(x, w-1));
-                     y = std::max(0, std::min(y, h-1));
-                    // gets pixel and calculates displacement.
-                    Pixel pix = m_material.bump_map->getPixel(x, y);
-                    // equation: q_disp = ((pix.r + pix.g + pix.b) / (3.0 * 255.0)) * m_max_displacement
-                    q_disp = ((pix.r + pix.g + pix.b) / (3.0 * 255.0)) * m_max_displacement;
-                }
-                // returns the signed distance to the displaced surface at point q.
-                return signed_distance_box(q) - q_disp;
-            };
-
-            // calculates the gradient of the signed distance function to determine the local normal.
-            // equation: grad_x = sample_scene(p + (d,0,0)) - sample_scene(p - (d,0,0))
-            double grad_x = sample_scene(p + Vector3(d,0,0)) - sample_scene(p - Vector3(d,0,0));
-            // equation: grad_y = sample_scene(p + (0,d,0)) - sample_scene(p - (0,d,0))
-            double grad_y = sample_scene(p + Vector3(0,d,0)) - sample_scene(p - Vector3(0,d,0));
-            // equation: grad_z = sample_scene(p + (0,0,d)) - sample_scene(p - (0,0,d))
-            double grad_z = sample_scene(p + Vector3(0,0,d)) - sample_scene(p - Vector3(0,0,d));
+            rec.mat = &material();
+
+            // calculates the gradient of the signed distance function analytically to determine the local normal.
+            Vector3 gradient = displaced_gradient(p, face_normal, bump);
 
             // normalises the gradient vector to get the local normal in object space.
-            Vector3 local_normal = Vector3(grad_x, grad_y, grad_z).normalize();
-            // transforms the local normal to world space using the inverse transpose matrix.
-            Vector3 world_normal = (m_inverse_transpose * local_normal).normalize();
+            Vector3 local_normal = gradient.normalize();
+            // transforms the local normal to world space using the inverse transpose, applied from the stored inverse transform.
+            Vector3 world_normal = m_inverse_transform.transformNormal(local_normal).normalize();
 
             // sets the face normal in the hit record, ensuring it points against the ray.
             rec.set_face_normal(ray, world_normal);
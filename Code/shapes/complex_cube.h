@@ -6,16 +6,21 @@
 #define B216602_COMPLEX_CUBE_H
 
 #include "cube.h"
+#include "tessellated_mesh.h"
 
-class ComplexCube : public Cube {
+struct HeightSample; // forward declaration of the baked bump map sample.
+
+class ComplexCube : public Cube, public Tessellatable {
 public:
     // constructor for the complex cube, inheriting from the base cube class.
-    ComplexCube(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time);
+    ComplexCube(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time);
 
     // overrides the intersect method to handle ray marching and displacement mapping.
     virtual bool intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const override;
     // overrides the getBoundingBox method to account for potential displacement.
     virtual bool getBoundingBox(AABB &output_box) const override;
+    // converts the displaced surface into a triangle mesh. returns nullptr when there is no bump map to displace by.
+    virtual std::shared_ptr<Shape> tessellate(const Camera& camera, double edge_pixels, int max_resolution) const override;
 
 private:
     // the maximum displacement value for the bump map.
@@ -24,6 +29,12 @@ private:
     void get_uv_and_normal(const Vector3& p, double& u, double& v, Vector3& normal) const;
     // calculates the signed distance from a point to the base (undisplaced) cube.
     double signed_distance_box(const Vector3& p) const;
+    // calculates the gradient of the signed distance to the base (undisplaced) cube.
+    Vector3 gradient_box(const Vector3& p) const;
+    // calculates the gradients of the uv coordinates on the face with the given base normal.
+    void get_uv_gradients(const Vector3& normal, Vector3& grad_u, Vector3& grad_v) const;
+    // calculates the gradient of the displaced surface's signed distance at object-space point 'p'.
+    Vector3 displaced_gradient(const Vector3& p, const Vector3& face_normal, const HeightSample& bump) const;
 };
 
 
@@ -6,63 +6,19 @@
 #include <limits>
 #include <cmath>
 #include <algorithm>
-#include "../utilities/Image.h"
+#include "../utilities/HeightField.h"
 #include "../config.h"
+#include "../environment/camera.h"
 
 // constructor for a complex plane.
-ComplexPlane::ComplexPlane(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time)
-    // initialises member variables with the provided parameters.
-    : m_transform(transform), m_inverse_transform(inv_transform), m_material(mat), m_velocity(velocity)
+ComplexPlane::ComplexPlane(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time)
+    // initialises the base class 'transformedshape' with the provided parameters.
+    : TransformedShape(inv_transform, material_id, velocity, shutter_time)
 {
-    // pre-calculates the inverse transpose matrix, used for transforming normals correctly.
-    m_inverse_transpose = m_inverse_transform.transpose();
     // retrieves the maximum displacement value from the configuration, defaulting to 0.2 if not found.
     m_max_displacement = Config::Instance().getDouble("advanced.displacement_strength", 0.2);
 }
 
-// calculates the world-space axis-aligned bounding box (aabb) for a given local-space box.
-bool ComplexPlane::getTransformedBoundingBox(AABB& output_box, const Vector3& min_p, const Vector3& max_p) const {
-    // defines the 8 corners of the local-space bounding box.
-    Vector3 corners[8];
-    corners[0] = Vector3(min_p.x, min_p.y, min_p.z);
-    corners[1] = Vector3(max_p.x, min_p.y, min_p.z);
-    corners[2] = Vector3(min_p.x, max_p.y, min_p.z);
-    corners[3] = Vector3(max_p.x, max_p.y, min_p.z);
-    corners[4] = Vector3(min_p.x, min_p.y, max_p.z);
-    corners[5] = Vector3(max_p.x, min_p.y, max_p.z);
-    corners[6] = Vector3(min_p.x, max_p.y, max_p.z);
-    corners[7] = Vector3(max_p.x, max_p.y, max_p.z);
-
-    // initialises the world-space bounding box extents to infinity.
-    Vector3 world_min(std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity(), std::numeric_limits<double>::infinity());
-    Vector3 world_max(-std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity());
-
-    // iterates through each corner of the local box.
-    for (int i = 0; i < 8; ++i) {
-        // transforms the corner from local space to world space.
-        // equation: world_pt = m_transform * corners[i]
-        Vector3 world_pt = m_transform * corners[i];
-        // checks if the object has velocity to account for motion blur.
-        if (m_velocity.length() > 1e-6) {
-            // for a moving object, the bounding box must encompass its position at the start and end of the frame.
-            // calculates the start position (t=0).
-            Vector3 p0 = world_pt;
-            // calculates the end position (t=1).
-            // equation: p1 = world_pt + m_velocity
-            Vector3 p1 = world_pt + (m_velocity * m_shutter_time);
-            // expands the world-space bounding box to include both start and end positions.
-            AABB::updateBounds(p0, world_min, world_max);
-            AABB::updateBounds(p1, world_min, world_max);
-        } else {
-            // for a static object, just expand the bounds to include the transformed corner.
-            AABB::updateBounds(world_pt, world_min, world_max);
-        }
-    }
-    // creates the final aabb from the calculated min and max world-space points.
-    output_box = AABB(world_min, world_max);
-    return true;
-}
-
 // calculates the bounding box for the complex plane, accounting for displacement.
 bool ComplexPlane::getBoundingBox(AABB& output_box) const {
     // defines the xy bounds of the local-space plane.
@@ -83,14 +39,102 @@ double ComplexPlane::signed_distance_plane(const Vector3& p) const {
     Vector3 d = Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)) - b;
     // calculates the distance for a point inside the box (negative value).
     // equation: inside_dist = min(max(d.x, d.y, d.z), 0.0)
-    double inside_dist = std::min(std::max(d.x, std::max(d.y, d.z)), 0.0);
+    double inside_dist = std::min<double>(std::max<double>(d.x, std::max<double>(d.y, d.z)), 0.0);
     // calculates the distance for a point outside the box (positive value).
     // equation: outside_dist = length(max(d, 0.0))
-    double outside_dist = Vector3(std::max(d.x, 0.0), std::max(d.y, 0.0), std::max(d.z, 0.0)).length();
+    double outside_dist = Vector3(std::max<double>(d.x, 0.0), std::max<double>(d.y, 0.0), std::max<double>(d.z, 0.0)).length();
     // returns the exact signed distance by combining inside and outside distances.
     return inside_dist + outside_dist;
 }
 
+// calculates the gradient of the signed distance to the thin box representing the plane.
+Vector3 ComplexPlane::gradient_plane(const Vector3& p) const {
+    // uses the same half-dimensions as signed_distance_plane.
+    Vector3 b(1.0, 1.0, 0.001);
+    Vector3 d = Vector3(std::abs(p.x), std::abs(p.y), std::abs(p.z)) - b;
+    // gets the sign of each coordinate so the gradient points away from the centre.
+    Vector3 sign((p.x < 0) ? -1.0 : 1.0, (p.y < 0) ? -1.0 : 1.0, (p.z < 0) ? -1.0 : 1.0);
+    if (d.x > 0.0 || d.y > 0.0 || d.z > 0.0) {
+        // outside the box the gradient points from the nearest surface point towards p.
+        return Vector3(std::max<double>(d.x, 0.0) * sign.x, std::max<double>(d.y, 0.0) * sign.y, std::max<double>(d.z, 0.0) * sign.z).normalize();
+    }
+    // inside the box the gradient is the normal of the nearest face.
+    if (d.x >= d.y && d.x >= d.z) return Vector3(sign.x, 0, 0);
+    if (d.y >= d.z) return Vector3(0, sign.y, 0);
+    return Vector3(0, 0, sign.z);
+}
+
+// adds the slope of the displacement to the gradient of the base (undisplaced) plane.
+Vector3 ComplexPlane::displaced_gradient(const Vector3& base_gradient, const HeightSample& bump) const {
+    if (!material().bump_map) {
+        return base_gradient;
+    }
+    // u and v are linear in x and y, so the baked derivatives give the slope of the displaced surface directly.
+    // equation: grad f = grad box(p) - s * (dh/du * (0.5, 0, 0) - dh/dy * (0, 0.5, 0))
+    return base_gradient - Vector3(0.5 * bump.du, -0.5 * bump.dv, 0.0) * m_max_displacement;
+}
+
+// converts the displaced plane into a mesh of micro-triangles.
+// the thin slab is closed with a displaced top and bottom grid joined by four side strips.
+std::shared_ptr<Shape> ComplexPlane::tessellate(const Camera& camera, double edge_pixels, int max_resolution) const {
+    if (!material().bump_map) {
+        return nullptr;
+    }
+
+    // estimates the on-screen size of the plane from its world-space bounds.
+    AABB box;
+    getBoundingBox(box);
+    double pixels_per_unit = camera.pixelsPerUnitWithin(box);
+    // the mesh is built in world space, so the object-to-world transform is recovered from the stored inverse.
+    AffineTransform transform = objectToWorld();
+    double half_size = std::max(transform.transformDirection(Vector3(1, 0, 0)).length(),
+                                transform.transformDirection(Vector3(0, 1, 0)).length());
+    double thickness = transform.transformDirection(Vector3(0, 0, 1)).length();
+    double extent_pixels = 2.0 * half_size * pixels_per_unit;
+    double relief_pixels = m_max_displacement * thickness * pixels_per_unit;
+    int texels = std::max(material().bump_map->getWidth(), material().bump_map->getHeight());
+    int resolution = TessellatedMesh::chooseResolution(extent_pixels, relief_pixels, edge_pixels, texels, max_resolution);
+
+    // builds a vertex on the top (side = 1) or bottom (side = -1) of the slab at local coordinates (x, y).
+    auto surface_vertex = [&](double x, double y, double side, const Vector3& base_normal) {
+        double u, v;
+        Vector3 normal_dummy;
+        get_uv_and_normal(Vector3(x, y, 0.0), u, v, normal_dummy);
+        HeightSample bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+        // equation: z = side * (0.001 + height * s)
+        Vector3 p(x, y, side * (0.001 + bump.height * m_max_displacement));
+
+        TessellatedMesh::Vertex vertex;
+        vertex.position = transform * p;
+        vertex.normal = m_inverse_transform.transformNormal(displaced_gradient(base_normal, bump).normalize()).normalize();
+        vertex.uv = Vector2(u, v);
+        return vertex;
+    };
+
+    std::vector<TessellatedMesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    for (double side : {1.0, -1.0}) {
+        TessellatedMesh::appendGrid(vertices, indices, resolution, resolution, [&](double a, double b) {
+            return surface_vertex(a * 2.0 - 1.0, b * 2.0 - 1.0, side, Vector3(0, 0, side));
+        });
+    }
+
+    // the side strips follow the displaced edges of the top and bottom grids so the slab stays closed.
+    for (int edge = 0; edge < 4; ++edge) {
+        Vector3 outward = (edge == 0) ? Vector3(-1, 0, 0) : ((edge == 1) ? Vector3(1, 0, 0) : ((edge == 2) ? Vector3(0, -1, 0) : Vector3(0, 1, 0)));
+        TessellatedMesh::appendGrid(vertices, indices, resolution, 1, [&](double a, double b) {
+            double along = a * 2.0 - 1.0;
+            double x = (edge < 2) ? outward.x : along;
+            double y = (edge < 2) ? along : outward.y;
+            TessellatedMesh::Vertex vertex = surface_vertex(x, y, (b < 0.5) ? 1.0 : -1.0, Vector3(0, 0, 1));
+            vertex.normal = m_inverse_transform.transformNormal(outward).normalize();
+            return vertex;
+        });
+    }
+
+    return std::make_shared<TessellatedMesh>(std::move(vertices), std::move(indices), m_material_id, velocity(), m_shutter_time);
+}
+
 // calculates the uv coordinates and base normal for a given point on the plane's surface.
 void ComplexPlane::get_uv_and_normal(const Vector3& p, double& u, double& v, Vector3& normal) const {
     // the base normal for an untransformed plane is along the z-axis.
@@ -111,8 +155,8 @@ void ComplexPlane::get_uv_and_normal(const Vector3& p, double& u, double& v, Vec
 // checks for intersection between a ray and the complex plane using ray marching.
 bool ComplexPlane::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
     // adjusts the ray origin for motion blur based on the object's velocity and ray time.
-    // equation: ray_origin_at_t0 = ray.origin - m_velocity * ray.time
-    Vector3 ray_origin_at_t0 = ray.origin - m_velocity * ray.time;
+    // equation: ray_origin_at_t0 = ray.origin - velocity() * ray.time
+    Vector3 ray_origin_at_t0 = ray.origin - velocity() * ray.time;
     // transforms the ray origin and direction into the object's local space.
     Vector3 obj_origin = m_inverse_transform * ray_origin_at_t0;
     Vector3 obj_dir = m_inverse_transform.transformDirection(ray.direction);
@@ -167,16 +211,6 @@ bool ComplexPlane::intersect(const Ray& ray, double t_min, double t_max, HitReco
     const double STEP_MULTI = Config::Instance().getDouble("advanced.step_multiplier", 0.8);
 
 
-    auto get_displacement_at = [&](double u, double v) {
-        if (!m_material.bump_map) return 0.0;
-
-        // Use Bilinear Interpolation instead of integer casting (getPixel)
-        Pixel pix = m_material.bump_map->getPixelBilinear(u, 1.0 - v);
-
-        double intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0);
-        return intensity * m_max_displacement;
-    };
-
     // performs ray marching to find the actual intersection with the displaced surface.
     for(int i = 0; i < MAX_STEPS; ++i)
     {
@@ -195,31 +229,29 @@ bool ComplexPlane::intersect(const Ray& ray, double t_min, double t_max, HitReco
         Vector3 normal_dummy;
         get_uv_and_normal(p, u, v, normal_dummy);
 
-        // calculates displacement based on the bump map, if present.
-        double displacement = get_displacement_at(u, v);
+        // calculates displacement based on the baked bump map, if present.
+        double displacement = 0.0;
+        HeightSample bump = {0.0f, 0.0f, 0.0f};
+        if (material().bump_map) {
+            // gets the interpolated height and its derivatives in a single lookup, flipping v.
+            bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+            displacement = bump.height * m_max_displacement;
+        }
         double dist_to_surface = dist_to_base - displacement;
         if (dist_to_surface < EPSILON) {
             rec.t = t_current;
             rec.point = ray.point_at_parameter(t_current);
-            rec.mat = m_material;
+            rec.mat = &material();
             rec.uv.u = u;
             rec.uv.v = v;
 
-            double d = 0.005;
-            auto sample_scene = [&](Vector3 q) {
-                double qu, qv; Vector3 qn;
-                get_uv_and_normal(q, qu, qv, qn);
-                double q_disp = get_displacement_at(qu, qv);
-                return signed_distance_plane(q) - q_disp;
-            };
-
-            // Calculate gradient (central differences)
-            double grad_x = sample_scene(p + Vector3(d,0,0)) - sample_scene(p - Vector3(d,0,0));
-            double grad_y = sample_scene(p + Vector3(0,d,0)) - sample_scene(p - Vector3(0,d,0));
-            double grad_z = sample_scene(p + Vector3(0,0,d)) - sample_scene(p - Vector3(0,0,d));
-
-            Vector3 local_normal = Vector3(grad_x, grad_y, grad_z).normalize();
-            Vector3 world_normal = (m_inverse_transpose * local_normal).normalize();
+            // Calculate gradient analytically. u and v are linear in x and y, so the
+            // baked derivatives give the slope of the displaced surface directly.
+            // equation: grad f = grad box(p) - s * (dh/du * (0.5, 0, 0) - dh/dy * (0, 0.5, 0))
+            Vector3 gradient = displaced_gradient(gradient_plane(p), bump);
+
+            Vector3 local_normal = gradient.normalize();
+            Vector3 world_normal = m_inverse_transform.transformNormal(local_normal).normalize();
 
             rec.set_face_normal(ray, world_normal);
             return true;
@@ -2,8 +2,9 @@
 #include <limits>
 #include <cmath>
 #include <algorithm>
-#include "../utilities/Image.h"
+#include "../utilities/HeightField.h"
 #include "../config.h"
+#include "../environment/camera.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
@@ -11,8 +12,8 @@
 
 // constructor for a complex sphere.
 // initialises the base sphere class and sets the maximum displacement for the bump map.
-ComplexSphere::ComplexSphere(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time)
-    : Sphere(transform, inv_transform, mat, velocity, shutter_time) {
+ComplexSphere::ComplexSphere(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time)
+    : Sphere(inv_transform, material_id, velocity, shutter_time) {
     // retrieves the maximum displacement value from the configuration, defaulting to 0.15 if not found.
     m_max_displacement = Config::Instance().getDouble("advanced.displacement_strength", 0.15);
 }
@@ -26,10 +27,77 @@ bool ComplexSphere::getBoundingBox(AABB& output_box) const {
     return getTransformedBoundingBox(output_box, Vector3(-r, -r, -r), Vector3(r, r, r));
 }
 
+// calculates the gradient of the signed distance to the displaced sphere at object-space point 'p'.
+// the sdf is f(p) = |p| - (1 + s * h(u(p), 1 - v(p))), so its gradient only needs the baked derivatives at p.
+Vector3 ComplexSphere::displaced_gradient(const Vector3& p, const HeightSample& bump) const {
+    double dist_from_center = p.length();
+    // equation: grad f = p / |p| - s * (dh/du * grad u - dh/dy * grad v)
+    Vector3 gradient = p / dist_from_center;
+    if (material().bump_map) {
+        // the squared distance from the polar (y) axis. clamped to avoid dividing by zero at the poles.
+        double ring_sq = std::max<double>(p.x * p.x + p.z * p.z, 1e-12);
+        // equation: grad u = (z, 0, -x) / (2 * π * (x^2 + z^2))
+        Vector3 grad_u = Vector3(p.z, 0.0, -p.x) / (2.0 * M_PI * ring_sq);
+        // equation: grad v = ((0, 1, 0) - y * p / |p|^2) / (π * sqrt(x^2 + z^2))
+        Vector3 grad_v = (Vector3(0.0, 1.0, 0.0) - p * (p.y / (dist_from_center * dist_from_center))) / (M_PI * std::sqrt(ring_sq));
+        gradient = gradient - (grad_u * bump.du - grad_v * bump.dv) * m_max_displacement;
+    }
+    return gradient;
+}
+
+// converts the displaced sphere into a mesh of micro-triangles over a latitude-longitude grid.
+std::shared_ptr<Shape> ComplexSphere::tessellate(const Camera& camera, double edge_pixels, int max_resolution) const {
+    if (!material().bump_map) {
+        return nullptr;
+    }
+
+    // estimates the on-screen size of the sphere from its world-space bounds.
+    AABB box;
+    getBoundingBox(box);
+    double pixels_per_unit = camera.pixelsPerUnitWithin(box);
+    // the mesh is built in world space, so the object-to-world transform is recovered from the stored inverse.
+    AffineTransform transform = objectToWorld();
+    double radius = std::max({transform.transformDirection(Vector3(1, 0, 0)).length(),
+                              transform.transformDirection(Vector3(0, 1, 0)).length(),
+                              transform.transformDirection(Vector3(0, 0, 1)).length()});
+
+    // a meridian is half the circumference long, and each ring around the sphere is twice that.
+    // equation: extent = π * radius * pixels_per_unit
+    double extent_pixels = M_PI * radius * pixels_per_unit;
+    double relief_pixels = m_max_displacement * radius * pixels_per_unit;
+    int res_v = TessellatedMesh::chooseResolution(extent_pixels, relief_pixels, edge_pixels, material().bump_map->getHeight(), max_resolution);
+    int res_u = 2 * res_v;
+
+    std::vector<TessellatedMesh::Vertex> vertices;
+    std::vector<uint32_t> indices;
+    TessellatedMesh::appendGrid(vertices, indices, res_u, res_v, [&](double u, double v) {
+        // inverts the spherical uv mapping to find the point on the unit sphere.
+        // equation: θ = v * π - π/2, φ = 2 * π * u - π
+        double theta = v * M_PI - M_PI / 2.0;
+        double phi = 2.0 * M_PI * u - M_PI;
+        Vector3 p_unit(std::cos(theta) * std::cos(phi), std::sin(theta), -std::cos(theta) * std::sin(phi));
+
+        // displaces the point outwards using the same lookup as the ray marcher.
+        HeightSample bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+        // equation: p = p_unit * (1 + height * s)
+        Vector3 p = p_unit * (1.0 + bump.height * m_max_displacement);
+
+        TessellatedMesh::Vertex vertex;
+        vertex.position = transform * p;
+        // the uv gradients are singular at the poles, so the pole rows keep the undisplaced normal.
+        Vector3 local_normal = (v <= 0.0 || v >= 1.0) ? p_unit : displaced_gradient(p, bump).normalize();
+        vertex.normal = m_inverse_transform.transformNormal(local_normal).normalize();
+        vertex.uv = Vector2(u, v);
+        return vertex;
+    });
+
+    return std::make_shared<TessellatedMesh>(std::move(vertices), std::move(indices), m_material_id, velocity(), m_shutter_time);
+}
+
 // checks for intersection between a ray and the complex sphere using ray marching.
 bool ComplexSphere::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
     // adjusts the ray origin for motion blur based on the object's velocity and ray time.
-    Vector3 ray_origin_at_t0 = ray.origin - m_velocity * ray.time;
+    Vector3 ray_origin_at_t0 = ray.origin - velocity() * ray.time;
     // transforms the ray origin and direction into the object's local space.
     Vector3 obj_origin = m_inverse_transform * ray_origin_at_t0;
     Vector3 obj_dir = m_inverse_transform.transformDirection(ray.direction);
@@ -89,18 +157,15 @@ bool ComplexSphere::intersect(const Ray& ray, double t_min, double t_max, HitRec
         double u, v;
         get_sphere_uv(p_unit, u, v);
 
-        // calculates displacement based on the bump map, if present.
+        // calculates displacement based on the baked bump map, if present.
         double displacement = 0.0;
-        if (m_material.bump_map) {
-            // gets the pixel colour from the bump map using bilinear interpolation, flipping v.
-            Pixel pix = m_material.bump_map->getPixelBilinear(u, 1.0 - v);
-
-            // calculates intensity from the pixel's rgb components.
-            // equation: intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0)
-            double intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0);
-            // scales the intensity by the maximum displacement.
-            // equation: displacement = intensity * m_max_displacement
-            displacement = intensity * m_max_displacement;
+        HeightSample bump = {0.0f, 0.0f, 0.0f};
+        if (material().bump_map) {
+            // gets the interpolated height and its derivatives in a single lookup, flipping v.
+            bump = material().bump_map->sampleBilinear(u, 1.0 - v);
+            // scales the height by the maximum displacement.
+            // equation: displacement = height * m_max_displacement
+            displacement = bump.height * m_max_displacement;
         }
 
         // calculates the signed distance to the displaced surface.
@@ -113,46 +178,18 @@ bool ComplexSphere::intersect(const Ray& ray, double t_min, double t_max, HitRec
             rec.t = t_current;
             // calculates the world-space intersection point.
             rec.point = ray.point_at_parameter(t_current);
-            rec.mat = m_material;
+            rec.mat = &material();
             // assigns the uv coordinates to the hit record.
             rec.uv.u = u;
             rec.uv.v = v;
 
-            // 'auto' allows the compiler to deduce the type of a variable from its initialiser.
-            // deduces that 'get_sdf' is a lambda function.
-            double eps = 0.005;
-            auto get_sdf = [&](Vector3 q) {
-                // calculates the length of the point from the origin.
-                double q_len = q.length();
-                // normalises the point to get its direction from the center.
-                Vector3 q_unit = q / q_len;
-                double qu, qv; 
-                get_sphere_uv(q_unit, qu, qv);
-                double q_disp = 0.0;
-                if (m_material.bump_map) {
-                    // gets the pixel colour from the bump map using bilinear interpolation, flipping v.
-                    Pixel pix = m_material.bump_map->getPixelBilinear(qu, 1.0 - qv);
-                    // scales the intensity by the maximum displacement.
-                    // equation: q_disp = ((pix.r + pix.g + pix.b) / (3.0 * 255.0)) * m_max_displacement
-                    q_disp = ((pix.r + pix.g + pix.b) / (3.0 * 255.0)) * m_max_displacement;
-                }
-                // returns the signed distance to the displaced surface at point q.
-                // equation: q_len - (1.0 + q_disp)
-                return q_len - (1.0 + q_disp);
-            };
-
-            // calculates the gradient of the signed distance function to determine the local normal.
-            // equation: dx = get_sdf(p + (eps,0,0)) - get_sdf(p - (eps,0,0))
-            double dx = get_sdf(p + Vector3(eps, 0, 0)) - get_sdf(p - Vector3(eps, 0, 0));
-            // equation: dy = get_sdf(p + (0,eps,0)) - get_sdf(p - (0,eps,0))
-            double dy = get_sdf(p + Vector3(0, eps, 0)) - get_sdf(p - Vector3(0, eps, 0));
-            // equation: dz = get_sdf(p + (0,0,eps)) - get_sdf(p - (0,0,eps))
-            double dz = get_sdf(p + Vector3(0, 0, eps)) - get_sdf(p - Vector3(0, 0, eps));
+            // calculates the gradient of the signed distance function analytically to determine the local normal.
+            Vector3 gradient = displaced_gradient(p, bump);
 
             // normalises the gradient vector to get the local normal in object space.
-            Vector3 local_normal = Vector3(dx, dy, dz).normalize();
-            // transforms the local normal to world space using the inverse transpose matrix.
-            Vector3 world_normal = (m_inverse_transpose * local_normal).normalize();
+            Vector3 local_normal = gradient.normalize();
+            // transforms the local normal to world space using the inverse transpose, applied from the stored inverse transform.
+            Vector3 world_normal = m_inverse_transform.transformNormal(local_normal).normalize();
 
             // sets the face normal in the hit record, ensuring it points against the ray.
             rec.set_face_normal(ray, world_normal);
@@ -2,20 +2,27 @@
 #define B216602_COMPLEX_SPHERE_H
 
 #include "sphere.h"
+#include "tessellated_mesh.h"
 
-class ComplexSphere : public Sphere {
+struct HeightSample; // forward declaration of the baked bump map sample.
+
+class ComplexSphere : public Sphere, public Tessellatable {
 public:
     // constructor for the complex sphere, inheriting from the base sphere class.
-    ComplexSphere(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time);
+    ComplexSphere(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time);
 
     // overrides the intersect method to handle ray marching and displacement mapping.
     virtual bool intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const override;
     // overrides the getBoundingBox method to account for potential displacement.
     virtual bool getBoundingBox(AABB& output_box) const override;
+    // converts the displaced surface into a triangle mesh. returns nullptr when there is no bump map to displace by.
+    virtual std::shared_ptr<Shape> tessellate(const Camera& camera, double edge_pixels, int max_resolution) const override;
 
 private:
     // the maximum displacement value for the bump map.
     double m_max_displacement;
+    // calculates the gradient of the displaced surface's signed distance at object-space point 'p'.
+    Vector3 displaced_gradient(const Vector3& p, const HeightSample& bump) const;
 
 };
 
@@ -8,7 +8,7 @@
 class Cube : public TransformedShape {
 public:
     // constructor for the cube.
-    Cube(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time); // 'public' is a c++ keyword that makes members accessible from outside the class.
+    Cube(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time); // 'public' is a c++ keyword that makes members accessible from outside the class.
 
     // overrides the intersect method from the base 'shape' class to provide cube-specific intersection logic.
     virtual bool intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const override;
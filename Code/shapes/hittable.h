@@ -20,8 +20,8 @@ struct HitRecord {
     Vector3 point;
     // the surface normal vector at the intersection point. this normal is always oriented to face the incoming ray.
     Vector3 normal;
-    // the material properties of the intersected object.
-    Material mat;
+    // the material properties of the intersected object, pointing into the material library.
+    const Material* mat = nullptr;
 
     // the 2d texture coordinates (u, v) at the intersection point.
     Vector2 uv;
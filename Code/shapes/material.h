@@ -8,9 +8,15 @@
 #include "../utilities/vector3.h"
 #include <string>
 #include <memory>
+#include <vector>
+#include <cstdint>
+#include <array>
+#include <mutex>
+#include <stdexcept>
 
 
 class Image; // forward declaration of the image class to avoid circular dependencies.
+class HeightField; // forward declaration of the baked bump map class.
 
 // 'struct' defines a composite data type that groups variables under a single name.
 // defines the blinn-phong material properties.
@@ -40,8 +46,8 @@ struct Material {
 
     // the filename of the bump map.
     std::string bump_map_filename;
-    // a pointer to the loaded bump map image.
-    std::shared_ptr<Image> bump_map;
+    // a pointer to the bump map, baked once at load time into a float heightfield with derivative maps.
+    std::shared_ptr<HeightField> bump_map;
 
     // a string identifier for the material type, e.g., "glass".
     std::string type = "glass";
@@ -50,4 +56,117 @@ struct Material {
     // initialises the material with default diffuse-like properties.
     Material() : ambient(0.1, 0.1, 0.1), diffuse(0.7, 0.7, 0.7), specular(1.0, 1.0, 1.0), shininess(32.0), texture(nullptr), bump_map(nullptr) {}};
 
+// stores the materials of every loaded scene.
+// shapes keep a 32-bit id into the library instead of their own copy of the material (over 200 bytes with its strings and pointers),
+// and a hit record points at the library entry instead of copying it on every hit.
+class MaterialLibrary {
+public:
+    static MaterialLibrary& Instance() {
+        static MaterialLibrary instance;
+        return instance;
+    }
+
+    // adds a material and returns its id. materials are stored in fixed-size chunks that never move,
+    // so one scene can load while another is rendering from the library.
+    // the id of a material released by a destroyed scene is reused first, so a batch of frames, which always
+    // loads the next scene before releasing the last one, keeps reusing the same few chunks.
+    uint32_t add(const Material& mat) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        uint32_t id;
+        if (!m_free_ids.empty()) {
+            id = m_free_ids.back();
+            m_free_ids.pop_back();
+        } else {
+            id = m_count;
+            if (id / CHUNK_SIZE >= MAX_CHUNKS) {
+                throw std::runtime_error("Too many materials loaded.");
+            }
+            std::unique_ptr<Material[]>& chunk = m_chunks[id / CHUNK_SIZE];
+            if (!chunk) {
+                chunk = std::make_unique<Material[]>(CHUNK_SIZE);
+            }
+            m_count++;
+        }
+        m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE] = mat;
+        return id;
+    }
+
+    // returns the material with the given id.
+    const Material& get(uint32_t id) const { return m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+    // returns the number of materials held by the loaded scenes.
+    size_t size() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_count - m_free_ids.size();
+    }
+
+private:
+    friend class SceneMaterials;
+
+    MaterialLibrary() = default;
+
+    // returns a stored material for its scene to finish, before any shape using it is rendered.
+    Material& getMutable(uint32_t id) { return m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+    // registers a scene that is about to add materials.
+    void acquire() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_scenes++;
+    }
+
+    // drops the materials of a scene that has been destroyed, releasing their textures straight away, and keeps
+    // their ids for the next materials added. the other scenes' entries do not move, as chunks are never freed
+    // while a scene is loaded. once no scene is left, the chunks themselves are freed.
+    void release(const std::vector<uint32_t>& ids) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (uint32_t id : ids) {
+            m_chunks[id / CHUNK_SIZE][id % CHUNK_SIZE] = Material();
+            m_free_ids.push_back(id);
+        }
+        if (--m_scenes == 0) {
+            for (std::unique_ptr<Material[]>& chunk : m_chunks) {
+                chunk.reset();
+            }
+            m_free_ids.clear();
+            m_count = 0;
+        }
+    }
+
+    static constexpr uint32_t CHUNK_SIZE = 256;
+    static constexpr uint32_t MAX_CHUNKS = 4096;
+
+    mutable std::mutex m_mutex;
+    std::array<std::unique_ptr<Material[]>, MAX_CHUNKS> m_chunks;
+    // the number of ids handed out so far, and those released by destroyed scenes, ready to be reused.
+    uint32_t m_count = 0;
+    std::vector<uint32_t> m_free_ids;
+    int m_scenes = 0;
+};
+
+// the materials one scene has added to the library, which are released when the scene is destroyed.
+class SceneMaterials {
+public:
+    SceneMaterials() { MaterialLibrary::Instance().acquire(); }
+    ~SceneMaterials() { MaterialLibrary::Instance().release(m_ids); }
+    SceneMaterials(const SceneMaterials&) = delete;
+    SceneMaterials& operator=(const SceneMaterials&) = delete;
+
+    // adds a material for the scene and returns its id.
+    uint32_t add(const Material& mat) {
+        uint32_t id = MaterialLibrary::Instance().add(mat);
+        m_ids.push_back(id);
+        return id;
+    }
+
+    // sets the texture and bump map of one of the scene's materials, once they have been loaded.
+    void setAssets(uint32_t id, std::shared_ptr<Image> texture, std::shared_ptr<HeightField> bump_map) {
+        Material& mat = MaterialLibrary::Instance().getMutable(id);
+        mat.texture = std::move(texture);
+        mat.bump_map = std::move(bump_map);
+    }
+
+private:
+    std::vector<uint32_t> m_ids;
+};
+
 #endif //B216602_MATERIAL_H
\ No newline at end of file
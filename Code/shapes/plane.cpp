@@ -3,7 +3,7 @@
 #include <random>
 
 #include "material.h"
-#include "../utilities/Image.h"
+#include "../utilities/HeightField.h"
 #include "../config.h"
 
 
@@ -11,16 +11,16 @@
 bool Plane::getBoundingBox(AABB& output_box) const {
     // calculates the four world-space vertices of the quad from the pre-calculated triangle data.
     // corner c0.
-    Vector3 v0 = m_t1_v0;          // Corner c0
+    Vector3 v0 = m_v0;          // Corner c0
     // corner c1.
-    // equation: v1 = m_t1_v0 + m_t1_edge1
-    Vector3 v1 = m_t1_v0 + m_t1_edge1; // Corner c1
+    // equation: v1 = m_v0 + m_edge1
+    Vector3 v1 = m_v0 + m_edge1; // Corner c1
     // corner c2.
-    // equation: v2 = m_t1_v0 + m_t1_edge2
-    Vector3 v2 = m_t1_v0 + m_t1_edge2; // Corner c2
+    // equation: v2 = m_v0 + m_edge2
+    Vector3 v2 = m_v0 + m_edge2; // Corner c2
     // corner c3.
-    // equation: v3 = m_t2_v0 + m_t2_edge1
-    Vector3 v3 = m_t2_v0 + m_t2_edge1; // Corner c3 (calculated as c1 + edge_c3_c1)
+    // equation: v3 = v1 + m_edge3
+    Vector3 v3 = v1 + m_edge3; // Corner c3 (calculated as c1 + edge_c3_c1)
 
     // initialises the bounding box extents with the first vertex.
     Vector3 min_p = v0;
@@ -39,38 +39,29 @@ bool Plane::getBoundingBox(AABB& output_box) const {
 
     // creates the final aabb from the calculated min and max points.
     AABB box_t0(min_p, max_p);
-    Vector3 displacement = m_velocity * m_shutter_time;
+    Vector3 displacement = velocity() * m_shutter_time;
     AABB box_t1(min_p + displacement, max_p + displacement);
     output_box = AABB::combine(box_t0, box_t1);
     return true;
 }
 
 // constructor for a plane, defined by four corner vertices.
-Plane::Plane(const Vector3& c0, const Vector3& c1, const Vector3& c2, const Vector3& c3, const Material& mat, const Vector3& velocity, double shutter_time) : m_material(mat), m_velocity(velocity), m_shutter_time(shutter_time)
+Plane::Plane(const Vector3& c0, const Vector3& c1, const Vector3& c2, const Vector3& c3, uint32_t material_id, const Vector3& velocity, double shutter_time)
+    : m_velocity(velocity.x, velocity.y, velocity.z), m_material_id(material_id), m_shutter_time(static_cast<float>(shutter_time))
 {
     // pre-calculates data for the first triangle (c0, c1, c2) to optimise intersection tests.
     // sets the origin vertex of the first triangle.
-    m_t1_v0 = c0;
+    m_v0 = c0;
     // calculates the first edge vector of the triangle.
     // equation: edge1 = c1 - c0
-    m_t1_edge1 = c1 - c0;
+    m_edge1 = c1 - c0;
     // calculates the second edge vector of the triangle.
     // equation: edge2 = c2 - c0
-    m_t1_edge2 = c2 - c0;
-
-    // pre-calculates data for the second triangle (c1, c3, c2).
-    // sets the origin vertex of the second triangle.
-    m_t2_v0 = c1;
-    // calculates the first edge vector of the second triangle.
-    // equation: edge1 = c3 - c1
-    m_t2_edge1 = c3 - c1;
-    // calculates the second edge vector of the second triangle.
-    // equation: edge2 = c2 - c1
-    m_t2_edge2 = c2 - c1;
+    m_edge2 = c2 - c0;
 
-    // calculates the plane's normal vector using the cross product of the first triangle's edges.
-    // equation: normal = (edge1 x edge2) normalized
-    m_normal = m_t1_edge1.cross(m_t1_edge2).normalize();
+    // stores the edge that completes the second triangle (c1, c3, c2).
+    // equation: edge3 = c3 - c1
+    m_edge3 = c3 - c1;
 }
 
 // implements the möller-trumbore ray-triangle intersection algorithm.
@@ -136,8 +127,8 @@ bool Plane::rayTriangleIntersect(
 // checks for an intersection between a ray and the plane (which is composed of two triangles).
 bool Plane::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
     // adjusts the ray origin for motion blur based on the object's velocity and ray time.
-    // equation: ray_origin_at_t0 = ray.origin - m_velocity * ray.time
-    Vector3 ray_origin_at_t0 = ray.origin - m_velocity * ray.time;
+    // equation: ray_origin_at_t0 = ray.origin - velocity * ray.time
+    Vector3 ray_origin_at_t0 = ray.origin - velocity() * ray.time;
     // creates a new ray at time t=0 for the intersection test.
     Ray ray_at_t0(ray_origin_at_t0, ray.direction, ray.time);
 
@@ -146,9 +137,10 @@ bool Plane::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec
     double t2, u2, v2;
 
     // checks for intersection with the first triangle of the quad.
-    bool hit1 = rayTriangleIntersect(ray_at_t0, t_min, t_max, m_t1_v0, m_t1_edge1, m_t1_edge2, t1, u1, v1);
-    // checks for intersection with the second triangle of the quad.
-    bool hit2 = rayTriangleIntersect(ray_at_t0, t_min, t_max, m_t2_v0, m_t2_edge1, m_t2_edge2, t2, u2, v2);
+    bool hit1 = rayTriangleIntersect(ray_at_t0, t_min, t_max, m_v0, m_edge1, m_edge2, t1, u1, v1);
+    // checks for intersection with the second triangle of the quad, whose origin is c1 and whose second edge runs from c1 to c2.
+    // equation: v0 = c0 + edge1, edge2 = (c2 - c0) - (c1 - c0)
+    bool hit2 = rayTriangleIntersect(ray_at_t0, t_min, t_max, m_v0 + m_edge1, m_edge3, m_edge2 - m_edge1, t2, u2, v2);
 
     // if neither triangle was hit, there is no intersection.
     if (!hit1 && !hit2) {
@@ -182,10 +174,10 @@ bool Plane::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec
     // equation: point = ray.origin + ray.direction * t_hit
     rec.point = ray.point_at_parameter(t_hit);
 
-    // sets the face normal, ensuring it points against the ray.
-    rec.set_face_normal(ray, m_normal);
-    Vector3 outward_normal = m_normal;
-    rec.mat = m_material;
+    // calculates the plane's normal vector using the cross product of the first triangle's edges.
+    // equation: normal = (edge1 x edge2) normalized
+    Vector3 outward_normal = m_edge1.cross(m_edge2).normalize();
+    rec.mat = &MaterialLibrary::Instance().get(m_material_id);
 
     // converts the barycentric coordinates (u, v) of the hit triangle to standard [0,1] uv coordinates for the quad.
     if (hit_triangle_1) {
@@ -196,38 +188,16 @@ bool Plane::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec
         rec.uv.v = u2 + v2;
     }
     // applies bump mapping if a bump map is present in the material.
-    if (rec.mat.bump_map) {
+    if (rec.mat->bump_map) {
         // for a plane, the tangent (t) and bitangent (b) align with the edges used to define the uvs.
-        Vector3 T = m_t1_edge1.normalize();
-        Vector3 B = m_t1_edge2.normalize();
+        Vector3 T = m_edge1.normalize();
+        Vector3 B = m_edge2.normalize();
         Vector3 N = outward_normal;
 
-        // gets the dimensions of the bump map.
-        int w = rec.mat.bump_map->getWidth();
-        int h = rec.mat.bump_map->getHeight();
-
-        // converts uv coordinates to pixel coordinates, flipping v.
-        int x = static_cast<int>(rec.uv.u * (w - 1));
-        int y = static_cast<int>((1.0 - rec.uv.v) * (h - 1)); // Flip V for image coords
-
-        // 'auto' means that the compiler deduces the type of a variable from its initialiser.
-        // deduces that 'get_val' is a lambda function that samples the bump map intensity at a given pixel.
-        auto get_val = [&](double u, double v) {
-            // getPixelBilinear handles clamping internally
-            Pixel pix = rec.mat.bump_map->getPixelBilinear(u, v);
-            return (pix.r + pix.g + pix.b) / (3.0 * 255.0);
-        };
-        double step_x = 1.0 / w;
-        double step_y = 1.0 / h;
-
-        // samples the height at the current point and its neighbours in u and v directions.
-        double height_c = get_val(rec.uv.u, rec.uv.v);
-        double height_u = get_val(rec.uv.u + step_x, rec.uv.v);
-        double height_v = get_val(rec.uv.u, rec.uv.v + step_y);
-
-        // calculates the gradients in the u and v directions (finite differences).
-        double bu = (height_u - height_c) * w;
-        double bv = (height_v - height_c) * h;
+        // fetches the interpolated height gradients from the baked bump map in a single lookup.
+        HeightSample bump = rec.mat->bump_map->sampleBilinear(rec.uv.u, rec.uv.v);
+        double bu = bump.du;
+        double bv = bump.dv;
 
         bu = std::max(-100.0, std::min(100.0, bu));
         bv = std::max(-100.0, std::min(100.0, bv));
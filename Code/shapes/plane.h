@@ -6,6 +6,7 @@
 #include <cmath> // For std::min
 #include "../acceleration/aabb.h"
 #include "material.h"
+#include <cstdint>
 
 // represents a quadrilateral plane in 3d space, composed of two triangles.
 class Plane : public Shape {
@@ -13,7 +14,7 @@ public:
     // constructor for the plane, defined by four corner vertices.
     // 'const' specifies that a variable's value is constant and tells the compiler to prevent anything from modifying it.
     // '&' declares a reference variable. a reference is an alias for an already existing variable.
-    Plane(const Vector3& c0, const Vector3& c1, const Vector3& c2, const Vector3& c3, const Material& mat, const Vector3& velocity, double shutter_time);
+    Plane(const Vector3& c0, const Vector3& c1, const Vector3& c2, const Vector3& c3, uint32_t material_id, const Vector3& velocity, double shutter_time);
 
     // 'virtual' indicates a member function can be overridden in a derived class.
     // overrides the base class method to test for ray-plane intersection.
@@ -30,27 +31,26 @@ public:
 
 private:
     // 'private' makes members accessible only within this class.
-    // the four corner vertices of the plane.
-    Vector3 m_c0, m_c1, m_c2, m_c3; // these are stored for potential future use but not directly used in intersection.
-
-    // the geometric normal vector for the entire plane.
-    Vector3 m_normal;
-
     // the plane is split into two triangles for intersection testing.
+    // only the first corner and three edges are stored; the second triangle and the normal are derived from them,
+    // which keeps the plane to two cache lines.
+
+    // the first corner (c0) and the edges of the first triangle (c0, c1, c2).
+    Vector3 m_v0, m_edge1, m_edge2;
 
-    // pre-calculated data for the first triangle (c0, c1, c2).
-    Vector3 m_t1_v0, m_t1_edge1, m_t1_edge2;
+    // the edge from c1 to c3, which completes the second triangle (c1, c3, c2).
+    Vector3 m_edge3;
 
-    // pre-calculated data for the second triangle (c1, c3, c2).
-    Vector3 m_t2_v0, m_t2_edge1, m_t2_edge2;
+    // the velocity of the plane for motion blur, stored in single precision.
+    Vector3T<float> m_velocity;
 
-    // the material properties of the plane.
-    Material m_material;
+    // the index of the plane's material in the material library.
+    uint32_t m_material_id;
 
-    // the velocity of the plane for motion blur.
-    Vector3 m_velocity;
+    float m_shutter_time;
 
-    double m_shutter_time;
+    // returns the velocity at the precision used by the renderer.
+    Vector3 velocity() const { return Vector3(m_velocity.x, m_velocity.y, m_velocity.z); }
 
     // a private helper function implementing the möller-trumbore ray-triangle intersection algorithm.
     bool rayTriangleIntersect(
@@ -5,16 +5,16 @@
 #include "sphere.h"
 #include <limits>
 #include <cmath>
-#include "../utilities/Image.h"
+#include "../utilities/HeightField.h"
 
 #ifndef M_PI
 #define M_PI 3.14159265358979323846
 #endif
 
 // constructor for a sphere.
-Sphere::Sphere(const Matrix4x4& transform, const Matrix4x4& inv_transform, const Material& mat, const Vector3& velocity, double shutter_time)
+Sphere::Sphere(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time)
     // initialises the base class 'transformedshape' with the provided parameters.
-    : TransformedShape(transform, inv_transform, mat, velocity, shutter_time)
+    : TransformedShape(inv_transform, material_id, velocity, shutter_time)
 {}
 
 // calculates the axis-aligned bounding box (aabb) for the transformed sphere.
@@ -43,8 +43,8 @@ void Sphere::get_sphere_uv(const Vector3& p, double& u, double& v) {
 // checks for intersection between a ray and the sphere.
 bool Sphere::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
     // adjusts the ray origin for motion blur based on the object's velocity and ray time.
-    // equation: ray_origin_at_t0 = ray.origin - m_velocity * ray.time
-    Vector3 ray_origin_at_t0 = ray.origin - m_velocity * ray.time;
+    // equation: ray_origin_at_t0 = ray.origin - velocity() * ray.time
+    Vector3 ray_origin_at_t0 = ray.origin - velocity() * ray.time;
 
     // transforms the ray from world space to the sphere's local object space.
     // equation: object_origin = m_inverse_transform * ray_origin_at_t0
@@ -100,20 +100,20 @@ bool Sphere::intersect(const Ray& ray, double t_min, double t_max, HitRecord& re
     Vector3 object_point = object_ray.point_at_parameter(rec.t);
     // for a unit sphere at the origin, the normal is the point on the surface.
     Vector3 object_normal = object_point - Vector3(0,0,0);
-    // transforms the local normal to world space using the inverse transpose matrix.
-    Vector3 outward_normal = (m_inverse_transpose * object_normal).normalize();
+    // transforms the local normal to world space using the inverse transpose, applied from the stored inverse transform.
+    Vector3 outward_normal = m_inverse_transform.transformNormal(object_normal).normalize();
 
     // sets the face normal in the hit record, ensuring it points against the ray.
     rec.set_face_normal(ray, outward_normal);
 
-    rec.mat = m_material;
+    rec.mat = &material();
 
     // calculates the uv coordinates for the hit point.
     Vector3 p_unit = object_normal.normalize();
     get_sphere_uv(p_unit, rec.uv.u, rec.uv.v);
 
     // applies bump mapping if a bump map is present in the material.
-    if (rec.mat.bump_map) {
+    if (rec.mat->bump_map) {
         // calculates tangent (t) and bitangent (b) vectors to form the tangent space.
         Vector3 Y_axis(0, 1, 0);
         Vector3 N = outward_normal;
@@ -130,35 +130,10 @@ bool Sphere::intersect(const Ray& ray, double t_min, double t_max, HitRecord& re
         // calculates the bitangent as perpendicular to the normal and tangent.
         Vector3 B = N.cross(T).normalize();
 
-        // samples gradients from the bump map.
-        int w = rec.mat.bump_map->getWidth();
-        int h = rec.mat.bump_map->getHeight();
-
-        // converts uv coordinates to pixel coordinates, flipping v.
-        int x = static_cast<int>(rec.uv.u * (w - 1));
-        int y = static_cast<int>((1.0 - rec.uv.v) * (h - 1));
-
-        // 'auto' means that the compiler deduces the type of a variable from its initialiser.
-        // deduces that 'get_val' is a lambda function that samples the bump map intensity at a given pixel.
-        auto get_val = [&](int px, int py) {
-            // clamps pixel coordinates to be within the image bounds.
-            px = std::min(std::max(px, 0), w - 1);
-            py = std::min(std::max(py, 0), h - 1);
-            // gets the pixel colour from the bump map.
-            Pixel pix = rec.mat.bump_map->getPixel(px, py);
-            // calculates intensity from the pixel's rgb components.
-            // equation: intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0)
-            return (pix.r + pix.g + pix.b) / (3.0 * 255.0);
-        };
-
-        // samples the height at the current point and its neighbours in u and v directions.
-        double height_c = get_val(x, y);
-        double height_u = get_val(x + 1, y);
-        double height_v = get_val(x, y + 1);
-
-        // calculates the gradients in the u and v directions (finite differences).
-        double bu = (height_u - height_c) * w;
-        double bv = (height_v - height_c) * h;
+        // fetches the precomputed height gradients from the baked bump map in a single lookup, flipping v.
+        HeightSample bump = rec.mat->bump_map->sampleNearest(rec.uv.u, 1.0 - rec.uv.v);
+        double bu = bump.du;
+        double bv = bump.dv;
 
         // perturbs the original normal using the gradients and tangent space vectors.
         double bump_scale = 0.0075;
@@ -0,0 +1,243 @@
+//
+// Created by alex on 03/12/2025.
+//
+
+#include "tessellated_mesh.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// the maximum number of triangles stored in a single bvh leaf.
+static const uint32_t MAX_LEAF_TRIANGLES = 4;
+
+// constructor for a tessellated mesh. builds the bvh and reorders the triangles to match its leaves.
+TessellatedMesh::TessellatedMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, uint32_t material_id, const Vector3& velocity, double shutter_time)
+    : m_vertices(std::move(vertices)), m_material_id(material_id), m_velocity(velocity), m_shutter_time(shutter_time)
+{
+    uint32_t triangle_count = static_cast<uint32_t>(indices.size() / 3);
+
+    // calculates the centroid of every triangle, used to sort triangles during the build.
+    std::vector<Vector3> centroids(triangle_count);
+    std::vector<uint32_t> order(triangle_count);
+    for (uint32_t i = 0; i < triangle_count; ++i) {
+        const Vector3& a = m_vertices[indices[3 * i]].position;
+        const Vector3& b = m_vertices[indices[3 * i + 1]].position;
+        const Vector3& c = m_vertices[indices[3 * i + 2]].position;
+        centroids[i] = (a + b + c) / 3.0;
+        order[i] = i;
+    }
+
+    // the triangles are referenced through the original index buffer while building.
+    m_indices = std::move(indices);
+    if (triangle_count > 0) {
+        // a balanced binary tree has roughly two nodes per leaf.
+        m_nodes.reserve(2 * (triangle_count / MAX_LEAF_TRIANGLES + 1));
+        buildNode(order, centroids, 0, triangle_count);
+    }
+
+    // rewrites the index buffer so each leaf covers a contiguous range of triangles.
+    std::vector<uint32_t> reordered(m_indices.size());
+    for (uint32_t i = 0; i < triangle_count; ++i) {
+        reordered[3 * i] = m_indices[3 * order[i]];
+        reordered[3 * i + 1] = m_indices[3 * order[i] + 1];
+        reordered[3 * i + 2] = m_indices[3 * order[i] + 2];
+    }
+    m_indices = std::move(reordered);
+}
+
+// calculates the bounding box of a range of triangles.
+AABB TessellatedMesh::boundsOf(const std::vector<uint32_t>& order, uint32_t start, uint32_t end) const {
+    double infinity = std::numeric_limits<double>::infinity();
+    Vector3 min_p(infinity, infinity, infinity);
+    Vector3 max_p(-infinity, -infinity, -infinity);
+    for (uint32_t i = start; i < end; ++i) {
+        for (int k = 0; k < 3; ++k) {
+            AABB::updateBounds(m_vertices[m_indices[3 * order[i] + k]].position, min_p, max_p);
+        }
+    }
+    return AABB(min_p, max_p);
+}
+
+// builds the bvh by splitting the triangles at the median centroid along the longest axis.
+uint32_t TessellatedMesh::buildNode(std::vector<uint32_t>& order, const std::vector<Vector3>& centroids, uint32_t start, uint32_t end) {
+    uint32_t node_index = static_cast<uint32_t>(m_nodes.size());
+    m_nodes.push_back({boundsOf(order, start, end), start, end - start});
+
+    if (end - start <= MAX_LEAF_TRIANGLES) {
+        // base case: the node becomes a leaf over this range of triangles.
+        return node_index;
+    }
+
+    // picks the axis along which the centroids are most spread out.
+    double infinity = std::numeric_limits<double>::infinity();
+    Vector3 min_c(infinity, infinity, infinity);
+    Vector3 max_c(-infinity, -infinity, -infinity);
+    for (uint32_t i = start; i < end; ++i) {
+        AABB::updateBounds(centroids[order[i]], min_c, max_c);
+    }
+    Vector3 extent = max_c - min_c;
+    int axis = 0;
+    if (extent.y > extent.x && extent.y > extent.z) {
+        axis = 1;
+    } else if (extent.z > extent.x && extent.z > extent.y) {
+        axis = 2;
+    }
+
+    // partitions the range around the median centroid.
+    uint32_t mid = start + (end - start) / 2;
+    std::nth_element(order.begin() + start, order.begin() + mid, order.begin() + end, [&](uint32_t a, uint32_t b) {
+        const Vector3& ca = centroids[a];
+        const Vector3& cb = centroids[b];
+        if (axis == 0) return ca.x < cb.x;
+        if (axis == 1) return ca.y < cb.y;
+        return ca.z < cb.z;
+    });
+
+    // the left child is always stored directly after its parent.
+    buildNode(order, centroids, start, mid);
+    uint32_t right = buildNode(order, centroids, mid, end);
+    m_nodes[node_index].first_or_right = right;
+    m_nodes[node_index].count = 0;
+    return node_index;
+}
+
+bool TessellatedMesh::getBoundingBox(AABB& output_box) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+    // combines the box at the start of the shutter with the box at the end of it.
+    const AABB& box_t0 = m_nodes[0].box;
+    Vector3 displacement = m_velocity * m_shutter_time;
+    AABB box_t1(box_t0.min_point + displacement, box_t0.max_point + displacement);
+    output_box = AABB::combine(box_t0, box_t1);
+    return true;
+}
+
+size_t TessellatedMesh::getMemoryUsage() const {
+    return m_vertices.size() * sizeof(Vertex) + m_indices.size() * sizeof(uint32_t) + m_nodes.size() * sizeof(Node);
+}
+
+bool TessellatedMesh::intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const {
+    if (m_nodes.empty()) {
+        return false;
+    }
+
+    // adjusts the ray origin for motion blur, the triangles are stored at their position at time 0.
+    // equation: ray_origin_at_t0 = ray.origin - m_velocity * ray.time
+    Ray ray_at_t0(ray.origin - m_velocity * ray.time, ray.direction, ray.time);
+    const Vector3& origin = ray_at_t0.origin;
+    const Vector3& direction = ray_at_t0.direction;
+
+    // the closest triangle found so far and its barycentric coordinates.
+    double closest_so_far = t_max;
+    uint32_t hit_triangle = 0;
+    double hit_b1 = 0.0, hit_b2 = 0.0;
+    bool hit_anything = false;
+
+    // traverses the bvh with an explicit stack instead of recursion.
+    uint32_t stack[64];
+    int stack_size = 0;
+    stack[stack_size++] = 0;
+
+    while (stack_size > 0) {
+        uint32_t node_index = stack[--stack_size];
+        const Node& node = m_nodes[node_index];
+        // prunes nodes the ray misses or that are further away than the closest hit.
+        if (!node.box.intersect(ray_at_t0, t_min, closest_so_far)) {
+            continue;
+        }
+
+        if (node.count == 0) {
+            // interior node: visits the left child (stored next) first.
+            stack[stack_size++] = node.first_or_right;
+            stack[stack_size++] = node_index + 1;
+            continue;
+        }
+
+        // leaf node: tests each triangle with the möller-trumbore algorithm.
+        for (uint32_t tri = node.first_or_right; tri < node.first_or_right + node.count; ++tri) {
+            const Vector3& v0 = m_vertices[m_indices[3 * tri]].position;
+            const Vector3& v1 = m_vertices[m_indices[3 * tri + 1]].position;
+            const Vector3& v2 = m_vertices[m_indices[3 * tri + 2]].position;
+            Vector3 edge1 = v1 - v0;
+            Vector3 edge2 = v2 - v0;
+
+            // equation: h = direction x edge2, a = edge1 · h
+            Vector3 h = direction.cross(edge2);
+            double a = edge1.dot(h);
+            // micro-triangles are tiny, so only truly parallel rays or degenerate triangles are rejected.
+            if (std::abs(a) < 1e-14) continue;
+
+            double f = 1.0 / a;
+            Vector3 s = origin - v0;
+            double b1 = f * s.dot(h);
+            if (b1 < 0.0 || b1 > 1.0) continue;
+
+            Vector3 q = s.cross(edge1);
+            double b2 = f * direction.dot(q);
+            if (b2 < 0.0 || b1 + b2 > 1.0) continue;
+
+            double t = f * edge2.dot(q);
+            if (t > t_min && t < closest_so_far) {
+                closest_so_far = t;
+                hit_triangle = tri;
+                hit_b1 = b1;
+                hit_b2 = b2;
+                hit_anything = true;
+            }
+        }
+    }
+
+    if (!hit_anything) {
+        return false;
+    }
+
+    // interpolates the vertex attributes at the hit point using the barycentric coordinates.
+    const Vertex& a = m_vertices[m_indices[3 * hit_triangle]];
+    const Vertex& b = m_vertices[m_indices[3 * hit_triangle + 1]];
+    const Vertex& c = m_vertices[m_indices[3 * hit_triangle + 2]];
+    double b0 = 1.0 - hit_b1 - hit_b2;
+
+    rec.t = closest_so_far;
+    rec.point = ray.point_at_parameter(rec.t);
+    rec.mat = &MaterialLibrary::Instance().get(m_material_id);
+    rec.uv.u = a.uv.u * b0 + b.uv.u * hit_b1 + c.uv.u * hit_b2;
+    rec.uv.v = a.uv.v * b0 + b.uv.v * hit_b1 + c.uv.v * hit_b2;
+    Vector3 normal = (a.normal * b0 + b.normal * hit_b1 + c.normal * hit_b2).normalize();
+    rec.set_face_normal(ray, normal);
+    return true;
+}
+
+// appends a grid of vertices and two triangles per grid cell.
+void TessellatedMesh::appendGrid(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, int resolution_a, int resolution_b,
+                                 const std::function<Vertex(double a, double b)>& surface) {
+    uint32_t base = static_cast<uint32_t>(vertices.size());
+    uint32_t row = static_cast<uint32_t>(resolution_a + 1);
+
+    for (int j = 0; j <= resolution_b; ++j) {
+        for (int i = 0; i <= resolution_a; ++i) {
+            vertices.push_back(surface(static_cast<double>(i) / resolution_a, static_cast<double>(j) / resolution_b));
+        }
+    }
+
+    for (int j = 0; j < resolution_b; ++j) {
+        for (int i = 0; i < resolution_a; ++i) {
+            uint32_t v00 = base + j * row + i;
+            uint32_t v10 = v00 + 1;
+            uint32_t v01 = v00 + row;
+            uint32_t v11 = v01 + 1;
+            indices.insert(indices.end(), {v00, v10, v11});
+            indices.insert(indices.end(), {v00, v11, v01});
+        }
+    }
+}
+
+int TessellatedMesh::chooseResolution(double extent_pixels, double relief_pixels, double edge_pixels, int texels, int max_resolution) {
+    // the displacement adds to the on-screen span of the patch, so stronger relief needs more cells to follow its silhouette.
+    // equation: cells = (extent_pixels + relief_pixels) / edge_pixels
+    double cells = (extent_pixels + relief_pixels) / edge_pixels;
+    int resolution = static_cast<int>(std::ceil(cells));
+    resolution = std::min(resolution, texels);
+    resolution = std::min(resolution, max_resolution);
+    return std::max(resolution, 4);
+}
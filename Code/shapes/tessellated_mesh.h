@@ -0,0 +1,89 @@
+//
+// Created by alex on 03/12/2025.
+//
+
+#ifndef B216602_TESSELLATED_MESH_H
+#define B216602_TESSELLATED_MESH_H
+
+#include "hittable.h"
+#include "material.h"
+#include "../utilities/vector2.h"
+#include "../acceleration/aabb.h"
+#include <vector>
+#include <memory>
+#include <cstdint>
+#include <functional>
+
+class Camera; // forward declaration of the camera class to avoid circular dependencies.
+
+// a displaced surface that has been tessellated into a mesh of micro-triangles at load time.
+// the triangles are stored in world space together with a compact, flat bvh, so intersection is ordinary triangle traversal.
+class TessellatedMesh : public Shape {
+public:
+    // a single mesh vertex. the normal and uv are interpolated across each triangle for shading.
+    struct Vertex {
+        Vector3 position;
+        Vector3 normal;
+        Vector2 uv;
+    };
+
+    // builds the mesh bvh over the given triangles (three vertex indices per triangle).
+    TessellatedMesh(std::vector<Vertex> vertices, std::vector<uint32_t> indices, uint32_t material_id, const Vector3& velocity, double shutter_time);
+
+    // tests the ray against the mesh bvh and the triangles in the leaves it reaches.
+    virtual bool intersect(const Ray& ray, double t_min, double t_max, HitRecord& rec) const override;
+    // returns the bounding box of the whole mesh, including its motion over the shutter time.
+    virtual bool getBoundingBox(AABB& output_box) const override;
+
+    // returns the number of triangles in the mesh.
+    size_t getTriangleCount() const { return m_indices.size() / 3; }
+    // returns the approximate memory used by the vertices, triangles, and bvh nodes in bytes.
+    size_t getMemoryUsage() const;
+
+    // appends a regular grid of (resolution_a + 1) x (resolution_b + 1) vertices and its triangles to a mesh under construction.
+    // 'surface' maps grid coordinates (a, b) in [0, 1] to a finished vertex.
+    static void appendGrid(std::vector<Vertex>& vertices, std::vector<uint32_t>& indices, int resolution_a, int resolution_b,
+                           const std::function<Vertex(double a, double b)>& surface);
+
+    // chooses the number of grid cells along a patch edge.
+    // density follows the on-screen size of the patch plus the on-screen height of its displacement relief,
+    // capped by the bump map resolution (more cells cannot add detail) and the configured maximum.
+    static int chooseResolution(double extent_pixels, double relief_pixels, double edge_pixels, int texels, int max_resolution);
+
+private:
+    // a node of the flat bvh. interior nodes store their right child index, the left child immediately follows the node.
+    // leaf nodes store a range of triangles instead.
+    struct Node {
+        AABB box;
+        // the first triangle of a leaf, or the right child of an interior node.
+        uint32_t first_or_right;
+        // the number of triangles in a leaf. zero for interior nodes.
+        uint32_t count;
+    };
+
+    // recursively builds the bvh over triangles [start, end), returning the index of the new node.
+    uint32_t buildNode(std::vector<uint32_t>& order, const std::vector<Vector3>& centroids, uint32_t start, uint32_t end);
+    // calculates the bounding box of triangles [start, end) in the given order.
+    AABB boundsOf(const std::vector<uint32_t>& order, uint32_t start, uint32_t end) const;
+
+    std::vector<Vertex> m_vertices;
+    // three vertex indices per triangle, reordered so each leaf covers a contiguous range.
+    std::vector<uint32_t> m_indices;
+    std::vector<Node> m_nodes;
+
+    // the index of the mesh's material in the material library.
+    uint32_t m_material_id;
+    Vector3 m_velocity;
+    double m_shutter_time;
+};
+
+// an interface for displaced shapes that can be converted into a tessellated mesh at load time.
+class Tessellatable {
+public:
+    // tessellates the displaced surface with a density adapted to its size as seen by the camera.
+    // 'edge_pixels' is the target on-screen length of a triangle edge.
+    virtual std::shared_ptr<Shape> tessellate(const Camera& camera, double edge_pixels, int max_resolution) const = 0;
+    virtual ~Tessellatable() {}
+};
+
+#endif //B216602_TESSELLATED_MESH_H
@@ -3,43 +3,51 @@
 
 #include "hittable.h"
 #include "../utilities/matrix4x4.h"
+#include "../utilities/affine_transform.h"
 #include "material.h"
 #include "../utilities/vector3.h"
 #include "../acceleration/aabb.h"
 #include <limits>
+#include <cstdint>
 
 // an abstract base class for shapes that can be translated, rotated, and scaled.
 // it handles the transformation logic, while derived classes implement the specific geometry.
 class TransformedShape : public Shape {
 public:
-    TransformedShape(const Matrix4x4& transform, const Matrix4x4& inv_transform,
-                     const Material& mat, const Vector3& velocity, double shutter_time)
+    TransformedShape(const Matrix4x4& inv_transform, uint32_t material_id, const Vector3& velocity, double shutter_time)
         // initialises member variables with the provided parameters.
-        : m_transform(transform),
-          m_inverse_transform(inv_transform),
-          // pre-calculates the inverse transpose matrix, used for transforming normals correctly.
-          m_inverse_transpose(inv_transform.transpose()),
-          m_material(mat),
-          m_velocity(velocity),
-          m_shutter_time(shutter_time)
+        : m_inverse_transform(inv_transform),
+          m_velocity(velocity.x, velocity.y, velocity.z),
+          m_material_id(material_id),
+          m_shutter_time(static_cast<float>(shutter_time))
     {}
 
+    // returns the material of the shape from the material library.
+    const Material& material() const { return MaterialLibrary::Instance().get(m_material_id); }
+
 protected:
-    // the object-to-world transformation matrix.
-    Matrix4x4 m_transform;
-    // the world-to-object inverse transformation matrix.
-    Matrix4x4 m_inverse_transform;
-    // the inverse transpose of the transformation matrix.
-    Matrix4x4 m_inverse_transpose;
-    // the material properties of the shape.
-    Material m_material;
+    // the world-to-object inverse transformation, the only transform needed to intersect a ray.
+    // the object-to-world transform and the inverse transpose for normals are derived from it when needed,
+    // so a shape takes two cache lines instead of three full 4x4 matrices.
+    AffineTransform m_inverse_transform;
     // the velocity of the shape for motion blur.
-    Vector3 m_velocity;
+    // the motion values are stored in single precision, they only offset the ray by a fraction of the shutter time.
+    Vector3T<float> m_velocity;
+    // the id of the shape's material in the material library.
+    uint32_t m_material_id;
     // shutter time for motion blur
-    double m_shutter_time;
+    float m_shutter_time;
+
+    // returns the velocity at the precision of the rest of the geometry.
+    Vector3 velocity() const { return Vector3(m_velocity.x, m_velocity.y, m_velocity.z); }
+
+    // calculates the object-to-world transformation from the stored inverse.
+    AffineTransform objectToWorld() const { return m_inverse_transform.inverse(); }
 
     // calculates the world-space axis-aligned bounding box (aabb) for a given local-space box.
     bool getTransformedBoundingBox(AABB& output_box, const Vector3& local_min, const Vector3& local_max) const {
+        AffineTransform transform = objectToWorld();
+
         // initialises the world-space bounding box extents to infinity.
         double infinity = std::numeric_limits<double>::infinity();
         Vector3 min_p(infinity, infinity, infinity);
@@ -56,7 +64,7 @@ protected:
                         (k == 0) ? local_min.z : local_max.z
                     );
                     // transforms the corner from local space to world space.
-                    Vector3 transformed_corner = m_transform * corner;
+                    Vector3 transformed_corner = transform * corner;
                     // expands the world-space bounding box to include the transformed corner.
                     AABB::updateBounds(transformed_corner, min_p, max_p);
                 }
@@ -66,7 +74,7 @@ protected:
         AABB box_t0(min_p, max_p);
 
         // Calculate the displacement over the shutter time
-        Vector3 displacement = m_velocity * m_shutter_time;
+        Vector3 displacement = velocity() * m_shutter_time;
 
         // Create a box for the end position (t=shutter_time)
         AABB box_t1(min_p + displacement, max_p + displacement);
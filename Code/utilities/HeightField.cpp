@@ -0,0 +1,86 @@
+//
+// Created by alex on 02/12/2025.
+//
+
+#include "HeightField.h"
+#include "Image.h"
+#include <algorithm>
+#include <cmath>
+
+// bakes the heightfield from an 8-bit rgb bump map.
+HeightField::HeightField(const Image& bump_map) : m_width(bump_map.getWidth()), m_height(bump_map.getHeight()) {
+    // 'size_t' is an unsigned integer type used to represent the size of objects in bytes.
+    m_texels.resize(static_cast<size_t>(m_width) * m_height);
+
+    // first pass converts every pixel to a single intensity value.
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            Pixel pix = bump_map.getPixel(x, y);
+            // equation: intensity = (pix.r + pix.g + pix.b) / (3.0 * 255.0)
+            m_texels[static_cast<size_t>(y) * m_width + x].height = static_cast<float>((pix.r + pix.g + pix.b) / (3.0 * 255.0));
+        }
+    }
+
+    // second pass precomputes the forward differences towards the next texel in x and y.
+    // the scale by width and height matches the gradients the shapes previously computed per hit.
+    for (int y = 0; y < m_height; ++y) {
+        for (int x = 0; x < m_width; ++x) {
+            HeightSample& s = m_texels[static_cast<size_t>(y) * m_width + x];
+            // equation: du = (h(x + 1, y) - h(x, y)) * width
+            s.du = (texel(x + 1, y).height - s.height) * static_cast<float>(m_width);
+            // equation: dv = (h(x, y + 1) - h(x, y)) * height
+            s.dv = (texel(x, y + 1).height - s.height) * static_cast<float>(m_height);
+        }
+    }
+}
+
+// returns the texel at the given coordinates, clamping to the edges.
+const HeightSample& HeightField::texel(int x, int y) const {
+    x = std::min(std::max(x, 0), m_width - 1);
+    y = std::min(std::max(y, 0), m_height - 1);
+    return m_texels[static_cast<size_t>(y) * m_width + x];
+}
+
+// samples the nearest texel to the normalised coordinates.
+HeightSample HeightField::sampleNearest(double x, double y) const {
+    // converts normalised coordinates to pixel coordinates using the same truncation as the rgb lookups.
+    int px = static_cast<int>(x * (m_width - 1));
+    int py = static_cast<int>(y * (m_height - 1));
+    return texel(px, py);
+}
+
+// performs bilinear interpolation of the height and both derivatives in one lookup.
+HeightSample HeightField::sampleBilinear(double x, double y) const {
+    // clamps the coordinates to the valid [0, 1] range.
+    x = std::max(0.0, std::min(1.0, x));
+    y = std::max(0.0, std::min(1.0, y));
+
+    // converts normalised coordinates to floating-point pixel coordinates.
+    double px = x * (m_width - 1);
+    double py = y * (m_height - 1);
+
+    // finds the top-left texel of the 2x2 grid and the fractional offsets within it.
+    int x0 = static_cast<int>(std::floor(px));
+    int y0 = static_cast<int>(std::floor(py));
+    float dx = static_cast<float>(px - x0);
+    float dy = static_cast<float>(py - y0);
+
+    const HeightSample& c00 = texel(x0, y0);
+    const HeightSample& c10 = texel(x0 + 1, y0);
+    const HeightSample& c01 = texel(x0, y0 + 1);
+    const HeightSample& c11 = texel(x0 + 1, y0 + 1);
+
+    // 'auto' means that the compiler deduces the type of a variable from its initialiser.
+    // interpolates a single channel horizontally then vertically.
+    auto lerp2 = [&](float a00, float a10, float a01, float a11) {
+        float top = a00 + (a10 - a00) * dx;
+        float bot = a01 + (a11 - a01) * dx;
+        return top + (bot - top) * dy;
+    };
+
+    return {
+        lerp2(c00.height, c10.height, c01.height, c11.height),
+        lerp2(c00.du, c10.du, c01.du, c11.du),
+        lerp2(c00.dv, c10.dv, c01.dv, c11.dv)
+    };
+}
@@ -0,0 +1,52 @@
+//
+// Created by alex on 02/12/2025.
+//
+
+#ifndef B216602_HEIGHTFIELD_H
+#define B216602_HEIGHTFIELD_H
+
+#include <vector>
+
+class Image; // forward declaration of the image class to avoid circular dependencies.
+
+// a single baked texel of a bump map.
+// the height and both derivatives are stored together so one lookup returns everything a shape needs.
+struct HeightSample {
+    // the surface height in the range [0, 1].
+    float height;
+    // the rate of change of the height along the image x axis, per unit of texture coordinate.
+    float du;
+    // the rate of change of the height along the image y axis (downwards), per unit of texture coordinate.
+    float dv;
+};
+
+// a single-channel float heightfield baked once from an 8-bit rgb bump map.
+// it replaces the per-sample rgb to intensity conversion and the extra neighbour lookups used for gradients.
+class HeightField {
+public:
+    // 'explicit' prevents the compiler from performing implicit type conversions from an image to a heightfield.
+    // bakes the heights and forward-difference derivative maps from a loaded bump map image.
+    explicit HeightField(const Image& bump_map);
+
+    // returns the texel nearest to normalised image coordinates (x, y), matching integer pixel casting.
+    HeightSample sampleNearest(double x, double y) const;
+
+    // returns the bilinearly interpolated height and derivatives at normalised image coordinates (x, y).
+    HeightSample sampleBilinear(double x, double y) const;
+
+    // returns the width of the heightfield in texels.
+    int getWidth() const { return m_width; }
+    // returns the height of the heightfield in texels.
+    int getHeight() const { return m_height; }
+
+private:
+    // returns the texel at integer coordinates, clamped to the heightfield bounds.
+    const HeightSample& texel(int x, int y) const;
+
+    int m_width;
+    int m_height;
+    // the baked texels, stored row by row.
+    std::vector<HeightSample> m_texels;
+};
+
+#endif //B216602_HEIGHTFIELD_H
@@ -173,13 +173,9 @@ void Image::write(const std::string& filename) const {
         throw std::runtime_error("Cannot open file for writing: " + filename);
     }
 
-    // Write PPM header
-    file << "P6\n";
-    file << m_width << " " << m_height << "\n";
-    file << m_max_color_val << "\n";
-
+    writeHeader(file);
     // writes the entire block of pixel data to the file.
-    file.write(reinterpret_cast<const char*>(m_pixel_data.data()), m_pixel_data.size());
+    writeRows(file, 0, m_height);
 
     // checks for write errors.
     if (!file) {
@@ -187,6 +183,19 @@ void Image::write(const std::string& filename) const {
     }
 }
 
+void Image::writeHeader(std::ostream& out) const {
+    // Write PPM header
+    out << "P6\n";
+    out << m_width << " " << m_height << "\n";
+    out << m_max_color_val << "\n";
+}
+
+void Image::writeRows(std::ostream& out, int y0, int y1) const {
+    // the rows are stored one after another, so a band of them is one contiguous block.
+    size_t row_bytes = static_cast<size_t>(m_width) * 3;
+    out.write(reinterpret_cast<const char*>(m_pixel_data.data() + y0 * row_bytes), static_cast<std::streamsize>((y1 - y0) * row_bytes));
+}
+
 // gets the pixel at a specific coordinate.
 Pixel Image::getPixel(int x, int y) const {
     // checks if the requested coordinates are within the image bounds.
@@ -211,3 +220,19 @@ void Image::setPixel(int x, int y, const Pixel& p) {
     m_pixel_data[index + 1] = p.g;
     m_pixel_data[index + 2] = p.b;
 }
+
+void Image::setBlock(int x, int y, int width, int height, const Pixel* pixels) {
+    // checks the whole block once, instead of every pixel.
+    if (x < 0 || y < 0 || width < 0 || height < 0 || x + width > m_width || y + height > m_height) {
+        throw std::out_of_range("Pixel block is out of bounds.");
+    }
+    for (int row = 0; row < height; ++row) {
+        unsigned char* destination = &m_pixel_data[(static_cast<size_t>(y + row) * m_width + x) * 3];
+        const Pixel* source = pixels + static_cast<size_t>(row) * width;
+        for (int column = 0; column < width; ++column) {
+            destination[column * 3] = source[column].r;
+            destination[column * 3 + 1] = source[column].g;
+            destination[column * 3 + 2] = source[column].b;
+        }
+    }
+}
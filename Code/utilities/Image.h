@@ -6,6 +6,7 @@
 #define B216602_IMAGE_H
 
 
+#include <ostream>
 #include <string>
 #include <vector>
 #include <stdexcept>
@@ -25,10 +26,15 @@ public:
 
     // write the image to a specified file.
     void write(const std::string& filename) const;
+    // writes the ppm header, then rows y0 up to (not including) y1, so an image can be written a band at a time.
+    void writeHeader(std::ostream& out) const;
+    void writeRows(std::ostream& out, int y0, int y1) const;
 
     // Getters used to read & modify pixel values.
     Pixel getPixel(int x, int y) const;
     void setPixel(int x, int y, const Pixel& p);
+    // copies a block of 'width' x 'height' pixels, stored row by row, into the image with its corner at (x, y).
+    void setBlock(int x, int y, int width, int height, const Pixel* pixels);
 
     // Getters for image dimensions.
     int getWidth() const { return m_width; }
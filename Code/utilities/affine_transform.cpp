@@ -0,0 +1,92 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "affine_transform.h"
+#include <stdexcept>
+
+template <typename T>
+AffineTransformT<T>::AffineTransformT() {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            m[i][j] = (i == j) ? 1.0 : 0.0;
+        }
+    }
+}
+
+template <typename T>
+AffineTransformT<T>::AffineTransformT(const Matrix4x4T<T>& matrix) {
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 4; ++j) {
+            m[i][j] = matrix.m[i][j];
+        }
+    }
+}
+
+template <typename T>
+Vector3T<T> AffineTransformT<T>::operator*(const Vector3T<T>& p) const {
+    return Vector3T<T>(
+        m[0][0] * p.x + m[0][1] * p.y + m[0][2] * p.z + m[0][3],
+        m[1][0] * p.x + m[1][1] * p.y + m[1][2] * p.z + m[1][3],
+        m[2][0] * p.x + m[2][1] * p.y + m[2][2] * p.z + m[2][3]
+    );
+}
+
+template <typename T>
+Vector3T<T> AffineTransformT<T>::transformDirection(const Vector3T<T>& v) const {
+    return Vector3T<T>(
+        m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z,
+        m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z,
+        m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z
+    );
+}
+
+template <typename T>
+Vector3T<T> AffineTransformT<T>::transformNormal(const Vector3T<T>& n) const {
+    // multiplies by the columns of the linear part instead of its rows.
+    return Vector3T<T>(
+        m[0][0] * n.x + m[1][0] * n.y + m[2][0] * n.z,
+        m[0][1] * n.x + m[1][1] * n.y + m[2][1] * n.z,
+        m[0][2] * n.x + m[1][2] * n.y + m[2][2] * n.z
+    );
+}
+
+// inverts the 3x3 linear part with its cofactors, then moves the translation into the inverted space.
+// equation: [A | t]^-1 = [A^-1 | -A^-1 * t]
+template <typename T>
+AffineTransformT<T> AffineTransformT<T>::inverse() const {
+    AffineTransformT inv;
+
+    // the cofactors, transposed, give the adjugate of the linear part.
+    inv.m[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+    inv.m[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+    inv.m[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+    inv.m[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+    inv.m[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+    inv.m[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+    inv.m[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+    inv.m[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+    inv.m[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+
+    double det = m[0][0] * inv.m[0][0] + m[0][1] * inv.m[1][0] + m[0][2] * inv.m[2][0];
+    if (det == 0) {
+        throw std::runtime_error("Transform is singular and cannot be inverted.");
+    }
+    det = 1.0 / det;
+
+    for (int i = 0; i < 3; ++i) {
+        for (int j = 0; j < 3; ++j) {
+            inv.m[i][j] = inv.m[i][j] * det;
+        }
+    }
+
+    for (int i = 0; i < 3; ++i) {
+        inv.m[i][3] = -(inv.m[i][0] * m[0][3] + inv.m[i][1] * m[1][3] + inv.m[i][2] * m[2][3]);
+    }
+
+    return inv;
+}
+
+// compiles the transform for both scalar types, so the definitions can stay out of the header.
+template class AffineTransformT<float>;
+template class AffineTransformT<double>;
@@ -0,0 +1,50 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_AFFINE_TRANSFORM_H
+#define B216602_AFFINE_TRANSFORM_H
+
+#include "vector3.h"
+#include "matrix4x4.h"
+
+
+// a compact 3x4 affine transformation: a 3x3 linear part (rotation and scale) and a translation column.
+// the bottom row of an affine 4x4 matrix is always (0, 0, 0, 1), so it is not stored,
+// which takes 12 values instead of 16 and skips the perspective divide when transforming points.
+template <typename T>
+class AffineTransformT {
+public:
+    T m[3][4];
+
+    // default constructor (initialises to identity).
+    AffineTransformT();
+
+    // takes the top three rows of an affine 4x4 matrix.
+    explicit AffineTransformT(const Matrix4x4T<T>& matrix);
+
+    // transforms a point (w=1), applying the translation.
+    Vector3T<T> operator*(const Vector3T<T>& p) const;
+
+    // transforms a direction vector (w=0), ignoring the translation.
+    Vector3T<T> transformDirection(const Vector3T<T>& v) const;
+
+    // transforms a vector by the transpose of the linear part.
+    // when this is a world-to-object transform, this is the object-to-world inverse transpose used for normals,
+    // so the inverse transpose never has to be stored.
+    // equation: n_world = (M^-1)^T * n_local
+    Vector3T<T> transformNormal(const Vector3T<T>& n) const;
+
+    // calculates the inverse transformation.
+    // throws a runtime_error if the linear part is singular (not invertible).
+    AffineTransformT inverse() const;
+};
+
+// the definitions are compiled once for each scalar type in affine_transform.cpp.
+extern template class AffineTransformT<float>;
+extern template class AffineTransformT<double>;
+
+// the affine transform type used throughout the renderer, at the precision selected for the build.
+using AffineTransform = AffineTransformT<Real>;
+
+#endif //B216602_AFFINE_TRANSFORM_H
@@ -0,0 +1,53 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "allocation_counter.h"
+
+#ifdef B216602_COUNT_ALLOCATIONS
+
+#include <cstdlib>
+#include <new>
+
+namespace {
+// each thread only increments its own count, so counting needs no synchronisation.
+thread_local uint64_t g_thread_allocations = 0;
+
+void* counted_allocate(std::size_t size) {
+    g_thread_allocations++;
+    // malloc(0) may return null, which operator new must not.
+    if (void* memory = std::malloc(size == 0 ? 1 : size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* counted_allocate_aligned(std::size_t size, std::align_val_t alignment) {
+    g_thread_allocations++;
+    // aligned_alloc needs the size to be a multiple of the alignment.
+    std::size_t align = static_cast<std::size_t>(alignment);
+    std::size_t rounded = (size + align - 1) / align * align;
+    if (void* memory = std::aligned_alloc(align, rounded == 0 ? align : rounded)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+// the array and nothrow forms call these, so replacing the single-object forms counts every allocation.
+void* operator new(std::size_t size) { return counted_allocate(size); }
+void* operator new(std::size_t size, std::align_val_t alignment) { return counted_allocate_aligned(size, alignment); }
+void operator delete(void* memory) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::align_val_t) noexcept { std::free(memory); }
+void operator delete(void* memory, std::size_t, std::align_val_t) noexcept { std::free(memory); }
+
+bool allocation_counting_enabled() { return true; }
+uint64_t thread_allocation_count() { return g_thread_allocations; }
+
+#else
+
+bool allocation_counting_enabled() { return false; }
+uint64_t thread_allocation_count() { return 0; }
+
+#endif
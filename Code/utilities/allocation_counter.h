@@ -0,0 +1,19 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_ALLOCATION_COUNTER_H
+#define B216602_ALLOCATION_COUNTER_H
+
+#include <cstdint>
+
+// counts the heap allocations made through operator new by each thread, to check that the render loop makes none.
+// the counting replaces the global operator new, so it is only built in with the B216602_COUNT_ALLOCATIONS option.
+
+// whether this build counts allocations.
+bool allocation_counting_enabled();
+
+// the number of allocations the calling thread has made, or 0 when counting is not built in.
+uint64_t thread_allocation_count();
+
+#endif //B216602_ALLOCATION_COUNTER_H
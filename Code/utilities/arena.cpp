@@ -0,0 +1,42 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "arena.h"
+#include <algorithm>
+#include <cstdint>
+
+MonotonicArena::MonotonicArena(size_t block_size) : m_block_size(std::max<size_t>(block_size, 256)) {
+    m_blocks.push_back(Block{static_cast<std::byte*>(::operator new(m_block_size)), m_block_size});
+}
+
+MonotonicArena::~MonotonicArena() {
+    for (const Block& block : m_blocks) {
+        ::operator delete(block.data);
+    }
+}
+
+void* MonotonicArena::allocate(size_t bytes, size_t alignment) {
+    // tries the current block, then the blocks kept from before the last rewind, before taking a new one.
+    for (; m_block < m_blocks.size(); ++m_block, m_offset = 0) {
+        const Block& block = m_blocks[m_block];
+        uintptr_t start = reinterpret_cast<uintptr_t>(block.data) + m_offset;
+        size_t padding = (alignment - start % alignment) % alignment;
+        if (m_offset + padding + bytes <= block.size) {
+            m_offset += padding + bytes;
+            return block.data + (m_offset - bytes);
+        }
+    }
+
+    // a request larger than the block size gets a block of its own, with room to align it.
+    size_t size = std::max(m_block_size, bytes + alignment);
+    m_blocks.push_back(Block{static_cast<std::byte*>(::operator new(size)), size});
+    m_block = m_blocks.size() - 1;
+    m_offset = 0;
+    return allocate(bytes, alignment);
+}
+
+void MonotonicArena::rewind(const Mark& mark) {
+    m_block = mark.block;
+    m_offset = mark.offset;
+}
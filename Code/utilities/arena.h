@@ -0,0 +1,170 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_ARENA_H
+#define B216602_ARENA_H
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// a bump allocator. memory is handed out in order from large blocks and is never freed one allocation at a time;
+// everything allocated after a mark is released together by rewinding to it, and the blocks are kept, so refilling
+// the arena does not allocate again. an arena is not thread-safe: it belongs to one thread, or is filled by one
+// thread before the others read it.
+class MonotonicArena {
+public:
+    // 'block_size' is the size of each block taken from the heap. the first block is allocated straight away.
+    explicit MonotonicArena(size_t block_size = 64 * 1024);
+    ~MonotonicArena();
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    // returns 'bytes' of uninitialised memory aligned to 'alignment', which must be a power of two.
+    void* allocate(size_t bytes, size_t alignment);
+
+    // returns uninitialised memory for 'count' objects of type T.
+    template <typename T>
+    T* allocateArray(size_t count) {
+        return static_cast<T*>(allocate(count * sizeof(T), alignof(T)));
+    }
+
+    // a position in the arena. rewinding to it frees everything allocated since, without running any destructors.
+    struct Mark {
+        size_t block = 0;
+        size_t offset = 0;
+    };
+    Mark mark() const { return Mark{m_block, m_offset}; }
+    void rewind(const Mark& mark);
+    // frees every allocation, keeping the blocks.
+    void reset() { rewind(Mark{}); }
+
+private:
+    struct Block {
+        std::byte* data;
+        size_t size;
+    };
+
+    size_t m_block_size;
+    std::vector<Block> m_blocks;
+    // the block being filled, and the offset of its first free byte.
+    size_t m_block = 0;
+    size_t m_offset = 0;
+};
+
+// rewinds an arena to where it was when the scope began, freeing the temporaries allocated within it.
+class ArenaScope {
+public:
+    explicit ArenaScope(MonotonicArena& arena) : m_arena(arena), m_mark(arena.mark()) {}
+    ~ArenaScope() { m_arena.rewind(m_mark); }
+    ArenaScope(const ArenaScope&) = delete;
+    ArenaScope& operator=(const ArenaScope&) = delete;
+
+private:
+    MonotonicArena& m_arena;
+    MonotonicArena::Mark m_mark;
+};
+
+// a standard allocator that takes its memory from an arena. deallocating does nothing: the memory is freed with the
+// arena, which must outlive every object allocated from it.
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    explicit ArenaAllocator(MonotonicArena& arena) : m_arena(&arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : m_arena(other.arena()) {}
+
+    T* allocate(size_t count) { return m_arena->allocateArray<T>(count); }
+    void deallocate(T*, size_t) {}
+
+    MonotonicArena* arena() const { return m_arena; }
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const { return m_arena == other.arena(); }
+
+private:
+    MonotonicArena* m_arena;
+};
+
+// constructs a T in the arena, with its reference count alongside it, so the objects of a scene sit together in
+// a few large blocks rather than in one heap allocation each.
+template <typename T, typename... Args>
+std::shared_ptr<T> arena_make_shared(MonotonicArena& arena, Args&&... args) {
+    return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+}
+
+// a stack of trivially copyable values in an arena. when it is full, the values move to an array twice the size
+// and the old one is left behind until the arena is rewound, so pushing never touches the heap once the arena's
+// blocks are large enough.
+template <typename T>
+class ArenaStack {
+    static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "values are copied and dropped as bytes");
+
+public:
+    ArenaStack(MonotonicArena& arena, size_t capacity)
+        : m_arena(arena), m_capacity(capacity > 0 ? capacity : 1), m_data(arena.allocateArray<T>(m_capacity)) {}
+    ArenaStack(const ArenaStack&) = delete;
+    ArenaStack& operator=(const ArenaStack&) = delete;
+
+    void push_back(const T& value) {
+        if (m_size == m_capacity) {
+            T* larger = m_arena.allocateArray<T>(m_capacity * 2);
+            std::memcpy(static_cast<void*>(larger), m_data, m_size * sizeof(T));
+            m_data = larger;
+            m_capacity *= 2;
+        }
+        new (m_data + m_size) T(value);
+        m_size++;
+    }
+    void pop_back() { m_size--; }
+    T& back() { return m_data[m_size - 1]; }
+    bool empty() const { return m_size == 0; }
+    size_t size() const { return m_size; }
+
+private:
+    MonotonicArena& m_arena;
+    size_t m_capacity;
+    T* m_data;
+    size_t m_size = 0;
+};
+
+// the arena the current thread takes its temporary render data from, such as the rays still to be traced, or null.
+inline MonotonicArena*& installed_scratch_arena() {
+    static thread_local MonotonicArena* arena = nullptr;
+    return arena;
+}
+
+// the current thread's scratch arena. a thread without one installed uses an arena of its own.
+inline MonotonicArena& thread_scratch_arena() {
+    if (MonotonicArena* arena = installed_scratch_arena()) {
+        return *arena;
+    }
+    static thread_local MonotonicArena fallback;
+    return fallback;
+}
+
+// installs a scratch arena for the current thread until the scope ends, resetting it first, so whatever the
+// previous tile left in it is freed.
+class ScratchArenaScope {
+public:
+    explicit ScratchArenaScope(MonotonicArena* arena) : m_previous(installed_scratch_arena()) {
+        if (arena) {
+            arena->reset();
+        }
+        installed_scratch_arena() = arena;
+    }
+    ~ScratchArenaScope() { installed_scratch_arena() = m_previous; }
+    ScratchArenaScope(const ScratchArenaScope&) = delete;
+    ScratchArenaScope& operator=(const ScratchArenaScope&) = delete;
+
+private:
+    MonotonicArena* m_previous;
+};
+
+#endif //B216602_ARENA_H
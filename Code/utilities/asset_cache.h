@@ -0,0 +1,56 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_ASSET_CACHE_H
+#define B216602_ASSET_CACHE_H
+
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// the textures, bump maps and hdr backgrounds of the loaded scenes, by kind and file path.
+// a scene that uses a file another loaded scene already uses shares it instead of reading it again, so the frames of
+// an animation, each loaded while the frame before it renders, only read and convert each file once.
+// entries are weak, so an asset is freed with the last scene using it.
+class AssetCache {
+public:
+    static AssetCache& Instance() {
+        static AssetCache instance;
+        return instance;
+    }
+
+    // returns the asset loaded from 'path', calling 'load' if no loaded scene has it.
+    // failed loads (null results) are not cached. the lock is not held while loading.
+    template <typename T>
+    std::shared_ptr<T> get(const std::string& kind, const std::string& path, const std::function<std::shared_ptr<T>()>& load) {
+        const std::string key = kind + ":" + path;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto it = m_assets.find(key);
+            if (it != m_assets.end()) {
+                if (std::shared_ptr<void> asset = it->second.lock()) {
+                    return std::static_pointer_cast<T>(asset);
+                }
+                m_assets.erase(it);
+            }
+        }
+
+        std::shared_ptr<T> asset = load();
+        if (asset) {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_assets[key] = asset;
+        }
+        return asset;
+    }
+
+private:
+    AssetCache() = default;
+
+    std::mutex m_mutex;
+    std::unordered_map<std::string, std::weak_ptr<void>> m_assets;
+};
+
+#endif //B216602_ASSET_CACHE_H
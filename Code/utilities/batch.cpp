@@ -0,0 +1,140 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "batch.h"
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+std::vector<BatchFrame> read_batch_file(const std::string& path, const std::string& output_dir) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open batch file: " + path);
+    }
+
+    std::vector<BatchFrame> frames;
+    BatchFrame frame;
+    bool in_frame = false;
+    bool has_number = false;
+    std::string line;
+    int line_number = 0;
+    while (std::getline(file, line)) {
+        line_number++;
+        std::stringstream ss(line);
+        std::string token;
+        ss >> token;
+        if (token.empty() || token[0] == '#') continue;
+
+        auto fail = [&](const std::string& message) {
+            throw std::runtime_error(path + ":" + std::to_string(line_number) + ": " + message);
+        };
+
+        if (token == "FRAME") {
+            if (in_frame) fail("FRAME inside another FRAME.");
+            // a frame starts from the previous frame's scene, without its overrides.
+            frame.overrides.clear();
+            frame.output_path.clear();
+            has_number = false;
+            in_frame = true;
+            continue;
+        }
+        if (!in_frame) fail("'" + token + "' outside a FRAME block.");
+
+        if (token == "END_FRAME") {
+            if (frame.scene_path.empty()) fail("FRAME has no scene.");
+            if (!has_number) {
+                frame.frame_number = frames.empty() ? 0 : frames.back().frame_number + 1;
+            }
+            if (frame.output_path.empty()) {
+                std::ostringstream name;
+                name << output_dir << "/frame_" << std::setw(4) << std::setfill('0') << frame.frame_number << ".ppm";
+                frame.output_path = name.str();
+            }
+            frames.push_back(frame);
+            in_frame = false;
+        } else if (token == "scene") {
+            ss >> frame.scene_path;
+        } else if (token == "output") {
+            ss >> frame.output_path;
+        } else if (token == "frame") {
+            if (!(ss >> frame.frame_number) || frame.frame_number < 0) fail("frame needs a number of zero or more.");
+            has_number = true;
+        } else if (token == "override") {
+            // override <BLOCK> <index> <key> <values...>
+            SceneOverride override;
+            if (!(ss >> override.block >> override.index >> override.key) || override.index < 0) {
+                fail("override needs a block, an index and a key.");
+            }
+            std::getline(ss >> std::ws, override.values);
+            frame.overrides.push_back(override);
+        } else {
+            fail("unknown key '" + token + "'.");
+        }
+    }
+    if (in_frame) {
+        throw std::runtime_error(path + ": the last FRAME has no END_FRAME.");
+    }
+    return frames;
+}
+
+AsyncImageWriter::AsyncImageWriter(size_t max_pending)
+    : m_max_pending(std::max<size_t>(1, max_pending)), m_thread([this]() { run(); }) {}
+
+AsyncImageWriter::~AsyncImageWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    m_thread.join();
+}
+
+void AsyncImageWriter::write(Image image, const std::string& path) {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]() { return m_queue.size() < m_max_pending; });
+    m_queue.push_back(Job{std::move(image), path});
+    m_changed.notify_all();
+}
+
+int AsyncImageWriter::flush() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_changed.wait(lock, [this]() { return m_queue.empty() && !m_writing; });
+    int failures = m_failures;
+    m_failures = 0;
+    return failures;
+}
+
+void AsyncImageWriter::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (true) {
+        m_changed.wait(lock, [this]() { return !m_queue.empty() || m_stopping; });
+        if (m_queue.empty()) {
+            return;
+        }
+        Job job = std::move(m_queue.front());
+        m_queue.pop_front();
+        m_writing = true;
+        m_changed.notify_all();
+
+        // the image is written without the lock, so more can be queued meanwhile.
+        lock.unlock();
+        bool failed = false;
+        try {
+            job.image.write(job.path);
+        } catch (const std::exception& e) {
+            std::cerr << "Error writing image: " << e.what() << std::endl;
+            failed = true;
+        }
+        lock.lock();
+
+        m_writing = false;
+        if (failed) {
+            m_failures++;
+        }
+        m_changed.notify_all();
+    }
+}
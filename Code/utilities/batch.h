@@ -0,0 +1,72 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_BATCH_H
+#define B216602_BATCH_H
+
+#include "Image.h"
+#include "scene.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// one frame of a batch: the scene to load, the overrides applied to it, and where its image is written.
+struct BatchFrame {
+    std::string scene_path;
+    std::vector<SceneOverride> overrides;
+    std::string output_path;
+    int frame_number = 0;
+};
+
+// reads a job list of frames, written in the style of a scene file:
+//
+//   FRAME
+//     scene ../../ASCII/scene.txt
+//     frame 12
+//     output ../../Output/frames/frame_0012.ppm
+//     override CAMERA 0 location 7.3 -6.9 4.9
+//     override SPHERE 1 translation -1.0 -1.5 -0.5
+//   END_FRAME
+//
+// a frame without a scene uses the previous frame's, a frame without a number follows on from the previous frame,
+// and a frame without an output is written to '<output_dir>/frame_<number>.ppm'.
+// throws std::runtime_error if the file cannot be read or a line is malformed.
+std::vector<BatchFrame> read_batch_file(const std::string& path, const std::string& output_dir);
+
+// writes images on a thread of its own, in the order they are queued, so rendering the next frame does not wait
+// for the disk. at most 'max_pending' images wait to be written; queueing another blocks until one is done.
+class AsyncImageWriter {
+public:
+    explicit AsyncImageWriter(size_t max_pending = 2);
+    // writes every queued image before returning.
+    ~AsyncImageWriter();
+    AsyncImageWriter(const AsyncImageWriter&) = delete;
+    AsyncImageWriter& operator=(const AsyncImageWriter&) = delete;
+
+    void write(Image image, const std::string& path);
+    // waits until every queued image has been written. returns the number that failed since the last call.
+    int flush();
+
+private:
+    void run();
+
+    struct Job {
+        Image image;
+        std::string path;
+    };
+
+    size_t m_max_pending;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    std::deque<Job> m_queue;
+    bool m_writing = false;
+    bool m_stopping = false;
+    int m_failures = 0;
+    std::thread m_thread;
+};
+
+#endif //B216602_BATCH_H
@@ -0,0 +1,391 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "distributed.h"
+#include <algorithm>
+#include <iostream>
+#include <stdexcept>
+
+#include <poll.h>
+
+void write_job(MessageWriter& writer, const RenderJob& job) {
+    writer.u32(job.id);
+    writer.string(job.scene_path);
+    writer.u32(job.use_bvh ? 1 : 0);
+    writer.u32(static_cast<uint32_t>(job.args.size()));
+    for (const std::string& arg : job.args) {
+        writer.string(arg);
+    }
+    writer.u32(job.frame_number);
+    writer.u32(static_cast<uint32_t>(job.overrides.size()));
+    for (const SceneOverride& override : job.overrides) {
+        writer.string(override.block);
+        writer.u32(static_cast<uint32_t>(override.index));
+        writer.string(override.key);
+        writer.string(override.values);
+    }
+}
+
+RenderJob read_job(MessageReader& reader) {
+    RenderJob job;
+    job.id = reader.u32();
+    job.scene_path = reader.string();
+    job.use_bvh = reader.u32() != 0;
+    uint32_t count = reader.u32();
+    for (uint32_t i = 0; i < count; ++i) {
+        job.args.push_back(reader.string());
+    }
+    job.frame_number = reader.u32();
+    count = reader.u32();
+    for (uint32_t i = 0; i < count; ++i) {
+        SceneOverride override;
+        override.block = reader.string();
+        override.index = static_cast<int>(reader.u32());
+        override.key = reader.string();
+        override.values = reader.string();
+        job.overrides.push_back(override);
+    }
+    return job;
+}
+
+void write_tile_request(MessageWriter& writer, const TileRequest& request) {
+    writer.u32(request.job);
+    writer.u32(request.tile_index);
+    writer.u32(static_cast<uint32_t>(request.tile.x0));
+    writer.u32(static_cast<uint32_t>(request.tile.y0));
+    writer.u32(static_cast<uint32_t>(request.tile.x1));
+    writer.u32(static_cast<uint32_t>(request.tile.y1));
+}
+
+TileRequest read_tile_request(MessageReader& reader) {
+    TileRequest request;
+    request.job = reader.u32();
+    request.tile_index = reader.u32();
+    request.tile.x0 = static_cast<int>(reader.u32());
+    request.tile.y0 = static_cast<int>(reader.u32());
+    request.tile.x1 = static_cast<int>(reader.u32());
+    request.tile.y1 = static_cast<int>(reader.u32());
+    return request;
+}
+
+void write_tile_result(MessageWriter& writer, const TileResult& result) {
+    writer.u32(result.job);
+    writer.u32(result.tile_index);
+    writer.u64(result.samples);
+    writer.u64(result.rays);
+    writer.u32(static_cast<uint32_t>(result.pixels.size()));
+    // a pixel is three bytes, so the pixels can be written as they are stored.
+    writer.bytes(result.pixels.data(), result.pixels.size() * sizeof(Pixel));
+    for (uint32_t count : result.sample_counts) {
+        writer.u32(count);
+    }
+}
+
+TileResult read_tile_result(MessageReader& reader) {
+    TileResult result;
+    result.job = reader.u32();
+    result.tile_index = reader.u32();
+    result.samples = reader.u64();
+    result.rays = reader.u64();
+    uint32_t count = reader.u32();
+    result.pixels.resize(count);
+    reader.bytes(result.pixels.data(), result.pixels.size() * sizeof(Pixel));
+    result.sample_counts.resize(count);
+    for (uint32_t& samples : result.sample_counts) {
+        samples = reader.u32();
+    }
+    return result;
+}
+
+bool receive_tile_batch(const Socket& connection, std::vector<TileRequest>& batch, bool& done, bool& shutdown) {
+    batch.clear();
+    done = false;
+    shutdown = false;
+    uint32_t type;
+    std::vector<unsigned char> payload;
+    while (true) {
+        // blocks until there is at least one tile, then only takes messages that are already waiting.
+        if (!batch.empty() && !wait_readable(connection, 0)) {
+            return true;
+        }
+        if (!receive_message(connection, type, payload)) {
+            return false;
+        }
+        MessageReader reader(payload);
+        if (type == MSG_TILE) {
+            batch.push_back(read_tile_request(reader));
+        } else if (type == MSG_DONE) {
+            // tiles sent before the job finished were duplicates that another worker has already returned.
+            batch.clear();
+            done = true;
+            return true;
+        } else if (type == MSG_SHUTDOWN) {
+            batch.clear();
+            done = true;
+            shutdown = true;
+            return true;
+        }
+    }
+}
+
+bool received_shutdown(const Socket& connection) {
+    // the connection may already be closed, but the messages sent before that can still be read.
+    MessageReceiver receiver;
+    receiver.receiveAvailable(connection);
+    uint32_t type;
+    std::vector<unsigned char> payload;
+    try {
+        while (receiver.next(type, payload)) {
+            if (type == MSG_SHUTDOWN) {
+                return true;
+            }
+        }
+    } catch (const std::exception&) {
+        // a malformed message ends the search; the worker reconnects as for any lost connection.
+    }
+    return false;
+}
+
+TileCoordinator::TileCoordinator(const std::string& address, double worker_timeout_seconds)
+    : m_address(address), m_timeout_seconds(worker_timeout_seconds), m_listener(listen_on(address)) {
+    std::cout << "Coordinator listening for workers on " << address << "." << std::endl;
+}
+
+TileCoordinator::~TileCoordinator() {
+    for (Worker& worker : m_workers) {
+        send_message(worker.socket, MSG_SHUTDOWN, MessageWriter());
+    }
+}
+
+void TileCoordinator::acceptWorker() {
+    Socket socket = accept_connection(m_listener);
+    if (!socket.valid()) {
+        return;
+    }
+    // a worker that stops reading fails the send after the timeout, instead of blocking the coordinator.
+    if (m_timeout_seconds > 0.0) {
+        set_send_timeout(socket, m_timeout_seconds);
+    }
+    Worker worker;
+    worker.socket = std::move(socket);
+    worker.name = "Worker " + std::to_string(++m_connections);
+    worker.last_progress = std::chrono::steady_clock::now();
+    std::cout << worker.name << " connected." << std::endl;
+    m_workers.push_back(std::move(worker));
+}
+
+bool TileCoordinator::receiveMessages(Worker& worker, Frame& frame, const std::function<void(const TileResult&)>& on_result) {
+    if (!worker.receiver.receiveAvailable(worker.socket)) {
+        return false;
+    }
+    uint32_t type;
+    std::vector<unsigned char> payload;
+    try {
+        while (worker.receiver.next(type, payload)) {
+            if (!handleMessage(worker, frame, type, payload, on_result)) {
+                return false;
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << worker.name << " sent a malformed message: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TileCoordinator::handleMessage(Worker& worker, Frame& frame, uint32_t type, const std::vector<unsigned char>& payload,
+                                    const std::function<void(const TileResult&)>& on_result) {
+    try {
+        MessageReader reader(payload);
+        if (type == MSG_HELLO) {
+            if (reader.u32() != PROTOCOL_VERSION) {
+                std::cerr << worker.name << " uses a different protocol version." << std::endl;
+                return false;
+            }
+            worker.threads = std::max(1, static_cast<int>(reader.u32()));
+            MessageWriter writer;
+            write_job(writer, *frame.job);
+            return send_message(worker.socket, MSG_JOB, writer);
+        }
+        if (type == MSG_READY) {
+            if (reader.u32() == frame.job->id) {
+                worker.ready = true;
+                worker.last_progress = std::chrono::steady_clock::now();
+            }
+            return true;
+        }
+        if (type == MSG_RESULT) {
+            TileResult result = read_tile_result(reader);
+            // results for an earlier frame are late duplicates.
+            if (result.job != frame.job->id || result.tile_index >= frame.tiles->size()) {
+                return true;
+            }
+            auto held = std::find(worker.in_flight.begin(), worker.in_flight.end(), result.tile_index);
+            if (held != worker.in_flight.end()) {
+                worker.in_flight.erase(held);
+                frame.holders[result.tile_index]--;
+            }
+            worker.last_progress = std::chrono::steady_clock::now();
+
+            const Tile& tile = (*frame.tiles)[result.tile_index];
+            if (result.pixels.size() != static_cast<size_t>(tile.width()) * tile.height()) {
+                std::cerr << worker.name << " returned a tile of the wrong size." << std::endl;
+                return false;
+            }
+            if (!frame.finished[result.tile_index]) {
+                frame.finished[result.tile_index] = true;
+                frame.remaining--;
+                on_result(result);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::cerr << worker.name << " sent a malformed message: " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool TileCoordinator::topUp(Worker& worker, Frame& frame) {
+    if (!worker.ready) {
+        return true;
+    }
+    // a worker with many threads renders several tiles at once, so it is kept further ahead.
+    size_t target = static_cast<size_t>(std::max(2, worker.threads / 4));
+    auto now = std::chrono::steady_clock::now();
+    while (worker.in_flight.size() < target) {
+        int64_t tile_index = -1;
+        while (!frame.queue.empty() && tile_index < 0) {
+            uint32_t candidate = frame.queue.front();
+            frame.queue.pop_front();
+            if (!frame.finished[candidate]) {
+                tile_index = candidate;
+            }
+        }
+        if (tile_index < 0) {
+            // the queue is empty, so the worker duplicates the unfinished tile that has been out the longest,
+            // as long as no more than one other worker already has it.
+            for (size_t t = 0; t < frame.finished.size(); ++t) {
+                if (frame.finished[t] || frame.holders[t] >= 2
+                    || std::find(worker.in_flight.begin(), worker.in_flight.end(), t) != worker.in_flight.end()) {
+                    continue;
+                }
+                if (tile_index < 0 || frame.sent_at[t] < frame.sent_at[tile_index]) {
+                    tile_index = static_cast<int64_t>(t);
+                }
+            }
+        }
+        if (tile_index < 0) {
+            return true;
+        }
+
+        uint32_t index = static_cast<uint32_t>(tile_index);
+        TileRequest request;
+        request.job = frame.job->id;
+        request.tile_index = index;
+        request.tile = (*frame.tiles)[index];
+        MessageWriter writer;
+        write_tile_request(writer, request);
+        if (!send_message(worker.socket, MSG_TILE, writer)) {
+            frame.queue.push_front(index);
+            return false;
+        }
+        if (worker.in_flight.empty()) {
+            worker.last_progress = now;
+        }
+        if (frame.holders[index] == 0) {
+            frame.sent_at[index] = now;
+        }
+        worker.in_flight.push_back(index);
+        frame.holders[index]++;
+    }
+    return true;
+}
+
+void TileCoordinator::dropWorker(size_t index, Frame& frame, const std::string& reason) {
+    Worker& worker = m_workers[index];
+    int reassigned = 0;
+    for (uint32_t tile_index : worker.in_flight) {
+        frame.holders[tile_index]--;
+        // tiles nobody else is rendering go to the front of the queue, to be handed out next.
+        if (!frame.finished[tile_index] && frame.holders[tile_index] == 0) {
+            frame.queue.push_front(tile_index);
+            reassigned++;
+        }
+    }
+    std::cout << worker.name << " " << reason << "; " << reassigned << " tile(s) reassigned." << std::endl;
+    m_workers.erase(m_workers.begin() + static_cast<std::ptrdiff_t>(index));
+}
+
+void TileCoordinator::render(RenderJob job, const std::vector<Tile>& tiles, const std::function<void(const TileResult&)>& on_result) {
+    job.id = m_next_job++;
+    Frame frame;
+    frame.job = &job;
+    frame.tiles = &tiles;
+    for (uint32_t t = 0; t < tiles.size(); ++t) {
+        frame.queue.push_back(t);
+    }
+    frame.finished.assign(tiles.size(), false);
+    frame.holders.assign(tiles.size(), 0);
+    frame.sent_at.assign(tiles.size(), std::chrono::steady_clock::now());
+    frame.remaining = tiles.size();
+
+    // workers still connected from an earlier frame are sent the new job straight away.
+    for (size_t i = m_workers.size(); i-- > 0;) {
+        m_workers[i].ready = false;
+        m_workers[i].in_flight.clear();
+        MessageWriter writer;
+        write_job(writer, job);
+        if (!send_message(m_workers[i].socket, MSG_JOB, writer)) {
+            dropWorker(i, frame, "disconnected");
+        }
+    }
+
+    bool reported_waiting = false;
+    while (frame.remaining > 0) {
+        if (m_workers.empty() && !reported_waiting) {
+            std::cout << "Waiting for workers to connect to " << m_address << "..." << std::endl;
+            reported_waiting = true;
+        }
+
+        std::vector<pollfd> entries;
+        entries.push_back({m_listener.fd(), POLLIN, 0});
+        for (const Worker& worker : m_workers) {
+            entries.push_back({worker.socket.fd(), POLLIN, 0});
+        }
+        ::poll(entries.data(), entries.size(), 500);
+
+        // goes backwards, so dropping a worker does not move the ones still to be checked.
+        // only the bytes that have arrived are read, so a worker that stalls partway through a message is timed out below.
+        for (size_t i = m_workers.size(); i-- > 0;) {
+            if (entries[i + 1].revents != 0 && !receiveMessages(m_workers[i], frame, on_result)) {
+                dropWorker(i, frame, "disconnected");
+            }
+        }
+        if (entries[0].revents & POLLIN) {
+            acceptWorker();
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (size_t i = m_workers.size(); i-- > 0;) {
+            Worker& worker = m_workers[i];
+            double idle = std::chrono::duration<double>(now - worker.last_progress).count();
+            if (m_timeout_seconds > 0.0 && !worker.in_flight.empty() && idle > m_timeout_seconds) {
+                dropWorker(i, frame, "timed out");
+            } else if (frame.remaining > 0 && !topUp(worker, frame)) {
+                dropWorker(i, frame, "disconnected");
+            }
+        }
+    }
+
+    // tells the workers the frame is finished, so they skip any duplicate tiles still queued.
+    for (size_t i = m_workers.size(); i-- > 0;) {
+        m_workers[i].in_flight.clear();
+        m_workers[i].ready = false;
+        MessageWriter writer;
+        writer.u32(job.id);
+        if (!send_message(m_workers[i].socket, MSG_DONE, writer)) {
+            m_workers.erase(m_workers.begin() + static_cast<std::ptrdiff_t>(i));
+        }
+    }
+}
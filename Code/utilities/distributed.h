@@ -0,0 +1,134 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_DISTRIBUTED_H
+#define B216602_DISTRIBUTED_H
+
+#include "net.h"
+#include "tile_scheduler.h"
+#include "Image.h"
+#include "scene.h"
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// the messages between a coordinator and its workers. a worker connects and says hello, is sent the job, loads the
+// scene and replies that it is ready, then is sent tiles and returns their pixels until the job is done.
+// when the coordinator exits, it tells its workers to exit too.
+const uint32_t PROTOCOL_VERSION = 3;
+const uint32_t MSG_HELLO = 1;   // worker to coordinator: protocol version and thread count.
+const uint32_t MSG_JOB = 2;     // coordinator to worker: the scene and the command line to render it with.
+const uint32_t MSG_READY = 3;   // worker to coordinator: the job's scene is loaded.
+const uint32_t MSG_TILE = 4;    // coordinator to worker: a tile to render.
+const uint32_t MSG_RESULT = 5;  // worker to coordinator: a rendered tile.
+const uint32_t MSG_DONE = 6;    // coordinator to worker: every tile of the job has been rendered.
+const uint32_t MSG_SHUTDOWN = 7; // coordinator to worker: there are no more jobs.
+
+// a frame to render. workers apply the coordinator's command line arguments, so they render with the same settings.
+struct RenderJob {
+    uint32_t id = 0;
+    std::string scene_path;
+    bool use_bvh = true;
+    std::vector<std::string> args;
+    // the frame's number and scene overrides, which change from frame to frame in a batch.
+    uint32_t frame_number = 0;
+    std::vector<SceneOverride> overrides;
+};
+
+struct TileRequest {
+    uint32_t job = 0;
+    uint32_t tile_index = 0;
+    Tile tile{0, 0, 0, 0};
+};
+
+// a rendered tile: its pixels and the samples each pixel took, row by row, and the work it took.
+struct TileResult {
+    uint32_t job = 0;
+    uint32_t tile_index = 0;
+    uint64_t samples = 0;
+    uint64_t rays = 0;
+    std::vector<Pixel> pixels;
+    std::vector<uint32_t> sample_counts;
+};
+
+void write_job(MessageWriter& writer, const RenderJob& job);
+RenderJob read_job(MessageReader& reader);
+void write_tile_request(MessageWriter& writer, const TileRequest& request);
+TileRequest read_tile_request(MessageReader& reader);
+void write_tile_result(MessageWriter& writer, const TileResult& result);
+TileResult read_tile_result(MessageReader& reader);
+
+// receives the next tiles a worker should render: waits for one message, then takes every further message that has
+// already arrived, so a worker with many threads can render several tiles at once.
+// 'done' is set when the coordinator finishes the job, and 'shutdown' as well when it has exited.
+// returns false if the connection is lost.
+bool receive_tile_batch(const Socket& connection, std::vector<TileRequest>& batch, bool& done, bool& shutdown);
+
+// reads the messages that have already arrived on a worker's connection, after a send to the coordinator failed.
+// returns true if the coordinator told the worker to shut down before it closed the connection.
+bool received_shutdown(const Socket& connection);
+
+// hands the tiles of a frame out to worker processes and collects the results.
+// workers can connect at any time, and each is kept a few tiles ahead so it never waits for the network.
+// the tiles of a worker that disconnects, or that makes no progress for the timeout, go back in the queue,
+// and once the queue is empty, idle workers are also given the oldest unfinished tiles, so a slow worker
+// does not hold up the end of the frame. the first result to arrive for a tile is used.
+class TileCoordinator {
+public:
+    // listens for workers on an address ("host:port" or "unix:<path>").
+    TileCoordinator(const std::string& address, double worker_timeout_seconds);
+    // tells the connected workers to exit.
+    ~TileCoordinator();
+    TileCoordinator(const TileCoordinator&) = delete;
+    TileCoordinator& operator=(const TileCoordinator&) = delete;
+
+    // renders every tile of the job, calling on_result on this thread once for each tile.
+    void render(RenderJob job, const std::vector<Tile>& tiles, const std::function<void(const TileResult&)>& on_result);
+
+private:
+    struct Worker {
+        Socket socket;
+        // the part of a message that has arrived so far, so a worker that stalls mid-message cannot block the coordinator.
+        MessageReceiver receiver;
+        std::string name;
+        int threads = 1;
+        bool ready = false;
+        std::vector<uint32_t> in_flight;
+        // when the worker last returned a tile, or was given one while idle.
+        std::chrono::steady_clock::time_point last_progress;
+    };
+
+    // the state of the frame being rendered.
+    struct Frame {
+        const RenderJob* job;
+        const std::vector<Tile>* tiles;
+        std::deque<uint32_t> queue;
+        std::vector<bool> finished;
+        std::vector<int> holders;
+        std::vector<std::chrono::steady_clock::time_point> sent_at;
+        size_t remaining;
+    };
+
+    void acceptWorker();
+    // reads what a worker has sent and handles every complete message. returns false if the worker should be dropped.
+    bool receiveMessages(Worker& worker, Frame& frame, const std::function<void(const TileResult&)>& on_result);
+    // handles one message from a worker. returns false if the worker should be dropped.
+    bool handleMessage(Worker& worker, Frame& frame, uint32_t type, const std::vector<unsigned char>& payload,
+                       const std::function<void(const TileResult&)>& on_result);
+    // keeps the worker supplied with tiles. returns false if the worker should be dropped.
+    bool topUp(Worker& worker, Frame& frame);
+    void dropWorker(size_t index, Frame& frame, const std::string& reason);
+
+    std::string m_address;
+    double m_timeout_seconds;
+    Socket m_listener;
+    std::vector<Worker> m_workers;
+    uint32_t m_next_job = 1;
+    int m_connections = 0;
+};
+
+#endif //B216602_DISTRIBUTED_H
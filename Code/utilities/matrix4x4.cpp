@@ -1,7 +1,8 @@
 #include "matrix4x4.h"
 
 // Default constructor: Identity Matrix
-Matrix4x4::Matrix4x4() {
+template <typename T>
+Matrix4x4T<T>::Matrix4x4T() {
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
             m[i][j] = (i == j) ? 1.0 : 0.0;
@@ -11,24 +12,27 @@ Matrix4x4::Matrix4x4() {
 
 // Static Methods, creating 4x4 matrices that represent the type of transformation
 
-Matrix4x4 Matrix4x4::createTranslation(const Vector3& t) {
-    Matrix4x4 mat; // Starts as identity
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::createTranslation(const Vector3T<T>& t) {
+    Matrix4x4T mat; // Starts as identity
     mat.m[0][3] = t.x;
     mat.m[1][3] = t.y;
     mat.m[2][3] = t.z;
     return mat;
 }
 
-Matrix4x4 Matrix4x4::createScale(const Vector3& s) {
-    Matrix4x4 mat; // Starts as identity
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::createScale(const Vector3T<T>& s) {
+    Matrix4x4T mat; // Starts as identity
     mat.m[0][0] = s.x;
     mat.m[1][1] = s.y;
     mat.m[2][2] = s.z;
     return mat;
 }
 
-Matrix4x4 Matrix4x4::createRotationX(double radians) {
-    Matrix4x4 mat; // Starts as identity
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::createRotationX(double radians) {
+    Matrix4x4T mat; // Starts as identity
     double c = std::cos(radians);
     double s = std::sin(radians);
     mat.m[1][1] = c;
@@ -38,8 +42,9 @@ Matrix4x4 Matrix4x4::createRotationX(double radians) {
     return mat;
 }
 
-Matrix4x4 Matrix4x4::createRotationY(double radians) {
-    Matrix4x4 mat; // Starts as identity
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::createRotationY(double radians) {
+    Matrix4x4T mat; // Starts as identity
     double c = std::cos(radians);
     double s = std::sin(radians);
     mat.m[0][0] = c;
@@ -49,8 +54,9 @@ Matrix4x4 Matrix4x4::createRotationY(double radians) {
     return mat;
 }
 
-Matrix4x4 Matrix4x4::createRotationZ(double radians) {
-    Matrix4x4 mat; // Starts as identity
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::createRotationZ(double radians) {
+    Matrix4x4T mat; // Starts as identity
     double c = std::cos(radians);
     double s = std::sin(radians);
     mat.m[0][0] = c;
@@ -63,8 +69,9 @@ Matrix4x4 Matrix4x4::createRotationZ(double radians) {
 // Operator Overloads
 
 // Multiplication of a matrix by a matrix
-Matrix4x4 Matrix4x4::operator*(const Matrix4x4& other) const {
-    Matrix4x4 result;
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::operator*(const Matrix4x4T& other) const {
+    Matrix4x4T result;
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
             result.m[i][j] = 0.0;
@@ -77,7 +84,8 @@ Matrix4x4 Matrix4x4::operator*(const Matrix4x4& other) const {
 }
 
 // Multiplication of a vector by a matrix. Transforms a point
-Vector3 Matrix4x4::operator*(const Vector3& v) const {
+template <typename T>
+Vector3T<T> Matrix4x4T<T>::operator*(const Vector3T<T>& v) const {
     // treats the 3D point as a 4D vector (homogeneous coordinates). W = 1.
     double x = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z + m[0][3];
     double y = m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z + m[1][3];
@@ -86,24 +94,26 @@ Vector3 Matrix4x4::operator*(const Vector3& v) const {
 
     // Preparation for perspective projection, when w might not be 1.
     if (w != 0.0 && w != 1.0) {
-        return Vector3(x / w, y / w, z / w);
+        return Vector3T<T>(x / w, y / w, z / w);
     }
     // If w is 1 then can just return the 3D vector as is.
-    return Vector3(x, y, z);
+    return Vector3T<T>(x, y, z);
 }
 
 // Utility Methods
 
 // Transform a direction
-Vector3 Matrix4x4::transformDirection(const Vector3& v) const {
+template <typename T>
+Vector3T<T> Matrix4x4T<T>::transformDirection(const Vector3T<T>& v) const {
     double x = m[0][0] * v.x + m[0][1] * v.y + m[0][2] * v.z;
     double y = m[1][0] * v.x + m[1][1] * v.y + m[1][2] * v.z;
     double z = m[2][0] * v.x + m[2][1] * v.y + m[2][2] * v.z;
-    return Vector3(x, y, z);
+    return Vector3T<T>(x, y, z);
 }
 
-Matrix4x4 Matrix4x4::transpose() const {
-    Matrix4x4 result;
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::transpose() const {
+    Matrix4x4T result;
     for (int i = 0; i < 4; ++i) {
         for (int j = 0; j < 4; ++j) {
             result.m[i][j] = m[j][i];
@@ -113,8 +123,9 @@ Matrix4x4 Matrix4x4::transpose() const {
 }
 
 // Full 4x4 Matrix Inversion
-Matrix4x4 Matrix4x4::inverse() const {
-    Matrix4x4 inv;
+template <typename T>
+Matrix4x4T<T> Matrix4x4T<T>::inverse() const {
+    Matrix4x4T inv;
     double det;
 
     inv.m[0][0] = m[1][1] * m[2][2] * m[3][3] - m[1][1] * m[2][3] * m[3][2] - m[2][1] * m[1][2] * m[3][3] + m[2][1] * m[1][3] * m[3][2] + m[3][1] * m[1][2] * m[2][3] - m[3][1] * m[1][3] * m[2][2];
@@ -149,4 +160,8 @@ Matrix4x4 Matrix4x4::inverse() const {
     }
 
     return inv;
-}
\ No newline at end of file
+}
+
+// compiles the matrix for both scalar types, so the definitions can stay out of the header.
+template class Matrix4x4T<float>;
+template class Matrix4x4T<double>;
@@ -6,36 +6,44 @@
 #include <stdexcept>
 
 
-class Matrix4x4 {
+template <typename T>
+class Matrix4x4T {
 public:
-    double m[4][4];
+    T m[4][4];
 
     // Default constructor (initializes to Identity)
-    Matrix4x4();
+    Matrix4x4T();
 
     // Declares static methods belonging to the Matrix4x4 class.
-    static Matrix4x4 createTranslation(const Vector3& t);
-    static Matrix4x4 createScale(const Vector3& s);
-    static Matrix4x4 createRotationX(double radians);
-    static Matrix4x4 createRotationY(double radians);
-    static Matrix4x4 createRotationZ(double radians);
+    static Matrix4x4T createTranslation(const Vector3T<T>& t);
+    static Matrix4x4T createScale(const Vector3T<T>& s);
+    static Matrix4x4T createRotationX(double radians);
+    static Matrix4x4T createRotationY(double radians);
+    static Matrix4x4T createRotationZ(double radians);
 
 
     // Matrix-Matrix Multiplication
-    Matrix4x4 operator*(const Matrix4x4& other) const;
+    Matrix4x4T operator*(const Matrix4x4T& other) const;
 
     // Matrix-Vector Multiplication to transform a point.
-    Vector3 operator*(const Vector3& v) const;
+    Vector3T<T> operator*(const Vector3T<T>& v) const;
 
     //Transforms a direction vector (w=0).
-    Vector3 transformDirection(const Vector3& v) const;
+    Vector3T<T> transformDirection(const Vector3T<T>& v) const;
 
     // Calculates the transpose of the matrix.
-    Matrix4x4 transpose() const;
+    Matrix4x4T transpose() const;
 
     //Calculates the inverse of the matrix.
     //Throws a runtime_error if the matrix is singular (not invertible).
-    Matrix4x4 inverse() const;
+    Matrix4x4T inverse() const;
 };
 
+// the definitions are compiled once for each scalar type in matrix4x4.cpp.
+extern template class Matrix4x4T<float>;
+extern template class Matrix4x4T<double>;
+
+// the matrix type used throughout the renderer, at the precision selected for the build.
+using Matrix4x4 = Matrix4x4T<Real>;
+
 #endif //B216602_MATRIX4X4_H
\ No newline at end of file
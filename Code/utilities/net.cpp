@@ -0,0 +1,290 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "net.h"
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// the largest payload accepted, so a corrupt length cannot make the receiver allocate without limit.
+static const uint32_t MAX_PAYLOAD_BYTES = 256u * 1024u * 1024u;
+
+Socket& Socket::operator=(Socket&& other) noexcept {
+    if (this != &other) {
+        close();
+        m_fd = other.m_fd;
+        other.m_fd = -1;
+    }
+    return *this;
+}
+
+void Socket::close() {
+    if (m_fd >= 0) {
+        ::close(m_fd);
+        m_fd = -1;
+    }
+}
+
+// splits "host:port" at the last colon.
+static void split_host_port(const std::string& address, std::string& host, std::string& port) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos) {
+        throw std::runtime_error("Address '" + address + "' must be host:port or unix:<path>.");
+    }
+    host = address.substr(0, colon);
+    port = address.substr(colon + 1);
+}
+
+static bool is_unix_address(const std::string& address, sockaddr_un& unix_address) {
+    if (address.rfind("unix:", 0) != 0) {
+        return false;
+    }
+    std::string path = address.substr(5);
+    if (path.empty() || path.size() >= sizeof(unix_address.sun_path)) {
+        throw std::runtime_error("Invalid unix socket path in '" + address + "'.");
+    }
+    std::memset(&unix_address, 0, sizeof(unix_address));
+    unix_address.sun_family = AF_UNIX;
+    std::memcpy(unix_address.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+Socket listen_on(const std::string& address) {
+    sockaddr_un unix_address;
+    if (is_unix_address(address, unix_address)) {
+        // removes a socket file left behind by an earlier coordinator. anything else at the path is left alone.
+        struct stat existing;
+        if (::lstat(unix_address.sun_path, &existing) == 0) {
+            if (!S_ISSOCK(existing.st_mode)) {
+                throw std::runtime_error("Cannot listen on '" + address + "': the path exists and is not a socket.");
+            }
+            ::unlink(unix_address.sun_path);
+        }
+        Socket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!socket.valid() || ::bind(socket.fd(), reinterpret_cast<sockaddr*>(&unix_address), sizeof(unix_address)) != 0
+            || ::listen(socket.fd(), 64) != 0) {
+            throw std::runtime_error("Cannot listen on '" + address + "': " + std::strerror(errno));
+        }
+        return socket;
+    }
+
+    std::string host, port;
+    split_host_port(address, host, port);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_flags = AI_PASSIVE;
+    addrinfo* results = nullptr;
+    if (::getaddrinfo(host.empty() ? nullptr : host.c_str(), port.c_str(), &hints, &results) != 0) {
+        throw std::runtime_error("Cannot resolve '" + address + "'.");
+    }
+    for (addrinfo* info = results; info; info = info->ai_next) {
+        Socket socket(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        if (!socket.valid()) {
+            continue;
+        }
+        // lets a restarted coordinator listen on the port again straight away.
+        int reuse = 1;
+        ::setsockopt(socket.fd(), SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+        if (::bind(socket.fd(), info->ai_addr, info->ai_addrlen) == 0 && ::listen(socket.fd(), 64) == 0) {
+            ::freeaddrinfo(results);
+            return socket;
+        }
+    }
+    ::freeaddrinfo(results);
+    throw std::runtime_error("Cannot listen on '" + address + "': " + std::strerror(errno));
+}
+
+Socket connect_to(const std::string& address) {
+    sockaddr_un unix_address;
+    if (is_unix_address(address, unix_address)) {
+        Socket socket(::socket(AF_UNIX, SOCK_STREAM, 0));
+        if (!socket.valid() || ::connect(socket.fd(), reinterpret_cast<sockaddr*>(&unix_address), sizeof(unix_address)) != 0) {
+            throw std::runtime_error("Cannot connect to '" + address + "': " + std::strerror(errno));
+        }
+        return socket;
+    }
+
+    std::string host, port;
+    split_host_port(address, host, port);
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (::getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) {
+        throw std::runtime_error("Cannot resolve '" + address + "'.");
+    }
+    for (addrinfo* info = results; info; info = info->ai_next) {
+        Socket socket(::socket(info->ai_family, info->ai_socktype, info->ai_protocol));
+        if (socket.valid() && ::connect(socket.fd(), info->ai_addr, info->ai_addrlen) == 0) {
+            ::freeaddrinfo(results);
+            return socket;
+        }
+    }
+    ::freeaddrinfo(results);
+    throw std::runtime_error("Cannot connect to '" + address + "': " + std::strerror(errno));
+}
+
+Socket accept_connection(const Socket& listener) {
+    return Socket(::accept(listener.fd(), nullptr, nullptr));
+}
+
+bool wait_readable(const Socket& socket, int timeout_ms) {
+    pollfd entry{socket.fd(), POLLIN, 0};
+    return ::poll(&entry, 1, timeout_ms) > 0;
+}
+
+void set_send_timeout(const Socket& socket, double seconds) {
+    timeval timeout{};
+    timeout.tv_sec = static_cast<time_t>(seconds);
+    timeout.tv_usec = static_cast<suseconds_t>((seconds - static_cast<double>(timeout.tv_sec)) * 1e6);
+    ::setsockopt(socket.fd(), SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+}
+
+void MessageWriter::u32(uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        m_data.push_back(static_cast<unsigned char>(value >> (8 * i)));
+    }
+}
+
+void MessageWriter::u64(uint64_t value) {
+    u32(static_cast<uint32_t>(value));
+    u32(static_cast<uint32_t>(value >> 32));
+}
+
+void MessageWriter::string(const std::string& text) {
+    u32(static_cast<uint32_t>(text.size()));
+    bytes(text.data(), text.size());
+}
+
+void MessageWriter::bytes(const void* data, size_t size) {
+    const unsigned char* begin = static_cast<const unsigned char*>(data);
+    m_data.insert(m_data.end(), begin, begin + size);
+}
+
+void MessageReader::bytes(void* data, size_t size) {
+    if (size > m_data.size() - m_offset) {
+        throw std::runtime_error("Message is shorter than expected.");
+    }
+    std::memcpy(data, m_data.data() + m_offset, size);
+    m_offset += size;
+}
+
+uint32_t MessageReader::u32() {
+    unsigned char raw[4];
+    bytes(raw, 4);
+    return static_cast<uint32_t>(raw[0]) | (static_cast<uint32_t>(raw[1]) << 8)
+         | (static_cast<uint32_t>(raw[2]) << 16) | (static_cast<uint32_t>(raw[3]) << 24);
+}
+
+uint64_t MessageReader::u64() {
+    uint64_t low = u32();
+    uint64_t high = u32();
+    return low | (high << 32);
+}
+
+std::string MessageReader::string() {
+    std::string text(u32(), '\0');
+    bytes(text.data(), text.size());
+    return text;
+}
+
+// writes every byte, retrying after partial writes. MSG_NOSIGNAL stops a closed connection from raising SIGPIPE.
+static bool send_all(int fd, const unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t sent = ::send(fd, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        if (sent <= 0) {
+            return false;
+        }
+        data += sent;
+        size -= static_cast<size_t>(sent);
+    }
+    return true;
+}
+
+static bool receive_all(int fd, unsigned char* data, size_t size) {
+    while (size > 0) {
+        ssize_t received = ::recv(fd, data, size, 0);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        data += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+bool send_message(const Socket& socket, uint32_t type, const MessageWriter& payload) {
+    MessageWriter header;
+    header.u32(type);
+    header.u32(static_cast<uint32_t>(payload.data().size()));
+    return send_all(socket.fd(), header.data().data(), header.data().size())
+        && send_all(socket.fd(), payload.data().data(), payload.data().size());
+}
+
+bool receive_message(const Socket& socket, uint32_t& type, std::vector<unsigned char>& payload) {
+    std::vector<unsigned char> header(8);
+    if (!receive_all(socket.fd(), header.data(), header.size())) {
+        return false;
+    }
+    MessageReader reader(header);
+    type = reader.u32();
+    uint32_t length = reader.u32();
+    if (length > MAX_PAYLOAD_BYTES) {
+        return false;
+    }
+    payload.resize(length);
+    return receive_all(socket.fd(), payload.data(), payload.size());
+}
+
+bool MessageReceiver::receiveAvailable(const Socket& socket) {
+    unsigned char chunk[64 * 1024];
+    while (true) {
+        // MSG_DONTWAIT returns straight away once nothing more is waiting.
+        ssize_t received = ::recv(socket.fd(), chunk, sizeof(chunk), MSG_DONTWAIT);
+        if (received < 0 && errno == EINTR) {
+            continue;
+        }
+        if (received < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return true;
+        }
+        if (received <= 0) {
+            return false;
+        }
+        m_buffer.insert(m_buffer.end(), chunk, chunk + received);
+    }
+}
+
+bool MessageReceiver::next(uint32_t& type, std::vector<unsigned char>& payload) {
+    if (m_buffer.size() < 8) {
+        return false;
+    }
+    std::vector<unsigned char> header(m_buffer.begin(), m_buffer.begin() + 8);
+    MessageReader reader(header);
+    type = reader.u32();
+    uint32_t length = reader.u32();
+    if (length > MAX_PAYLOAD_BYTES) {
+        throw std::runtime_error("Message is longer than the largest payload accepted.");
+    }
+    if (m_buffer.size() - 8 < length) {
+        return false;
+    }
+    payload.assign(m_buffer.begin() + 8, m_buffer.begin() + 8 + length);
+    m_buffer.erase(m_buffer.begin(), m_buffer.begin() + 8 + length);
+    return true;
+}
@@ -0,0 +1,90 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_NET_H
+#define B216602_NET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// a socket, closed when it is destroyed. it can be moved but not copied, so each socket has one owner.
+class Socket {
+public:
+    Socket() = default;
+    explicit Socket(int fd) : m_fd(fd) {}
+    ~Socket() { close(); }
+    Socket(Socket&& other) noexcept : m_fd(other.m_fd) { other.m_fd = -1; }
+    Socket& operator=(Socket&& other) noexcept;
+    Socket(const Socket&) = delete;
+    Socket& operator=(const Socket&) = delete;
+
+    int fd() const { return m_fd; }
+    bool valid() const { return m_fd >= 0; }
+    void close();
+
+private:
+    int m_fd = -1;
+};
+
+// addresses are either "unix:<path>" for a unix domain socket, or "<host>:<port>" for tcp.
+// listens on an address, throwing std::runtime_error if it cannot.
+Socket listen_on(const std::string& address);
+// connects to an address, throwing std::runtime_error if it cannot.
+Socket connect_to(const std::string& address);
+// accepts a pending connection. returns an invalid socket on failure.
+Socket accept_connection(const Socket& listener);
+// waits up to 'timeout_ms' for the socket to have data (or be closed by the other side).
+bool wait_readable(const Socket& socket, int timeout_ms);
+// makes sends on the socket fail after 'seconds' without progress, instead of blocking for ever. 0 never times out.
+void set_send_timeout(const Socket& socket, double seconds);
+
+// builds the payload of a message. numbers are written little-endian, so any two hosts agree on the layout.
+class MessageWriter {
+public:
+    void u32(uint32_t value);
+    void u64(uint64_t value);
+    void string(const std::string& text);
+    void bytes(const void* data, size_t size);
+    const std::vector<unsigned char>& data() const { return m_data; }
+
+private:
+    std::vector<unsigned char> m_data;
+};
+
+// reads a payload in the order it was written. throws std::runtime_error if the payload is too short.
+class MessageReader {
+public:
+    explicit MessageReader(const std::vector<unsigned char>& data) : m_data(data) {}
+    uint32_t u32();
+    uint64_t u64();
+    std::string string();
+    void bytes(void* data, size_t size);
+
+private:
+    const std::vector<unsigned char>& m_data;
+    size_t m_offset = 0;
+};
+
+// sends a message: its type, the payload length and the payload. returns false if the connection is lost.
+bool send_message(const Socket& socket, uint32_t type, const MessageWriter& payload);
+// receives a whole message. returns false if the connection is closed or lost.
+bool receive_message(const Socket& socket, uint32_t& type, std::vector<unsigned char>& payload);
+
+// collects the messages of one connection without blocking, so a peer that stops halfway through a message cannot
+// stall the receiver. the bytes read so far are kept until the rest of their message arrives.
+class MessageReceiver {
+public:
+    // reads whatever has arrived on the socket. returns false if the connection is closed or lost.
+    bool receiveAvailable(const Socket& socket);
+    // takes the next complete message, returning false if none has fully arrived.
+    // throws std::runtime_error if the message is longer than any valid message.
+    bool next(uint32_t& type, std::vector<unsigned char>& payload);
+
+private:
+    std::vector<unsigned char> m_buffer;
+};
+
+#endif //B216602_NET_H
@@ -0,0 +1,195 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "numa.h"
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+#ifdef __linux__
+    #include <sched.h>
+    #include <unistd.h>
+    #include <sys/syscall.h>
+    #include <linux/mempolicy.h>
+#endif
+
+// the cpus the process may run on. without affinity support, every cpu is assumed to be available.
+static std::vector<int> allowed_cpus() {
+    std::vector<int> cpus;
+    #ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+    #endif
+    if (cpus.empty()) {
+        int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < count; ++cpu) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+// parses a kernel cpu list such as "0-3,8-11".
+static std::vector<int> parse_cpu_list(const std::string& list) {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        try {
+            size_t dash = range.find('-');
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        } catch (const std::exception&) {
+            // skips anything that is not a number, such as the trailing newline.
+        }
+    }
+    return cpus;
+}
+
+NumaTopology detect_numa_topology() {
+    NumaTopology topology;
+    std::vector<int> allowed = allowed_cpus();
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator("/sys/devices/system/node", error)) {
+        std::string name = entry.path().filename().string();
+        if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::isdigit(static_cast<unsigned char>(name[4]))) {
+            continue;
+        }
+        std::ifstream file(entry.path() / "cpulist");
+        std::string list;
+        std::getline(file, list);
+        std::vector<int> cpus;
+        for (int cpu : parse_cpu_list(list)) {
+            if (std::find(allowed.begin(), allowed.end(), cpu) != allowed.end()) {
+                cpus.push_back(cpu);
+            }
+        }
+        // nodes with only memory, or whose cpus this process may not use, get no workers.
+        if (!cpus.empty()) {
+            topology.node_ids.push_back(std::stoi(name.substr(4)));
+            topology.node_cpus.push_back(cpus);
+        }
+    }
+
+    if (topology.node_cpus.empty()) {
+        topology.node_ids = {-1};
+        topology.node_cpus = {allowed};
+        return topology;
+    }
+
+    // the directory is not listed in order, so the nodes are sorted by number.
+    std::vector<size_t> order(topology.node_ids.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return topology.node_ids[a] < topology.node_ids[b]; });
+    NumaTopology sorted;
+    for (size_t i : order) {
+        sorted.node_ids.push_back(topology.node_ids[i]);
+        sorted.node_cpus.push_back(topology.node_cpus[i]);
+    }
+    return sorted;
+}
+
+std::vector<int> worker_cpus(const NumaTopology& topology, int threads) {
+    std::vector<int> all;
+    for (const std::vector<int>& cpus : topology.node_cpus) {
+        all.insert(all.end(), cpus.begin(), cpus.end());
+    }
+    std::vector<int> assigned;
+    if (all.empty()) {
+        return assigned;
+    }
+    // with more workers than cpus, the extra workers wrap around and share.
+    for (int worker = 0; worker < threads; ++worker) {
+        size_t index = threads <= static_cast<int>(all.size())
+                       ? static_cast<size_t>(worker) * all.size() / threads
+                       : static_cast<size_t>(worker) % all.size();
+        assigned.push_back(all[index]);
+    }
+    return assigned;
+}
+
+bool pin_current_thread(int cpu) {
+    #ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return sched_setaffinity(0, sizeof(set), &set) == 0;
+    #else
+    (void)cpu;
+    return false;
+    #endif
+}
+
+CpuPinScope::CpuPinScope(int cpu) {
+    #ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int c = 0; c < CPU_SETSIZE; ++c) {
+            if (CPU_ISSET(c, &set)) {
+                m_previous_cpus.push_back(c);
+            }
+        }
+    }
+    #endif
+    pin_current_thread(cpu);
+}
+
+CpuPinScope::~CpuPinScope() {
+    #ifdef __linux__
+    if (!m_previous_cpus.empty()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : m_previous_cpus) {
+            CPU_SET(cpu, &set);
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+    #endif
+}
+
+MemoryInterleaveScope::MemoryInterleaveScope(const NumaTopology& topology) {
+    #ifdef __linux__
+    if (topology.node_ids.size() < 2) {
+        return;
+    }
+    // the node mask is an array of bits, one per node number.
+    const size_t bits_per_word = sizeof(unsigned long) * 8;
+    int highest = *std::max_element(topology.node_ids.begin(), topology.node_ids.end());
+    std::vector<unsigned long> mask(highest / bits_per_word + 1, 0);
+    for (int node : topology.node_ids) {
+        mask[node / bits_per_word] |= 1ul << (node % bits_per_word);
+    }
+    // the kernel reads one bit fewer than the count it is given.
+    unsigned long max_node = mask.size() * bits_per_word + 1;
+    m_active = syscall(SYS_set_mempolicy, MPOL_INTERLEAVE, mask.data(), max_node) == 0;
+    #else
+    (void)topology;
+    #endif
+}
+
+MemoryInterleaveScope::~MemoryInterleaveScope() {
+    #ifdef __linux__
+    if (m_active) {
+        syscall(SYS_set_mempolicy, MPOL_DEFAULT, nullptr, 0);
+    }
+    #endif
+}
@@ -0,0 +1,86 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_NUMA_H
+#define B216602_NUMA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+// the cpus of each numa node (memory controller and the cores attached to it) that this process may run on.
+// on a single-socket machine, or where the topology cannot be read, there is one node holding every cpu.
+struct NumaTopology {
+    // the operating system's number for each node, or -1 for the single node assumed when there is no topology.
+    std::vector<int> node_ids;
+    std::vector<std::vector<int>> node_cpus;
+};
+
+// reads the topology from /sys/devices/system/node, keeping only the cpus in the process's affinity mask.
+NumaTopology detect_numa_topology();
+
+// picks a cpu for each of 'threads' workers. the cpus are listed node by node and the workers spread evenly over
+// the list, so neighbouring workers (which start on neighbouring tiles) share a node and every node gets a fair share.
+std::vector<int> worker_cpus(const NumaTopology& topology, int threads);
+
+// restricts the calling thread to a single cpu. returns false where pinning is not supported.
+bool pin_current_thread(int cpu);
+
+// pins the calling thread to a cpu until the scope ends, then restores the cpus it was allowed to run on before.
+class CpuPinScope {
+public:
+    explicit CpuPinScope(int cpu);
+    ~CpuPinScope();
+    CpuPinScope(const CpuPinScope&) = delete;
+    CpuPinScope& operator=(const CpuPinScope&) = delete;
+
+private:
+    std::vector<int> m_previous_cpus;
+};
+
+// spreads the pages the calling thread allocates over every numa node, one page per node in turn, until the scope ends.
+// used while loading the scene, so the bvh, geometry and textures that every thread reads are not all placed on
+// the loading thread's node, where the other sockets would have to fetch every access remotely.
+class MemoryInterleaveScope {
+public:
+    explicit MemoryInterleaveScope(const NumaTopology& topology);
+    ~MemoryInterleaveScope();
+    MemoryInterleaveScope(const MemoryInterleaveScope&) = delete;
+    MemoryInterleaveScope& operator=(const MemoryInterleaveScope&) = delete;
+
+    // whether the policy was applied: it is skipped on a single node, and where it is not supported.
+    bool active() const { return m_active; }
+
+private:
+    bool m_active = false;
+};
+
+// an array whose elements are not written when it is allocated. the operating system places each page on the
+// numa node of the thread that first writes it, so a buffer whose elements are first initialised by the thread that
+// renders them ends up in that thread's local memory. every element must be initialised before it is read.
+template <typename T>
+class FirstTouchArray {
+    static_assert(std::is_trivially_destructible_v<T>, "elements are never destroyed individually");
+
+public:
+    explicit FirstTouchArray(size_t size) : m_size(size), m_data(std::allocator<T>().allocate(size)) {}
+    ~FirstTouchArray() { std::allocator<T>().deallocate(m_data, m_size); }
+    FirstTouchArray(const FirstTouchArray&) = delete;
+    FirstTouchArray& operator=(const FirstTouchArray&) = delete;
+
+    // constructs element i, which places its page if this is the first write to it.
+    void initialise(size_t i, const T& value) { new (m_data + i) T(value); }
+
+    T& operator[](size_t i) { return m_data[i]; }
+    const T& operator[](size_t i) const { return m_data[i]; }
+    size_t size() const { return m_size; }
+
+private:
+    size_t m_size;
+    T* m_data;
+};
+
+#endif //B216602_NUMA_H
@@ -2,7 +2,8 @@
 // Created by alex on 20/11/2025.
 //
 
-#include <random>
+#include <array>
+#include <cstdint>
 
 
 #ifndef B216602_RANDOM_UTILS_H
@@ -10,10 +11,61 @@
 
 // this is in a new header to improve performance when generating random numbers across parallel threads
 
+// philox4x32-10 (salmon et al., "parallel random numbers: as easy as 1, 2, 3", 2011), a counter-based generator.
+// it hashes a 128-bit counter with a 64-bit key through ten rounds of multiplications, so any number can be computed
+// directly from where it is used (pixel, sample, dimension, frame) instead of advancing a shared state,
+// and the result does not depend on which thread computes it or in what order.
+inline std::array<uint32_t, 4> philox4x32(std::array<uint32_t, 4> counter, std::array<uint32_t, 2> key) {
+    for (int round = 0; round < 10; ++round) {
+        uint64_t product0 = static_cast<uint64_t>(0xD2511F53u) * counter[0];
+        uint64_t product1 = static_cast<uint64_t>(0xCD9E8D57u) * counter[2];
+        counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0], static_cast<uint32_t>(product1),
+                   static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1], static_cast<uint32_t>(product0)};
+        key[0] += 0x9E3779B9u;
+        key[1] += 0xBB67AE85u;
+    }
+    return counter;
+}
+
+// a stream of random numbers drawn from philox, for decisions that do not have a fixed sampler dimension.
+// the render reseeds it at the start of every pixel sample, so the stream only depends on that sample.
+class CounterRng {
+public:
+    // starts the stream for sample 'index' of pixel (x, y) in the given frame.
+    void seed(uint32_t x, uint32_t y, uint32_t index, uint32_t frame) {
+        m_counter = {x, y, index, 0};
+        m_key = {frame, STREAM_KEY};
+        m_used = 4;
+    }
+
+    // returns the next 32 random bits. each philox call gives four.
+    uint32_t next() {
+        if (m_used == 4) {
+            m_block = philox4x32(m_counter, m_key);
+            m_counter[3]++;
+            m_used = 0;
+        }
+        return m_block[m_used++];
+    }
+
+    // the key half reserved for this stream, so it never repeats the numbers of a sampler dimension.
+    static constexpr uint32_t STREAM_KEY = 0xFFFFFFFFu;
+
+private:
+    std::array<uint32_t, 4> m_counter = {0, 0, 0, 0};
+    std::array<uint32_t, 2> m_key = {0, STREAM_KEY};
+    std::array<uint32_t, 4> m_block = {0, 0, 0, 0};
+    int m_used = 4;
+};
+
+// the stream of the current thread.
+inline CounterRng& thread_rng() {
+    static thread_local CounterRng rng;
+    return rng;
+}
+
 inline double random_double() {
-    static thread_local std::mt19937 generator(std::random_device{}());
-    static thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
-    return distribution(generator);
+    return thread_rng().next() * (1.0 / 4294967296.0);
 }
 
 inline double random_double(double min, double max) {
@@ -21,9 +73,9 @@ inline double random_double(double min, double max) {
 }
 
 inline int random_int(int min, int max) {
-    static thread_local std::mt19937 generator(std::random_device{}());
-    std::uniform_int_distribution<int> distribution(min, max);
-    return distribution(generator);
+    // scales the 32 random bits to the range with a multiply instead of a modulo.
+    uint64_t range = static_cast<uint64_t>(static_cast<int64_t>(max) - min + 1);
+    return min + static_cast<int>((thread_rng().next() * range) >> 32);
 }
 
 inline Vector3 random_in_unit_sphere() {
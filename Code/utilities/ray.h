@@ -6,30 +6,46 @@
 #define B216602_RAY_H
 
 #include "vector3.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
 
 /**
  * @brief Represents a ray in 3D space: R(t) = origin + t * direction.
  * The direction vector (D) is normalized for use in later calculations.
  */
-struct Ray {
+template <typename T>
+struct RayT {
     // The starting point of the ray (the camera's location in world space).
-    Vector3 origin;
+    Vector3T<T> origin;
 
     // The unit vector defining the direction of the ray.
-    Vector3 direction;
+    Vector3T<T> direction;
 
     double time;
 
     // Constructor to create a Ray object
-    Ray(const Vector3& o, const Vector3& d, double t = 0.0) : origin(o), direction(d), time(t) {}
+    RayT(const Vector3T<T>& o, const Vector3T<T>& d, double t = 0.0) : origin(o), direction(d), time(t) {}
 
     // Default constructor
-    Ray() : origin(Vector3()), direction(Vector3()), time(0.0) {}
+    RayT() : origin(Vector3T<T>()), direction(Vector3T<T>()), time(0.0) {}
 
     //Returns a 3D point on the ray at distance t.
-    Vector3 point_at_parameter(double t) const {
-        return origin + (t * direction);
+    Vector3T<T> point_at_parameter(double t) const {
+        return origin + (static_cast<T>(t) * direction);
     }
 };
 
+// the ray type used throughout the renderer, at the precision selected for the build.
+using Ray = RayT<Real>;
+
+// returns the distance to offset a secondary ray origin from a surface at point p.
+// a stored position is only accurate to a fixed number of significant digits, so the offset grows with the
+// magnitude of p. in double precision this is always the configured epsilon; in float it avoids self-intersection far from the origin.
+inline double ray_offset_epsilon(const Vector3& p, double epsilon) {
+    double magnitude = std::max({std::abs(static_cast<double>(p.x)), std::abs(static_cast<double>(p.y)), std::abs(static_cast<double>(p.z)), 1.0});
+    // equation: offset = max(epsilon, magnitude * machine_epsilon * 64)
+    return std::max(epsilon, magnitude * std::numeric_limits<Real>::epsilon() * 64.0);
+}
+
 #endif //B216602_RAY_H
\ No newline at end of file
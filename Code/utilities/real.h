@@ -0,0 +1,17 @@
+//
+// Created by alex on 05/12/2025.
+//
+
+#ifndef B216602_REAL_H
+#define B216602_REAL_H
+
+// the scalar type used by the geometry types (vectors, rays, matrices, and bounding boxes).
+// single precision halves the memory traffic of traversal and shading, and is selected at build time
+// with the B216602_SINGLE_PRECISION cmake option.
+#ifdef B216602_SINGLE_PRECISION
+using Real = float;
+#else
+using Real = double;
+#endif
+
+#endif //B216602_REAL_H
@@ -0,0 +1,128 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "render_progress.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+
+// how far back the recent throughput is measured from.
+static const double THROUGHPUT_WINDOW_SECONDS = 10.0;
+
+// formats a number of seconds as e.g. "1h 02m", "3m 05s" or "12s".
+static std::string format_duration(double seconds) {
+    long long total = static_cast<long long>(seconds + 0.5);
+    std::stringstream ss;
+    if (total >= 3600) {
+        ss << total / 3600 << "h " << std::setw(2) << std::setfill('0') << (total % 3600) / 60 << "m";
+    } else if (total >= 60) {
+        ss << total / 60 << "m " << std::setw(2) << std::setfill('0') << total % 60 << "s";
+    } else {
+        ss << total << "s";
+    }
+    return ss.str();
+}
+
+ProgressReporter::ProgressReporter(int workers, uint64_t total_pixels, double interval_seconds)
+    : m_workers(std::max(1, workers)), m_total_pixels(std::max<uint64_t>(1, total_pixels)),
+      m_interval_seconds(interval_seconds), m_counters(new ProgressCounters[std::max(1, workers)]),
+      m_start(std::chrono::steady_clock::now()) {
+    m_history.push_back({0.0, Totals()});
+    // an interval of zero or less only prints the final totals.
+    if (m_interval_seconds > 0.0) {
+        m_thread = std::thread(&ProgressReporter::reporterLoop, this);
+    }
+}
+
+ProgressReporter::~ProgressReporter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_finished = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+ProgressReporter::Totals ProgressReporter::totals() const {
+    Totals totals;
+    for (int worker = 0; worker < m_workers; ++worker) {
+        totals.pixels += m_counters[worker].pixels.load(std::memory_order_relaxed);
+        totals.samples += m_counters[worker].samples.load(std::memory_order_relaxed);
+        totals.rays += m_counters[worker].rays.load(std::memory_order_relaxed);
+        totals.allocations += m_counters[worker].allocations.load(std::memory_order_relaxed);
+    }
+    return totals;
+}
+
+double ProgressReporter::elapsedSeconds() const {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_start).count();
+}
+
+void ProgressReporter::reporterLoop() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wake.wait_for(lock, std::chrono::duration<double>(m_interval_seconds), [&] { return m_finished; })) {
+        report();
+    }
+}
+
+void ProgressReporter::report() {
+    double now = elapsedSeconds();
+    Totals totals = this->totals();
+
+    // drops readings older than the window, keeping at least one to measure from.
+    m_history.push_back({now, totals});
+    while (m_history.size() > 2 && now - m_history[1].seconds >= THROUGHPUT_WINDOW_SECONDS) {
+        m_history.pop_front();
+    }
+    const Snapshot& oldest = m_history.front();
+    double window = now - oldest.seconds;
+    double pixel_rate = window > 0.0 ? (totals.pixels - oldest.totals.pixels) / window : 0.0;
+    double ray_rate = window > 0.0 ? (totals.rays - oldest.totals.rays) / window : 0.0;
+
+    // equation: eta = remaining pixels / recent pixels per second
+    std::stringstream ss;
+    int percent = static_cast<int>(std::min<uint64_t>(100, totals.pixels * 100 / m_total_pixels));
+    ss << "Rendering: " << percent << "% [" << totals.pixels << "/" << m_total_pixels << " pixels] "
+       << std::fixed << std::setprecision(2) << ray_rate / 1e6 << " Mrays/s, ETA ";
+    if (pixel_rate > 0.0) {
+        ss << format_duration((m_total_pixels - std::min(totals.pixels, m_total_pixels)) / pixel_rate);
+    } else {
+        ss << "--";
+    }
+
+    // pads over the end of a longer previous line.
+    std::string line = ss.str();
+    size_t length = line.size();
+    line.resize(std::max(length, m_last_line_length), ' ');
+    m_last_line_length = length;
+    std::cout << "\r" << line << std::flush;
+}
+
+void ProgressReporter::finish() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_finished) {
+            return;
+        }
+        m_finished = true;
+    }
+    m_wake.notify_one();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+
+    double seconds = elapsedSeconds();
+    Totals totals = this->totals();
+    std::stringstream ss;
+    ss << "Rendering: 100% [" << totals.pixels << "/" << m_total_pixels << " pixels] in " << format_duration(seconds) << ", "
+       << std::fixed << std::setprecision(2) << (seconds > 0.0 ? totals.rays / seconds / 1e6 : 0.0) << " Mrays/s, "
+       << static_cast<double>(totals.samples) / m_total_pixels << " samples/pixel";
+    std::string line = ss.str();
+    line.resize(std::max(line.size(), m_last_line_length), ' ');
+    std::cout << "\r" << line << std::endl;
+}
@@ -0,0 +1,111 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_RENDER_PROGRESS_H
+#define B216602_RENDER_PROGRESS_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+// the work one rendering thread has finished. only the owning thread writes its counters, so it updates them with
+// relaxed loads and stores rather than locked increments, and the reporter can read them at any time.
+// aligned so that each thread's counters sit on their own cache line.
+struct alignas(64) ProgressCounters {
+    std::atomic<uint64_t> pixels{0};
+    std::atomic<uint64_t> samples{0};
+    std::atomic<uint64_t> rays{0};
+    // heap allocations made while rendering tiles, only counted in builds with B216602_COUNT_ALLOCATIONS.
+    std::atomic<uint64_t> allocations{0};
+};
+
+// adds to a counter that only the calling thread writes.
+inline void add_count(std::atomic<uint64_t>& counter, uint64_t amount) {
+    counter.store(counter.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+}
+
+// the counters the current thread adds its work to, or null when nothing is being reported.
+inline ProgressCounters*& thread_progress() {
+    static thread_local ProgressCounters* counters = nullptr;
+    return counters;
+}
+
+// counts a ray cast by the current thread.
+inline void count_ray() {
+    ProgressCounters* counters = thread_progress();
+    if (counters) {
+        add_count(counters->rays, 1);
+    }
+}
+
+// installs counters for the current thread until the scope ends.
+class ProgressScope {
+public:
+    explicit ProgressScope(ProgressCounters* counters) : m_previous(thread_progress()) { thread_progress() = counters; }
+    ~ProgressScope() { thread_progress() = m_previous; }
+    ProgressScope(const ProgressScope&) = delete;
+    ProgressScope& operator=(const ProgressScope&) = delete;
+
+private:
+    ProgressCounters* m_previous;
+};
+
+// sums the counters of every rendering thread on a thread of its own, and prints the percentage complete,
+// the rays per second and an estimate of the time remaining at a fixed interval.
+// the estimate extrapolates from the pixels finished over the last few seconds rather than since the start,
+// so it follows changes in how expensive the remaining parts of the image are.
+class ProgressReporter {
+public:
+    // starts reporting on 'workers' threads' progress through 'total_pixels' pixels, every 'interval_seconds'.
+    ProgressReporter(int workers, uint64_t total_pixels, double interval_seconds);
+    ~ProgressReporter();
+    ProgressReporter(const ProgressReporter&) = delete;
+    ProgressReporter& operator=(const ProgressReporter&) = delete;
+
+    ProgressCounters& counters(int worker) { return m_counters[worker]; }
+
+    // stops the reporter and prints the totals for the whole render.
+    void finish();
+
+    struct Totals {
+        uint64_t pixels = 0;
+        uint64_t samples = 0;
+        uint64_t rays = 0;
+        uint64_t allocations = 0;
+    };
+    // sums every thread's counters so far.
+    Totals totals() const;
+
+private:
+    // a reading of the totals, kept to measure recent throughput.
+    struct Snapshot {
+        double seconds;
+        Totals totals;
+    };
+
+    double elapsedSeconds() const;
+    void reporterLoop();
+    void report();
+
+    int m_workers;
+    uint64_t m_total_pixels;
+    double m_interval_seconds;
+    std::unique_ptr<ProgressCounters[]> m_counters;
+    std::chrono::steady_clock::time_point m_start;
+    // the readings of the last few seconds, oldest first.
+    std::deque<Snapshot> m_history;
+    size_t m_last_line_length = 0;
+
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_finished = false;
+    std::thread m_thread;
+};
+
+#endif //B216602_RENDER_PROGRESS_H
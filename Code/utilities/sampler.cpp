@@ -0,0 +1,357 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "sampler.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <random>
+#include <vector>
+
+// mixes the bits of a 32-bit value so that nearby inputs give unrelated outputs.
+static uint32_t hash_u32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+static uint32_t hash_combine(uint32_t seed, uint32_t value) {
+    return hash_u32(seed ^ (value + 0x9e3779b9u + (seed << 6) + (seed >> 2)));
+}
+
+// converts 32 random bits to a value in [0, 1).
+static double to_unit(uint32_t bits) {
+    return bits * (1.0 / 4294967296.0);
+}
+
+// ---- sobol points with owen scrambling (burley, "practical hash-based owen scrambling", 2020) ----
+
+static uint32_t reverse_bits(uint32_t x) {
+    x = ((x >> 1) & 0x55555555u) | ((x & 0x55555555u) << 1);
+    x = ((x >> 2) & 0x33333333u) | ((x & 0x33333333u) << 2);
+    x = ((x >> 4) & 0x0f0f0f0fu) | ((x & 0x0f0f0f0fu) << 4);
+    x = ((x >> 8) & 0x00ff00ffu) | ((x & 0x00ff00ffu) << 8);
+    return (x >> 16) | (x << 16);
+}
+
+// the second sobol dimension. its direction numbers are the rows of pascal's triangle modulo two.
+// the point is the xor of the direction numbers of the index's set bits, which is looked up a byte at a time.
+// equation: v_1 = 2^31, v_(k+1) = v_k xor (v_k >> 1)
+// the table is built at compile time, so the first sample drawn does not allocate it.
+static uint32_t sobol_dimension1(uint32_t index) {
+    static constexpr std::array<uint32_t, 4 * 256> table = [] {
+        uint32_t directions[32] = {};
+        directions[0] = 1u << 31;
+        for (int k = 1; k < 32; ++k) {
+            directions[k] = directions[k - 1] ^ (directions[k - 1] >> 1);
+        }
+        // entry [byte * 256 + value] is the xor of the direction numbers of the set bits of 'value' in that byte.
+        std::array<uint32_t, 4 * 256> entries = {};
+        for (int byte = 0; byte < 4; ++byte) {
+            for (uint32_t value = 0; value < 256; ++value) {
+                for (int bit = 0; bit < 8; ++bit) {
+                    if (value & (1u << bit)) {
+                        entries[byte * 256 + value] ^= directions[byte * 8 + bit];
+                    }
+                }
+            }
+        }
+        return entries;
+    }();
+    return table[index & 0xffu] ^ table[256 + ((index >> 8) & 0xffu)]
+         ^ table[512 + ((index >> 16) & 0xffu)] ^ table[768 + (index >> 24)];
+}
+
+// a hash that only lets each bit depend on the bits below it. applied to the bit-reversed value,
+// every bit then depends only on the bits above it, which is exactly an owen scramble.
+static uint32_t laine_karras_permutation(uint32_t x, uint32_t seed) {
+    x += seed;
+    x ^= x * 0x6c50b47cu;
+    x ^= x * 0xb82f1e52u;
+    x ^= x * 0xc7afe638u;
+    x ^= x * 0x8d22f6e6u;
+    return x;
+}
+
+static uint32_t nested_uniform_scramble(uint32_t x, uint32_t seed) {
+    return reverse_bits(laine_karras_permutation(reverse_bits(x), seed));
+}
+
+// the first coordinate of point 'index' of an owen-scrambled sobol sequence, whose index has already been shuffled.
+// the first sobol dimension is the index with its bits reversed, and the scramble reverses them back,
+// so the two reversals cancel out.
+// equation: scramble(sobol_0(i)) = reverse(permutation(i))
+static uint32_t scrambled_sobol_dimension0(uint32_t shuffled_index, uint32_t seed) {
+    return reverse_bits(laine_karras_permutation(shuffled_index, hash_combine(seed, 0)));
+}
+
+// the first coordinate of point 'index' of an owen-scrambled sobol sequence. the index is scrambled too,
+// which shuffles the order of the points, so dimensions using different seeds are not correlated with each other.
+static uint32_t sobol_owen_1d(uint32_t index, uint32_t seed) {
+    return scrambled_sobol_dimension0(nested_uniform_scramble(index, seed), seed);
+}
+
+// point 'index' of a 2d owen-scrambled sobol sequence.
+static void sobol_owen_2d(uint32_t index, uint32_t seed, uint32_t& a, uint32_t& b) {
+    index = nested_uniform_scramble(index, seed);
+    a = scrambled_sobol_dimension0(index, seed);
+    b = nested_uniform_scramble(sobol_dimension1(index), hash_combine(seed, 1));
+}
+
+// ---- correlated multi-jittered sampling (kensler, "correlated multi-jittered sampling", 2013) ----
+
+// a pseudo-random permutation of [0, length), chosen by the pattern p.
+// the hash is a bijection on the smallest power of two covering the length, and values outside the range are
+// hashed again until they fall inside it.
+static uint32_t permute(uint32_t i, uint32_t length, uint32_t p) {
+    uint32_t w = length - 1;
+    w |= w >> 1;
+    w |= w >> 2;
+    w |= w >> 4;
+    w |= w >> 8;
+    w |= w >> 16;
+    do {
+        i ^= p;
+        i *= 0xe170893du;
+        i ^= p >> 16;
+        i ^= (i & w) >> 4;
+        i ^= p >> 8;
+        i *= 0x0929eb3fu;
+        i ^= p >> 23;
+        i ^= (i & w) >> 1;
+        i *= 1 | p >> 27;
+        i *= 0x6935fa69u;
+        i ^= (i & w) >> 11;
+        i *= 0x74dcb303u;
+        i ^= (i & w) >> 2;
+        i *= 0x9e501cc3u;
+        i ^= (i & w) >> 2;
+        i *= 0xc860a3dfu;
+        i &= w;
+        i ^= i >> 5;
+    } while (i >= length);
+    return (i + p) % length;
+}
+
+static double random_unit(uint32_t i, uint32_t p) {
+    return to_unit(hash_combine(p, i));
+}
+
+// ---- blue noise mask (ulichney's void-and-cluster method) ----
+
+const int BLUE_NOISE_SIZE = 64;
+
+// builds a tileable 64x64 mask in which every value from 0 to 1 appears once, and pixels of similar value
+// are spread as evenly as possible. it is generated once, the first time it is needed.
+static const std::vector<double>& blue_noise_mask() {
+    static const std::vector<double> mask = [] {
+        const int size = BLUE_NOISE_SIZE;
+        const int count = size * size;
+        const double sigma = 1.9;
+
+        // the gaussian weight between two pixels, by their offset on the torus.
+        std::vector<double> kernel(count);
+        for (int dy = 0; dy < size; ++dy) {
+            for (int dx = 0; dx < size; ++dx) {
+                int wx = std::min(dx, size - dx);
+                int wy = std::min(dy, size - dy);
+                kernel[dy * size + dx] = std::exp(-(wx * wx + wy * wy) / (2.0 * sigma * sigma));
+            }
+        }
+
+        // the energy of a pixel is the summed kernel weight of every set pixel around it,
+        // so the tightest cluster is the set pixel with the most energy and the largest void the empty one with the least.
+        auto toggle = [&](std::vector<char>& bits, std::vector<double>& energy, int p, bool set) {
+            bits[p] = set;
+            double sign = set ? 1.0 : -1.0;
+            int px = p % size, py = p / size;
+            for (int q = 0; q < count; ++q) {
+                int dx = (q % size - px) & (size - 1);
+                int dy = (q / size - py) & (size - 1);
+                energy[q] += sign * kernel[dy * size + dx];
+            }
+        };
+        auto tightest_cluster = [&](const std::vector<char>& bits, const std::vector<double>& energy) {
+            int best = -1;
+            for (int p = 0; p < count; ++p) {
+                if (bits[p] && (best < 0 || energy[p] > energy[best])) best = p;
+            }
+            return best;
+        };
+        auto largest_void = [&](const std::vector<char>& bits, const std::vector<double>& energy) {
+            int best = -1;
+            for (int p = 0; p < count; ++p) {
+                if (!bits[p] && (best < 0 || energy[p] < energy[best])) best = p;
+            }
+            return best;
+        };
+
+        // starts from a tenth of the pixels set at random, with a fixed seed so the mask is the same on every run.
+        std::vector<char> bits(count, 0);
+        std::vector<double> energy(count, 0.0);
+        std::mt19937 generator(1);
+        int initial = count / 10;
+        for (int placed = 0; placed < initial;) {
+            int p = static_cast<int>(generator() % count);
+            if (!bits[p]) {
+                toggle(bits, energy, p, true);
+                placed++;
+            }
+        }
+        // moves the tightest cluster into the largest void until that no longer changes anything.
+        for (int iteration = 0; iteration < count; ++iteration) {
+            int cluster = tightest_cluster(bits, energy);
+            toggle(bits, energy, cluster, false);
+            int gap = largest_void(bits, energy);
+            toggle(bits, energy, gap, true);
+            if (gap == cluster) break;
+        }
+
+        std::vector<int> rank(count, 0);
+        // ranks the initial pixels by removing the tightest cluster each time, from the highest rank down.
+        {
+            std::vector<char> removal_bits = bits;
+            std::vector<double> removal_energy = energy;
+            for (int r = initial - 1; r >= 0; --r) {
+                int cluster = tightest_cluster(removal_bits, removal_energy);
+                toggle(removal_bits, removal_energy, cluster, false);
+                rank[cluster] = r;
+            }
+        }
+        // ranks the remaining pixels by filling the largest void each time. with a gaussian kernel the tightest
+        // cluster of empty pixels is the largest void, so this one pass covers both halves of the original method.
+        for (int r = initial; r < count; ++r) {
+            int gap = largest_void(bits, energy);
+            toggle(bits, energy, gap, true);
+            rank[gap] = r;
+        }
+
+        std::vector<double> values(count);
+        for (int p = 0; p < count; ++p) {
+            values[p] = (rank[p] + 0.5) / count;
+        }
+        return values;
+    }();
+    return mask;
+}
+
+// the mask value for a pixel, with the mask shifted by a different amount for every seed and channel.
+static double blue_noise(int x, int y, uint32_t seed, uint32_t channel) {
+    uint32_t shift = hash_combine(seed, channel);
+    int mx = (x + static_cast<int>(shift & 0xffffu)) & (BLUE_NOISE_SIZE - 1);
+    int my = (y + static_cast<int>(shift >> 16)) & (BLUE_NOISE_SIZE - 1);
+    return blue_noise_mask()[my * BLUE_NOISE_SIZE + mx];
+}
+
+// ---- samplers ----
+
+void Sampler::setFrame(uint32_t frame) {
+    m_frame = frame;
+    m_frame_hash = hash_u32(frame);
+}
+
+void Sampler::startPixelSample(int x, int y, uint32_t index, uint32_t count) {
+    m_x = x;
+    m_y = y;
+    m_pixel_hash = hash_combine(hash_combine(m_frame_hash, static_cast<uint32_t>(x)), static_cast<uint32_t>(y));
+    m_index = index;
+    m_count = count;
+    m_bounce = 0;
+    thread_rng().seed(static_cast<uint32_t>(x), static_cast<uint32_t>(y), index, m_frame);
+}
+
+double RandomSampler::get1D(uint32_t dimension, uint32_t draw, uint32_t) {
+    auto bits = philox4x32({static_cast<uint32_t>(m_x), static_cast<uint32_t>(m_y), m_index, dimension}, {m_frame, draw});
+    return to_unit(bits[0]);
+}
+
+void RandomSampler::get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t) {
+    auto bits = philox4x32({static_cast<uint32_t>(m_x), static_cast<uint32_t>(m_y), m_index, dimension}, {m_frame, draw});
+    u = to_unit(bits[0]);
+    v = to_unit(bits[1]);
+}
+
+double StratifiedSampler::get1D(uint32_t dimension, uint32_t draw, uint32_t draws) {
+    uint32_t n = m_count * draws;
+    uint32_t s = (m_index * draws + draw) % n;
+    uint32_t p = hash_combine(m_pixel_hash, dimension);
+    // equation: value = (permuted stratum + jitter) / n
+    return (permute(s, n, p) + random_unit(s, p * 0x68bc21ebu)) / n;
+}
+
+void StratifiedSampler::get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) {
+    uint32_t n = m_count * draws;
+    uint32_t s = (m_index * draws + draw) % n;
+    uint32_t p = hash_combine(m_pixel_hash, dimension);
+    // an m by k grid with at least n cells. sample s falls in column s % m and row s / m of the grid,
+    // and inside its cell is placed in the row and column of a finer grid given by two more permutations,
+    // so the n points also land in different strips along each axis.
+    uint32_t m = std::max(1u, static_cast<uint32_t>(std::sqrt(static_cast<double>(n))));
+    uint32_t k = (n + m - 1) / m;
+    s = permute(s, n, p * 0x51633e2du);
+    uint32_t sx = permute(s % m, m, p * 0x68bc21ebu);
+    uint32_t sy = permute(s / m, k, p * 0x02e5be93u);
+    double jx = random_unit(s, p * 0x967a889bu);
+    double jy = random_unit(s, p * 0x368cc8b7u);
+    u = (sx + (sy + jx) / k) / m;
+    v = (s + jy) / n;
+}
+
+double SobolSampler::get1D(uint32_t dimension, uint32_t draw, uint32_t draws) {
+    return to_unit(sobol_owen_1d(m_index * draws + draw, hash_combine(m_pixel_hash, dimension)));
+}
+
+void SobolSampler::get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) {
+    uint32_t a, b;
+    sobol_owen_2d(m_index * draws + draw, hash_combine(m_pixel_hash, dimension), a, b);
+    u = to_unit(a);
+    v = to_unit(b);
+}
+
+double BlueNoiseSampler::get1D(uint32_t dimension, uint32_t draw, uint32_t draws) {
+    // every pixel uses the same points, so the seed depends only on the dimension.
+    uint32_t seed = hash_combine(m_frame_hash, dimension);
+    double value = to_unit(sobol_owen_1d(m_index * draws + draw, seed));
+    // equation: value = frac(point + mask(x, y))
+    value += blue_noise(m_x, m_y, seed, 0);
+    return value >= 1.0 ? value - 1.0 : value;
+}
+
+void BlueNoiseSampler::get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) {
+    uint32_t a, b;
+    uint32_t seed = hash_combine(m_frame_hash, dimension);
+    sobol_owen_2d(m_index * draws + draw, seed, a, b);
+    u = to_unit(a) + blue_noise(m_x, m_y, seed, 0);
+    v = to_unit(b) + blue_noise(m_x, m_y, seed, 1);
+    if (u >= 1.0) u -= 1.0;
+    if (v >= 1.0) v -= 1.0;
+}
+
+std::unique_ptr<Sampler> make_sampler(SamplerType type, uint32_t frame) {
+    std::unique_ptr<Sampler> sampler;
+    switch (type) {
+        case SamplerType::Stratified: sampler = std::make_unique<StratifiedSampler>(); break;
+        case SamplerType::Sobol: sampler = std::make_unique<SobolSampler>(); break;
+        case SamplerType::BlueNoise:
+            // builds the shared mask now, rather than while the first tile renders.
+            blue_noise_mask();
+            sampler = std::make_unique<BlueNoiseSampler>();
+            break;
+        default: sampler = std::make_unique<RandomSampler>(); break;
+    }
+    sampler->setFrame(frame);
+    return sampler;
+}
+
+bool parse_sampler_type(const std::string& name, SamplerType& type) {
+    if (name == "random") type = SamplerType::Random;
+    else if (name == "stratified") type = SamplerType::Stratified;
+    else if (name == "sobol") type = SamplerType::Sobol;
+    else if (name == "bluenoise") type = SamplerType::BlueNoise;
+    else return false;
+    return true;
+}
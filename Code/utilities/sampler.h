@@ -0,0 +1,161 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_SAMPLER_H
+#define B216602_SAMPLER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include "vector3.h"
+#include "random_utils.h"
+
+// the ways the random numbers of a render can be generated.
+enum class SamplerType {
+    // independent uniform numbers from the per-thread generator.
+    Random,
+    // correlated multi-jittered samples: one sample per cell of a grid over the pixel's samples.
+    Stratified,
+    // owen-scrambled sobol points, scrambled differently for every pixel.
+    Sobol,
+    // owen-scrambled sobol points shared by every pixel, shifted per pixel by a blue noise mask.
+    BlueNoise
+};
+
+// the dimensions of a camera sample. every value a sample draws has its own dimension,
+// so e.g. the lens position of sample 3 is always stratified against the lens positions of the pixel's other samples.
+const uint32_t SAMPLE_DIM_PIXEL = 0;  // two dimensions
+const uint32_t SAMPLE_DIM_TIME = 2;
+const uint32_t SAMPLE_DIM_LENS = 3;   // two dimensions
+const uint32_t SAMPLE_DIM_FIRST_BOUNCE = 5;
+
+// the dimensions used at each bounce, relative to the first dimension of that bounce.
+const uint32_t BOUNCE_DIM_LIGHT_PICK = 0;
+const uint32_t BOUNCE_DIM_LIGHT_POINT = 1;  // two dimensions
+const uint32_t BOUNCE_DIM_GLOSSY = 3;       // two dimensions
+const uint32_t BOUNCE_DIMS = 5;
+
+// generates the values in [0, 1) that drive a pixel sample's random decisions.
+// a render starts each pixel sample with startPixelSample, and each bounce with setBounce, and then every decision
+// asks for its dimension. a dimension that is drawn several times within one pixel sample (such as one shadow ray
+// per area light sample) passes which draw this is out of how many, so all draws of all the pixel's samples
+// are spread over the domain together.
+class Sampler {
+public:
+    virtual ~Sampler() = default;
+
+    // sets the frame whose samples are generated, so each frame of an animation gets different noise.
+    void setFrame(uint32_t frame);
+
+    // begins sample 'index' of the 'count' samples taken for pixel (x, y).
+    // this also reseeds the thread's random stream, so everything the sample draws depends only on the sample.
+    void startPixelSample(int x, int y, uint32_t index, uint32_t count);
+
+    // selects the bounce whose dimensions the bounce functions return.
+    void setBounce(int bounce) { m_bounce = bounce; }
+
+    // returns a value in [0, 1) for a dimension of the current pixel sample.
+    virtual double get1D(uint32_t dimension, uint32_t draw = 0, uint32_t draws = 1) = 0;
+    // returns a point in [0, 1)^2 for a dimension pair of the current pixel sample.
+    virtual void get2D(uint32_t dimension, double& u, double& v, uint32_t draw = 0, uint32_t draws = 1) = 0;
+
+    // the same, for a dimension of the current bounce.
+    double bounce1D(uint32_t offset, uint32_t draw = 0, uint32_t draws = 1) {
+        return get1D(bounceDimension(offset), draw, draws);
+    }
+    void bounce2D(uint32_t offset, double& u, double& v, uint32_t draw = 0, uint32_t draws = 1) {
+        get2D(bounceDimension(offset), u, v, draw, draws);
+    }
+
+protected:
+    uint32_t bounceDimension(uint32_t offset) const {
+        return SAMPLE_DIM_FIRST_BOUNCE + static_cast<uint32_t>(m_bounce) * BOUNCE_DIMS + offset;
+    }
+
+    int m_x = 0;
+    int m_y = 0;
+    uint32_t m_frame = 0;
+    uint32_t m_frame_hash = 0;
+    // a hash of the frame and pixel coordinates, combined with the dimension to seed the per-pixel samplers.
+    uint32_t m_pixel_hash = 0;
+    uint32_t m_index = 0;
+    uint32_t m_count = 1;
+    int m_bounce = 0;
+};
+
+// draws every value independently, each one computed by philox from the pixel, sample, dimension, draw and frame.
+class RandomSampler : public Sampler {
+public:
+    double get1D(uint32_t dimension, uint32_t draw, uint32_t draws) override;
+    void get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) override;
+};
+
+// splits a dimension into one cell per sample and jitters a sample inside each, in a random order per pixel and dimension.
+// in two dimensions the cells are the rows and columns of kensler's correlated multi-jittered pattern,
+// so the points are stratified both in the grid and along each axis, for any number of samples.
+class StratifiedSampler : public Sampler {
+public:
+    double get1D(uint32_t dimension, uint32_t draw, uint32_t draws) override;
+    void get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) override;
+};
+
+// sobol points with hash-based owen scrambling, seeded per pixel and dimension.
+// each dimension uses the first two sobol dimensions with its own scramble and index shuffle, so any number
+// of dimensions is available, and every power of two prefix of a pixel's samples stays well stratified.
+class SobolSampler : public Sampler {
+public:
+    double get1D(uint32_t dimension, uint32_t draw, uint32_t draws) override;
+    void get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) override;
+};
+
+// the same scrambled sobol points for every pixel, each pixel shifting them (modulo one) by the value of a
+// blue noise mask, offset per dimension. neighbouring pixels then get very different shifts, which leaves
+// the remaining error as high-frequency noise that looks much smoother at low sample counts.
+class BlueNoiseSampler : public Sampler {
+public:
+    double get1D(uint32_t dimension, uint32_t draw, uint32_t draws) override;
+    void get2D(uint32_t dimension, double& u, double& v, uint32_t draw, uint32_t draws) override;
+};
+
+// creates a sampler of the given type for a frame.
+std::unique_ptr<Sampler> make_sampler(SamplerType type, uint32_t frame = 0);
+
+// parses a sampler name ("random", "stratified", "sobol" or "bluenoise"). returns false for an unknown name.
+bool parse_sampler_type(const std::string& name, SamplerType& type);
+
+// the sampler the current thread draws from, or null to draw independent random numbers.
+inline Sampler*& thread_sampler() {
+    static thread_local Sampler* sampler = nullptr;
+    return sampler;
+}
+
+// installs a sampler for the current thread until the scope ends.
+class SamplerScope {
+public:
+    explicit SamplerScope(Sampler* sampler) : m_previous(thread_sampler()) { thread_sampler() = sampler; }
+    ~SamplerScope() { thread_sampler() = m_previous; }
+    SamplerScope(const SamplerScope&) = delete;
+    SamplerScope& operator=(const SamplerScope&) = delete;
+
+private:
+    Sampler* m_previous;
+};
+
+// draws a value for a dimension of the current bounce from the thread's sampler, falling back to random_double.
+inline double sample_bounce_1d(uint32_t offset, uint32_t draw = 0, uint32_t draws = 1) {
+    Sampler* sampler = thread_sampler();
+    return sampler ? sampler->bounce1D(offset, draw, draws) : random_double();
+}
+
+inline void sample_bounce_2d(uint32_t offset, double& u, double& v, uint32_t draw = 0, uint32_t draws = 1) {
+    Sampler* sampler = thread_sampler();
+    if (sampler) {
+        sampler->bounce2D(offset, u, v, draw, draws);
+    } else {
+        u = random_double();
+        v = random_double();
+    }
+}
+
+#endif //B216602_SAMPLER_H
@@ -9,6 +9,7 @@
 #include "matrix4x4.h"
 #include <vector>
 #include "../acceleration/bvh.h"
+#include "../acceleration/primitive_bvh.h"
 #include "../shapes/material.h"
 #include "Image.h"
 #include <cstdlib>
@@ -18,6 +19,15 @@
 #include "../shapes/complex_sphere.h"
 #include "../config.h"
 #include "../shapes/complex_plane.h"
+#include "../shapes/tessellated_mesh.h"
+#include "HeightField.h"
+#include "asset_cache.h"
+#include <map>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <thread>
+#include <unistd.h>
 
 
 // Helper that reads three doubles from a stream and store into a Vector3 object.
@@ -28,7 +38,7 @@ static void read_vector(std::stringstream& ss, Vector3& vec) {
 }
 
 // function to load textures, converting from JPG/PNG if necessary
-static std::shared_ptr<Image> load_texture_from_file(const std::string& filepath) {
+static std::shared_ptr<Image> read_texture_file(const std::string& filepath) {
     std::string ext = "";
     size_t pos = filepath.find_last_of('.');
     if (pos != std::string::npos) {
@@ -40,7 +50,9 @@ static std::shared_ptr<Image> load_texture_from_file(const std::string& filepath
     }
     std::string final_path = filepath;
     bool converted_temp = false;
-    std::string temp_ppm = "temp_texture_conv.ppm";
+    // textures are decoded on several threads at once, so each conversion writes a file of its own.
+    static std::atomic<int> conversions{0};
+    std::string temp_ppm = "temp_texture_conv_" + std::to_string(::getpid()) + "_" + std::to_string(conversions++) + ".ppm";
 
     // if jpg or png, attempt to convert to ppm via python
     if (ext == ".jpg" || ext == ".jpeg" || ext == ".png") {
@@ -90,44 +102,257 @@ static std::shared_ptr<Image> load_texture_from_file(const std::string& filepath
     return texture;
 }
 
-Scene::Scene(const std::string& scene_filepath, bool build_bvh, double exposure, bool enable_shadows, int glossy_samples, double shutter_time, bool enable_fresnel, bool render_normals)
-: m_exposure(exposure) , m_shadows_enabled(enable_shadows), m_glossy_samples(glossy_samples), m_shutter_time(shutter_time), m_fresnel_enabled(enable_fresnel), m_render_normals(render_normals) {    parseSceneFile(scene_filepath), m_shadow_samples = Config::Instance().getInt("render.shadow_samples", 4);
+// loads a texture, sharing it with any loaded scene that already uses the same file.
+static std::shared_ptr<Image> load_texture_from_file(const std::string& filepath) {
+    return AssetCache::Instance().get<Image>("texture", filepath, [&]() { return read_texture_file(filepath); });
+}
+
+// loads a bump map and bakes it into a float heightfield with precomputed derivative maps.
+// bump maps shared between several objects, or with another loaded scene, are only loaded and baked once.
+static std::shared_ptr<HeightField> load_bump_map_from_file(const std::string& filepath) {
+    return AssetCache::Instance().get<HeightField>("bump_map", filepath, [&]() {
+        std::shared_ptr<HeightField> height_field = nullptr;
+        std::shared_ptr<Image> image = read_texture_file(filepath);
+        if (image) {
+            height_field = std::make_shared<HeightField>(*image);
+            std::cout << "  Baked bump map heightfield (" << height_field->getWidth() << "x" << height_field->getHeight() << ")." << std::endl;
+        }
+        return height_field;
+    });
+}
+
+// reads the lines of a scene file, applying the overrides to their blocks.
+// a line holding only a name, such as SPHERE, starts a block, which runs until the matching END_ line.
+static std::vector<std::string> read_scene_lines(std::ifstream& file, const std::vector<SceneOverride>& overrides) {
+    std::vector<std::string> lines;
+    std::vector<bool> applied(overrides.size(), false);
+    std::map<std::string, int> block_counts;
+    std::string block;
+    int index = 0;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string token, value;
+        ss >> token;
+        if (!block.empty() && token == "END_" + block) {
+            // adds the overrides of keys the block did not have.
+            for (size_t o = 0; o < overrides.size(); ++o) {
+                if (!applied[o] && overrides[o].block == block && overrides[o].index == index) {
+                    lines.push_back("  " + overrides[o].key + " " + overrides[o].values);
+                    applied[o] = true;
+                }
+            }
+            block.clear();
+        } else if (block.empty() && !token.empty() && token[0] != '#' && !(ss >> value)) {
+            block = token;
+            index = block_counts[token]++;
+        } else if (!block.empty() && !token.empty()) {
+            for (size_t o = 0; o < overrides.size(); ++o) {
+                if (!applied[o] && overrides[o].block == block && overrides[o].index == index && overrides[o].key == token) {
+                    line = "  " + overrides[o].key + " " + overrides[o].values;
+                    applied[o] = true;
+                    break;
+                }
+            }
+        }
+        lines.push_back(line);
+    }
+
+    for (size_t o = 0; o < overrides.size(); ++o) {
+        if (!applied[o]) {
+            throw std::runtime_error("Scene override of '" + overrides[o].key + "' matches no " + overrides[o].block
+                                     + " block with index " + std::to_string(overrides[o].index) + ".");
+        }
+    }
+    return lines;
+}
+
+Scene::Scene(const std::string& scene_filepath, bool build_bvh, double exposure, bool enable_shadows, int glossy_samples, double shutter_time, bool enable_fresnel, bool render_normals, bool tessellate_displacement, bool virtual_bvh, int light_samples, bool light_culling, bool russian_roulette, const std::vector<SceneOverride>& overrides)
+: m_exposure(exposure) , m_shadows_enabled(enable_shadows), m_glossy_samples(glossy_samples), m_shutter_time(shutter_time), m_fresnel_enabled(enable_fresnel), m_render_normals(render_normals), m_light_samples(light_samples), m_light_culling(light_culling), m_russian_roulette(russian_roulette) {
+    m_load_start = std::chrono::steady_clock::now();
+    parseSceneFile(scene_filepath, overrides);
+    m_parse_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_load_start).count();
+    m_shadow_samples = Config::Instance().getInt("render.shadow_samples", 4);
     m_epsilon = Config::Instance().getDouble("advanced.epsilon", 1e-4);
     m_max_bounces = Config::Instance().getInt("settings.max_bounces", 5);;
+    m_min_throughput = Config::Instance().getDouble("render.min_throughput", 0.001);
+    m_roulette_depth = Config::Instance().getInt("render.roulette_depth", 3);
+    m_glossy_ray_budget = Config::Instance().getInt("render.glossy_ray_budget", 32);
 
     if (!m_camera) {
         throw std::runtime_error("Scene file error: No camera data found.");
     }
 
-    if (build_bvh) {
-        // prepare a bounding volume hierarchy (BVH)
-        if (!m_world.objects.empty()) {
-            std::cout << "Building BVH..." << std::endl;
+    buildScene(build_bvh, tessellate_displacement, virtual_bvh);
+}
 
-            // creates a BVHNode object on the heap and wraps it in a pointer that points to the root node of the BVH tree.
-            auto bvh_root = std::make_shared<BVHNode>(m_world);
+uint32_t Scene::addMaterial(const Material& mat) {
+    uint32_t id = m_materials.add(mat);
+    if (!mat.texture_filename.empty() || !mat.bump_map_filename.empty()) {
+        m_textured_materials.push_back(id);
+    }
+    return id;
+}
 
-            // removes the individual pointers to the object in the world nad replaces them with a pointer to the BVH tree.
-            m_world.objects.clear();
-            m_world.add(bvh_root);
+void Scene::buildScene(bool build_bvh, bool tessellate_displacement, bool virtual_bvh) {
+    // the stages of loading the scene, after the file has been read:
+    //
+    //   texture/bump map/hdr decodes -> assign textures -> tessellate -> light grid
+    //                                                              \--> bvh
+    //   light bvh
+    //
+    // the shape bounds do not depend on the textures, so without tessellation the bvh is built while they decode.
+    TaskGraph graph;
+    std::map<std::string, std::shared_ptr<Image>> textures;
+    std::map<std::string, std::shared_ptr<HeightField>> bump_maps;
+    std::vector<TaskGraph::TaskId> decodes;
+    for (uint32_t id : m_textured_materials) {
+        const Material& mat = MaterialLibrary::Instance().get(id);
+        if (!mat.texture_filename.empty() && textures.emplace("../" + mat.texture_filename, nullptr).second) {
+            std::string path = "../" + mat.texture_filename;
+            decodes.push_back(graph.add("texture " + path, [&textures, path]() {
+                textures.at(path) = load_texture_from_file(path);
+            }));
+        }
+        if (!mat.bump_map_filename.empty() && bump_maps.emplace("../" + mat.bump_map_filename, nullptr).second) {
+            std::string path = "../" + mat.bump_map_filename;
+            decodes.push_back(graph.add("bump map " + path, [&bump_maps, path]() {
+                bump_maps.at(path) = load_bump_map_from_file(path);
+            }));
+        }
+    }
+    if (!m_hdr_path.empty()) {
+        decodes.push_back(graph.add("hdr " + m_hdr_path, [this]() {
+            m_hdr_background = AssetCache::Instance().get<HDRImage>("hdr", m_hdr_path, [this]() { return std::make_shared<HDRImage>(m_hdr_path); });
+            std::cout << "Attempted to load HDR Background: " << m_hdr_path << std::endl;
+        }));
+    }
+    // every path is in the maps before the graph runs, so each decode only writes its own entry.
+    TaskGraph::TaskId assign = graph.add("assign textures", [this, &textures, &bump_maps]() {
+        for (uint32_t id : m_textured_materials) {
+            const Material& mat = MaterialLibrary::Instance().get(id);
+            std::shared_ptr<Image> texture = mat.texture_filename.empty() ? nullptr : textures.at("../" + mat.texture_filename);
+            std::shared_ptr<HeightField> bump_map = mat.bump_map_filename.empty() ? nullptr : bump_maps.at("../" + mat.bump_map_filename);
+            m_materials.setAssets(id, texture, bump_map);
+        }
+    }, decodes);
+
+    if (m_light_samples > 0 && !m_lights.empty()) {
+        graph.add("light bvh", [this]() {
+            // builds the light hierarchy so each shading point can pick a few lights instead of looping over all of them.
+            m_light_bvh = LightBVH(m_lights);
+            std::cout << "Built light BVH over " << m_lights.size() << " lights." << std::endl;
+        });
+    }
 
+    // the stage the shapes are final after. tessellation needs the bump maps.
+    std::vector<TaskGraph::TaskId> shapes_ready;
+    if (tessellate_displacement) {
+        // converts displaced shapes before the BVH is built so their meshes are placed in it directly.
+        shapes_ready.push_back(graph.add("tessellate", [this]() { tessellateDisplacedShapes(); }, {assign}));
+    }
+
+    if (m_light_culling && !m_lights.empty() && !m_world.objects.empty()) {
+        graph.add("light grid", [this]() {
+            // every hit point lies inside the bounds of the shapes, so the grid only needs to cover them.
+            AABB bounds;
+            bool has_bounds = false;
+            for (const auto& object : m_world.objects) {
+                AABB box;
+                if (object->getBoundingBox(box)) {
+                    bounds = has_bounds ? AABB::combine(bounds, box) : box;
+                    has_bounds = true;
+                }
+            }
+            if (has_bounds) {
+                int resolution = Config::Instance().getInt("render.light_grid_resolution", 16);
+                // the default cutoff is one 8-bit step of the final image.
+                double threshold = Config::Instance().getDouble("render.light_cutoff", 1.0 / 255.0);
+                m_light_grid = LightGrid(m_lights, bounds, resolution, m_exposure, threshold);
+                std::cout << "Built light grid (" << resolution << "^3 cells, " << m_light_grid.referenceCount()
+                          << " light references for " << m_lights.size() << " lights)." << std::endl;
+            }
+        }, shapes_ready);
+    }
+
+    std::shared_ptr<Shape> bvh_root;
+    if (build_bvh && !m_world.objects.empty()) {
+        graph.add("bvh", [this, &bvh_root, virtual_bvh]() {
+            // prepare a bounding volume hierarchy (BVH)
+            std::cout << "Building BVH..." << std::endl;
+            if (virtual_bvh) {
+                // creates the BVHNode tree in the scene's arena and wraps the root node in a pointer.
+                // the build sorts the list it is given, so it works on a copy while the light grid reads the world.
+                HittableList objects;
+                objects.objects = m_world.objects;
+                bvh_root = arena_make_shared<BVHNode>(m_arena, objects, m_arena);
+            } else {
+                // stores the basic shapes by value in per-type arrays so the leaves can dispatch without virtual calls.
+                bvh_root = arena_make_shared<PrimitiveBVH>(m_arena, m_world.objects);
+            }
             std::cout << "BVH build complete." << std::endl;
-        } else {
-            // there are no objects in the world to build a BVH from.
-            std::cout << "Scene is empty, skipping BVH build." << std::endl;
-        }
+        }, shapes_ready);
+    }
+
+    // at least two threads, so a long texture decode does not hold up the bvh on a single core.
+    graph.run(std::max(2, static_cast<int>(std::thread::hardware_concurrency())));
+
+    if (bvh_root) {
+        // removes the individual pointers to the object in the world nad replaces them with a pointer to the BVH tree.
+        m_world.objects.clear();
+        m_world.add(bvh_root);
+    } else if (build_bvh) {
+        // there are no objects in the world to build a BVH from.
+        std::cout << "Scene is empty, skipping BVH build." << std::endl;
     } else {
         std::cout << "BVH build skipped." << std::endl;
     }
+
+    // the stage timings start from reading the file, which came before the graph.
+    m_load_timings.push_back(TaskTiming{"parse", 0.0, m_parse_seconds});
+    for (TaskTiming timing : graph.timings()) {
+        timing.start += m_parse_seconds;
+        if (timing.name == "bvh") {
+            m_bvh_seconds = timing.seconds;
+        }
+        m_load_timings.push_back(timing);
+    }
+}
+
+void Scene::tessellateDisplacedShapes() {
+    // the target on-screen length of a triangle edge in pixels, and the maximum grid cells along a patch edge.
+    double edge_pixels = Config::Instance().getDouble("advanced.tessellation_rate", 2.0);
+    int max_resolution = Config::Instance().getInt("advanced.tessellation_max_resolution", 256);
+
+    size_t shapes_converted = 0;
+    size_t triangle_count = 0;
+    size_t memory_usage = 0;
+    for (auto& object : m_world.objects) {
+        // 'dynamic_cast' returns nullptr when the shape does not support tessellation.
+        auto tessellatable = std::dynamic_pointer_cast<Tessellatable>(object);
+        if (!tessellatable) continue;
+
+        std::shared_ptr<Shape> mesh = tessellatable->tessellate(*m_camera, edge_pixels, max_resolution);
+        // shapes without a bump map have nothing to displace and keep their ray marched intersection.
+        if (!mesh) continue;
+
+        auto tessellated = std::static_pointer_cast<TessellatedMesh>(mesh);
+        triangle_count += tessellated->getTriangleCount();
+        memory_usage += tessellated->getMemoryUsage();
+        object = mesh;
+        ++shapes_converted;
+    }
+
+    std::cout << "Tessellated " << shapes_converted << " displaced shapes into " << triangle_count
+              << " triangles (" << memory_usage / (1024.0 * 1024.0) << " MB)." << std::endl;
 }
 
-void Scene::parseSceneFile(const std::string& filepath) {
+void Scene::parseSceneFile(const std::string& filepath, const std::vector<SceneOverride>& overrides) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
         throw std::runtime_error("Failed to open scene file: " + filepath);
     }
 
-    std::string line;
     std::string current_block_type = "NONE";
 
     // Temporary storage for camera parameters
@@ -154,7 +379,7 @@ void Scene::parseSceneFile(const std::string& filepath) {
     Vector3 temp_velocity(0,0,0);
 
 
-    while (std::getline(file, line)) {
+    for (const std::string& line : read_scene_lines(file, overrides)) {
         std::stringstream ss(line);
         std::string token;
         // tokenize each line of the file
@@ -167,10 +392,8 @@ void Scene::parseSceneFile(const std::string& filepath) {
             std::string filename;
             ss >> filename;
             if (!filename.empty()) {
-                // assuming generic relative path structure as other textures
-                std::string full_path = "../" + filename;
-                m_hdr_background = std::make_shared<HDRImage>(full_path);
-                std::cout << "Attempted to load HDR Background: " << full_path << std::endl;
+                // assuming generic relative path structure as other textures. it is loaded with the textures.
+                m_hdr_path = "../" + filename;
             }
             continue;
         }
@@ -266,13 +489,6 @@ void Scene::parseSceneFile(const std::string& filepath) {
         }
 
         if (token == "END_SPHERE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
             // Build Transformation Matrices.
             Matrix4x4 mat_s = Matrix4x4::createScale(scale_vec);
             Matrix4x4 mat_rx = Matrix4x4::createRotationX(rotation.x);
@@ -284,21 +500,15 @@ void Scene::parseSceneFile(const std::string& filepath) {
             // Produces the final object-to-world transformation matrix for the sphere.
             Matrix4x4 transform = mat_t * mat_rz * mat_ry * mat_rx * mat_s;
             // Calculates the inverse of the transform matrix to convert world space back to local object space.
+            // only the inverse is kept by the shape; the forward transform is recovered from it when needed.
             Matrix4x4 inv_transform = transform.inverse();
 
             // Add the completed shape
-            m_world.add(std::make_shared<Sphere>(transform, inv_transform, temp_mat, temp_velocity, m_shutter_time));
+            m_world.add(arena_make_shared<Sphere>(m_arena, inv_transform, addMaterial(temp_mat), temp_velocity, m_shutter_time));
             current_block_type = "NONE";
             continue;
         }
         if (token == "END_COMPLEX_SPHERE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
             // Build Transformation Matrices.
             Matrix4x4 mat_s = Matrix4x4::createScale(scale_vec);
             Matrix4x4 mat_rx = Matrix4x4::createRotationX(rotation.x);
@@ -310,21 +520,15 @@ void Scene::parseSceneFile(const std::string& filepath) {
             // Produces the final object-to-world transformation matrix for the sphere.
             Matrix4x4 transform = mat_t * mat_rz * mat_ry * mat_rx * mat_s;
             // Calculates the inverse of the transform matrix to convert world space back to local object space.
+            // only the inverse is kept by the shape; the forward transform is recovered from it when needed.
             Matrix4x4 inv_transform = transform.inverse();
 
             // Add the completed shape
-            m_world.add(std::make_shared<ComplexSphere>(transform, inv_transform, temp_mat, temp_velocity, m_shutter_time));
+            m_world.add(arena_make_shared<ComplexSphere>(m_arena, inv_transform, addMaterial(temp_mat), temp_velocity, m_shutter_time));
             current_block_type = "NONE";
             continue;
         }
         if (token == "END_CUBE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
             // Build transforms for Cube. Instead of defining a cube by its corners, define a cube at the origin and then use a transformation matrix to move it.
             Matrix4x4 mat_s = Matrix4x4::createScale(scale_vec);
             Matrix4x4 mat_rx = Matrix4x4::createRotationX(rotation.x);
@@ -336,24 +540,17 @@ void Scene::parseSceneFile(const std::string& filepath) {
             // Produces the final object-to-world transformation matrix for the cube.
             Matrix4x4 transform = mat_t * mat_rz * mat_ry * mat_rx * mat_s;
             // Calculates the inverse of the transform matrix to convert world space back to local object space.
+            // only the inverse is kept by the shape; the forward transform is recovered from it when needed.
             // This is necessary as it is computationally expensive to write an intersection function for a rotated scaled and translated shape, it is easier to move the ray instead of the object which requires the ray to be transformed by the object's inverse matrix.
             Matrix4x4 inv_transform = transform.inverse();
 
             // Add the object to the world.
-            m_world.add(std::make_shared<Cube>(transform, inv_transform, temp_mat, temp_velocity, m_shutter_time));
+            m_world.add(arena_make_shared<Cube>(m_arena, inv_transform, addMaterial(temp_mat), temp_velocity, m_shutter_time));
             current_block_type = "NONE";
             continue;
         }
 
         if (token == "END_COMPLEX_CUBE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
-
             Matrix4x4 mat_s = Matrix4x4::createScale(scale_vec);
             Matrix4x4 mat_rx = Matrix4x4::createRotationX(rotation.x);
             Matrix4x4 mat_ry = Matrix4x4::createRotationY(rotation.y);
@@ -364,21 +561,14 @@ void Scene::parseSceneFile(const std::string& filepath) {
             Matrix4x4 inv_transform = transform.inverse();
 
             // Instantiate ComplexCube here
-            m_world.add(std::make_shared<ComplexCube>(transform, inv_transform, temp_mat, temp_velocity, m_shutter_time));
+            m_world.add(arena_make_shared<ComplexCube>(m_arena, inv_transform, addMaterial(temp_mat), temp_velocity, m_shutter_time));
             current_block_type = "NONE";
             continue;
         }
 
         if (token == "END_PLANE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
             if (temp_corners.size() == 4) {
-                m_world.add(std::make_shared<Plane>(temp_corners[0], temp_corners[1], temp_corners[2], temp_corners[3], temp_mat, temp_velocity, m_shutter_time));
+                m_world.add(arena_make_shared<Plane>(m_arena, temp_corners[0], temp_corners[1], temp_corners[2], temp_corners[3], addMaterial(temp_mat), temp_velocity, m_shutter_time));
             } else {
                 std::cerr << "Warning: Plane block ended with " << temp_corners.size() << " corners, expected 4." << std::endl;
             }
@@ -387,14 +577,6 @@ void Scene::parseSceneFile(const std::string& filepath) {
         }
 
         if (token == "END_COMPLEX_PLANE") {
-            if (!temp_mat.texture_filename.empty()) {
-                std::string texture_path = "../" + temp_mat.texture_filename;
-                temp_mat.texture = load_texture_from_file(texture_path);
-            }
-            if (!temp_mat.bump_map_filename.empty()) {
-                temp_mat.bump_map = load_texture_from_file("../" + temp_mat.bump_map_filename);
-            }
-
             Matrix4x4 mat_s = Matrix4x4::createScale(scale_vec);
             Matrix4x4 mat_rx = Matrix4x4::createRotationX(rotation.x);
             Matrix4x4 mat_ry = Matrix4x4::createRotationY(rotation.y);
@@ -404,7 +586,7 @@ void Scene::parseSceneFile(const std::string& filepath) {
             Matrix4x4 transform = mat_t * mat_rz * mat_ry * mat_rx * mat_s;
             Matrix4x4 inv_transform = transform.inverse();
 
-            m_world.add(std::make_shared<ComplexPlane>(transform, inv_transform, temp_mat, temp_velocity, m_shutter_time));
+            m_world.add(arena_make_shared<ComplexPlane>(m_arena, inv_transform, addMaterial(temp_mat), temp_velocity, m_shutter_time));
             current_block_type = "NONE";
             continue;
         }
@@ -7,13 +7,31 @@
 #include "../environment/camera.h"
 #include "../environment/light.h"
 #include "matrix4x4.h"
+#include "arena.h"
+#include "task_graph.h"
+#include <chrono>
 #include "../environment/HDRImage.h"
+#include "../acceleration/light_bvh.h"
+#include "../acceleration/light_grid.h"
 
+#include "../shapes/material.h"
+
+// replaces a property of one block of a scene file as it loads, so the frames of an animation can share one file.
+// 'index' counts the blocks of that type from zero, in file order. the n-th override of a key in a block
+// replaces the n-th line with that key, or is added to the block if it has fewer.
+struct SceneOverride {
+    std::string block;   // e.g. CAMERA or SPHERE.
+    int index = 0;
+    std::string key;     // e.g. location.
+    std::string values;  // the rest of the line, e.g. "0 1 2".
+};
 
 class Scene {
 public:
     // load scene from file
-    explicit Scene(const std::string& scene_filepath, bool build_bvh = true, double exposure = 1.0, bool enable_shadows = false, int glossy_samples = 0, double shutter_time = 0.0, bool enable_fresnel = false, bool render_normals = false);
+    explicit Scene(const std::string& scene_filepath, bool build_bvh = true, double exposure = 1.0, bool enable_shadows = false, int glossy_samples = 0, double shutter_time = 0.0, bool enable_fresnel = false, bool render_normals = false, bool tessellate_displacement = false, bool virtual_bvh = false, int light_samples = 0, bool light_culling = false, bool russian_roulette = false, const std::vector<SceneOverride>& overrides = {});
+    Scene(const Scene&) = delete;
+    Scene& operator=(const Scene&) = delete;
     // access the loaded camera
     const Camera& getCamera() const { return *m_camera; }
     // access the loaded world (list of shapes)
@@ -32,12 +50,42 @@ public:
     int get_shadow_samples() const { return m_shadow_samples; }
     double get_epsilon() const { return m_epsilon; }
     int get_max_bounces() const { return m_max_bounces; }
+    // the number of lights sampled per shading point. zero means every light is evaluated.
+    int get_light_samples() const { return m_light_samples; }
+    // the light hierarchy used to pick lights when light sampling is enabled.
+    const LightBVH& getLightBVH() const { return m_light_bvh; }
+    // whether lights are culled beyond their cutoff radius using the light grid.
+    bool light_culling_enabled() const { return m_light_culling; }
+    // secondary rays whose weight is at or below this are not traced.
+    double get_min_throughput() const { return m_min_throughput; }
+    // whether russian roulette terminates secondary rays after the first few bounces.
+    bool roulette_enabled() const { return m_russian_roulette; }
+    int get_roulette_depth() const { return m_roulette_depth; }
+    // the number of secondary rays a camera ray may queue before glossy reflections stop being split.
+    int get_glossy_ray_budget() const { return m_glossy_ray_budget; }
+    const LightGrid& getLightGrid() const { return m_light_grid; }
+    // the seconds spent reading the scene file, and building the BVH.
+    double parse_seconds() const { return m_parse_seconds; }
+    double bvh_build_seconds() const { return m_bvh_seconds; }
+    // when each stage of loading the scene ran, from reading the file onwards, and when loading started.
+    const std::vector<TaskTiming>& load_timings() const { return m_load_timings; }
+    std::chrono::steady_clock::time_point load_start() const { return m_load_start; }
 
 
 
 private:
-    void parseSceneFile(const std::string& filepath);
+    void parseSceneFile(const std::string& filepath, const std::vector<SceneOverride>& overrides);
+    // adds a material to the library. a material with a texture or bump map is remembered, so they can be loaded
+    // once the whole file has been read.
+    uint32_t addMaterial(const Material& mat);
+    // loads the textures, bump maps and hdr background while the bvh and light structures are built, on a few threads.
+    void buildScene(bool build_bvh, bool tessellate_displacement, bool virtual_bvh);
+    // replaces displaced shapes with triangle meshes tessellated for the loaded camera.
+    void tessellateDisplacedShapes();
 
+    SceneMaterials m_materials; // the materials this scene added to the library
+    // the shapes and bvh nodes, allocated together. declared before the world, so it outlives every pointer into it.
+    MonotonicArena m_arena;
     HittableList m_world; // The list of all shapes
     std::unique_ptr<Camera> m_camera; // camera
     std::vector<PointLight> m_lights; // lights
@@ -50,6 +98,21 @@ private:
     int m_shadow_samples;
     double m_epsilon;
     int m_max_bounces;
+    int m_light_samples;
+    LightBVH m_light_bvh;
+    bool m_light_culling;
+    LightGrid m_light_grid;
+    double m_min_throughput;
+    bool m_russian_roulette;
+    int m_roulette_depth;
+    int m_glossy_ray_budget;
+    double m_parse_seconds = 0.0;
+    double m_bvh_seconds = 0.0;
+    std::vector<TaskTiming> m_load_timings;
+    std::chrono::steady_clock::time_point m_load_start;
+    // the materials waiting for their textures or bump maps, and the hdr background file, while the scene loads.
+    std::vector<uint32_t> m_textured_materials;
+    std::string m_hdr_path;
 
 
 
@@ -15,6 +15,8 @@
 #include <algorithm>
 
 #include "random_utils.h"
+#include "sampler.h"
+#include "render_progress.h"
 
 #ifndef B216602_SHADING_H
 #define B216602_SHADING_H
@@ -28,28 +30,34 @@ inline double shadow_schlick(double cos_i, double n1, double n2) {
 }
 
 
-inline Vector3 random_point_on_light(const PointLight& light) {
+// maps (u, v) in [0, 1)^2 to a point spread uniformly over the surface of a spherical light.
+// equation: z = 1 - 2u, phi = 2 * pi * v, point = centre + radius * (sqrt(1 - z^2) cos(phi), sqrt(1 - z^2) sin(phi), z)
+inline Vector3 random_point_on_light(const PointLight& light, double u, double v) {
     if (light.radius == 0.0) {
         return light.position;
     }
-    return light.position + random_in_unit_sphere().normalize() * light.radius;
+    double z = 1.0 - 2.0 * u;
+    double ring = std::sqrt(std::max(0.0, 1.0 - z * z));
+    double phi = 2.0 * 3.14159265358979323846 * v;
+    return light.position + Vector3(ring * std::cos(phi), ring * std::sin(phi), z) * light.radius;
 }
 
 inline Vector3 component_wise_multiply(const Vector3& a, const Vector3& b) {
-    return Vector3(a.x * b.x, a.y * b.y, a.z * b.z);
+    return a.multiply(b);
 }
 
 inline Vector3 trace_shadow_transmission(const Ray& shadow_ray, double dist_to_light, const HittableList& world) {
     Vector3 transmission(1.0, 1.0, 1.0);
     HitRecord rec;
+    count_ray();
     if (world.intersect(shadow_ray, 0.001, dist_to_light - 0.001, rec)) {
-        if (rec.mat.transparency > 0.0) {
+        if (rec.mat->transparency > 0.0) {
             double n1, n2;
             if (rec.front_face) {
                 n1 = 1.0;
-                n2 = rec.mat.refractive_index;
+                n2 = rec.mat->refractive_index;
             } else {
-                n1 = rec.mat.refractive_index;
+                n1 = rec.mat->refractive_index;
                 n2 = 1.0;
             }
             double eta_ratio = n1 / n2;
@@ -60,12 +68,12 @@ inline Vector3 trace_shadow_transmission(const Ray& shadow_ray, double dist_to_l
             }
             double reflection_prob = shadow_schlick(cos_i, n1, n2);
             double transmission_factor = 1.0 - reflection_prob;
-            Vector3 glass_tint = rec.mat.diffuse;
+            Vector3 glass_tint = rec.mat->diffuse;
 
             transmission = component_wise_multiply(transmission, glass_tint) * transmission_factor;
 
             if (transmission.length() < 0.001) return Vector3(0, 0, 0);
-            Ray new_ray(rec.point + shadow_ray.direction * 0.001, shadow_ray.direction, shadow_ray.time);
+            Ray new_ray(rec.point + shadow_ray.direction * ray_offset_epsilon(rec.point, 0.001), shadow_ray.direction, shadow_ray.time);
             return component_wise_multiply(transmission, trace_shadow_transmission(new_ray, dist_to_light - rec.t, world));
         } else {
             return Vector3(0, 0, 0);
@@ -85,12 +93,16 @@ inline Vector3 compute_light_visibility(const Scene& scene, const HittableList&
     Vector3 shadow_accumulator(0, 0, 0);
 
     for (int i = 0; i < samples; i++) {
-        Vector3 point_on_light = random_point_on_light(light);
+        // the shadow rays of a pixel's samples are spread over the light together.
+        double u, v;
+        sample_bounce_2d(BOUNCE_DIM_LIGHT_POINT, u, v, i, samples);
+        Vector3 point_on_light = random_point_on_light(light, u, v);
         Vector3 shadow_ray_dir = point_on_light - P;
         double dist_to_light = shadow_ray_dir.length();
         shadow_ray_dir = shadow_ray_dir.normalize();
 
-        Vector3 shadow_origin = P + N * epsilon;
+        // the offset grows with the distance from the origin so float positions do not shadow themselves.
+        Vector3 shadow_origin = P + N * ray_offset_epsilon(P, epsilon);
         Ray shadow_ray(shadow_origin, shadow_ray_dir, time);
 
         // Add the colour returned by the new trace_shadow_transmission
@@ -100,9 +112,55 @@ inline Vector3 compute_light_visibility(const Scene& scene, const HittableList&
     return shadow_accumulator * (1.0 / samples);
 }
 
-// calculates the local ambient diffuse. It computes the direct illumination component of the surface colour at the ray-hit point.
-inline Vector3 calculate_local_ad(const HitRecord& rec, const Scene& scene, const HittableList& world, double time) {
-    const Material& mat = rec.mat;
+inline double fast_pow(double base, double exp) {
+    return std::exp(exp * std::log(base));
+}
+
+// the direct lighting at a hit point, split into the terms the tracer mixes separately.
+struct LocalShading {
+    // ambient plus lambertian diffuse, which is scaled down by reflectivity in the tracer.
+    Vector3 diffuse_ambient;
+    // the blinn-phong highlight, which is added on top of every material.
+    Vector3 specular;
+};
+
+// adds one light's diffuse and specular contribution to the shading, scaled by 'weight'.
+// the light's visibility is traced once and shared by both terms, and lights behind the surface are skipped before any shadow rays are cast.
+inline void accumulate_light(LocalShading& shading, const PointLight& light, double weight, const Vector3& diffuse_colour, const Material& mat,
+                             const Scene& scene, const HittableList& world, const Vector3& P, const Vector3& N, const Vector3& V, double time) {
+    Vector3 L_raw = light.position - P;
+    double dist_sq = L_raw.dot(L_raw);
+    Vector3 L = L_raw.normalize();
+
+    // a light behind the surface contributes neither diffuse nor specular, so its shadow rays are not traced.
+    double L_dot_N = L.dot(N);
+    if (L_dot_N <= 0.0) return;
+
+    Vector3 shadow_factor = compute_light_visibility(scene, world, light, P, N, time);
+    if (shadow_factor.x <= 0 && shadow_factor.y <= 0 && shadow_factor.z <= 0) return;
+
+    double falloff = 1.0 / dist_sq;
+    Vector3 light_intensity = light.intensity * (falloff * scene.getExposure() * weight);
+
+    // Calculate diffuse: (MaterialColor * LightIntensity) * Lambert * ShadowColor
+    Vector3 diffuse_part = component_wise_multiply(diffuse_colour, light_intensity) * L_dot_N;
+    diffuse_part = diffuse_part * (1.0 - mat.transparency);
+    // Apply the coloured shadow here using component-wise multiplication
+    shading.diffuse_ambient = shading.diffuse_ambient + component_wise_multiply(diffuse_part, shadow_factor);
+
+    // Calculate base specular from the half vector between the light and the viewer.
+    Vector3 H = (L + V).normalize();
+    double H_dot_N = std::max<double>(0.0, H.dot(N));
+    Vector3 specular_part = component_wise_multiply(mat.specular, light_intensity) * fast_pow(H_dot_N, mat.shininess);
+
+    // Apply the same coloured shadow to the highlight
+    shading.specular = shading.specular + component_wise_multiply(specular_part, shadow_factor);
+}
+
+// calculates the local ambient, diffuse, and specular terms in a single pass over the lights.
+// when light sampling is enabled, only a fixed number of lights picked from the light bvh are evaluated.
+inline LocalShading calculate_local_shading(const HitRecord& rec, const Scene& scene, const HittableList& world, const Ray& view_ray) {
+    const Material& mat = *rec.mat;
 
     // first the base diffuse colour is found.
     Vector3 diffuse_colour;
@@ -144,75 +202,51 @@ inline Vector3 calculate_local_ad(const HitRecord& rec, const Scene& scene, cons
     double a_b = Config::Instance().getDouble("lighting.b", 0.25);
     Vector3 global_ambient_light(a_r, a_g, a_b);
     Vector3 ambient_contribution = component_wise_multiply(mat.ambient, global_ambient_light);
-    Vector3 final_colour_vec = component_wise_multiply(ambient_contribution, diffuse_colour);
-
-    const Vector3 P = rec.point;
-    const Vector3 N = rec.normal.normalize();
-    double exposure = scene.getExposure();
 
-    for (const auto& light : scene.getLights()) {
-        Vector3 shadow_factor = compute_light_visibility(scene, world, light, P, N, time);
+    LocalShading shading;
+    shading.diffuse_ambient = component_wise_multiply(ambient_contribution, diffuse_colour);
+    shading.specular = Vector3(0, 0, 0);
 
-        if (shadow_factor.x > 0 || shadow_factor.y > 0 || shadow_factor.z > 0) {
-            Vector3 L_raw = light.position - P;
-            double dist_sq = L_raw.dot(L_raw);
-            double falloff = 1.0 / dist_sq;
-            Vector3 L = L_raw.normalize();
-
-            Vector3 light_intensity = light.intensity * falloff * exposure;
-            double L_dot_N = std::max(0.0, L.dot(N));
-
-            // Calculate diffuse: (MaterialColor * LightIntensity) * Lambert * ShadowColor
-            Vector3 diffuse_part = component_wise_multiply(diffuse_colour, light_intensity) * L_dot_N;
-            diffuse_part = diffuse_part * (1.0 - mat.transparency);
-            // Apply the coloured shadow here using component-wise multiplication
-            Vector3 final_diffuse = component_wise_multiply(diffuse_part, shadow_factor);
-
-            final_colour_vec = final_colour_vec + final_diffuse;
-        }
-    }
-    return final_colour_vec;
-}
-
-inline double fast_pow(double base, double exp) {
-    return std::exp(exp * std::log(base));
-}
-
-inline Vector3 calculate_specular(const HitRecord& rec, const Scene& scene, const HittableList& world, const Ray& view_ray) {
     const Vector3 P = rec.point;
     const Vector3 N = rec.normal.normalize();
     const Vector3 V = (view_ray.origin - P).normalize();
-    const Material& mat = rec.mat;
-    double exposure = scene.getExposure();
-
-    Vector3 specular_colour(0, 0, 0);
-
-    for (const auto& light : scene.getLights()) {
-
-        Vector3 shadow_factor = compute_light_visibility(scene, world, light, P, N, view_ray.time);
-
-        if (shadow_factor.length() > 0) { // Check if not black
-            Vector3 L_raw = light.position - P;
-            double distance_squared = L_raw.dot(L_raw);
-            double falloff = 1.0 / distance_squared;
-            Vector3 L = L_raw.normalize();
-            Vector3 H = (L + V).normalize();
-
-            Vector3 light_intensity_at_point = light.intensity * falloff * exposure;
 
-            double H_dot_N = std::max(0.0, H.dot(N));
-
-            // Calculate base specular
-            Vector3 specular_part = component_wise_multiply(mat.specular, light_intensity_at_point) * fast_pow(H_dot_N, mat.shininess);
-
-            // Apply coloured shadow
-            Vector3 final_specular = component_wise_multiply(specular_part, shadow_factor);
-
-            specular_colour = specular_colour + final_specular;
+    const std::vector<PointLight>& lights = scene.getLights();
+    int light_samples = scene.get_light_samples();
+    if (light_samples > 0 && static_cast<size_t>(light_samples) < lights.size()) {
+        // picks a fixed number of lights from the light bvh, in proportion to their estimated contribution.
+        // each pick is divided by its probability and the number of picks, so the sum matches looping over every light on average.
+        // equation: L ≈ (1 / k) * sum(f(light_i) / pdf(light_i))
+        const LightBVH& light_bvh = scene.getLightBVH();
+        for (int i = 0; i < light_samples; ++i) {
+            uint32_t light_index;
+            double pdf;
+            if (!light_bvh.sample(P, N, sample_bounce_1d(BOUNCE_DIM_LIGHT_PICK, i, light_samples), light_index, pdf)) {
+                // the walk ended in a branch whose lights are all behind the surface, so this pick contributes nothing.
+                continue;
+            }
+            accumulate_light(shading, lights[light_index], 1.0 / (light_samples * pdf), diffuse_colour, mat, scene, world, P, N, V, view_ray.time);
         }
+        return shading;
+    }
 
+    const uint32_t* cell_begin;
+    const uint32_t* cell_end;
+    if (scene.light_culling_enabled() && scene.getLightGrid().cellLights(P, cell_begin, cell_end)) {
+        // only the lights listed for this cell of the light grid can reach the point, and each is checked against its cutoff
+        // radius before any shadow rays are cast.
+        const LightGrid& light_grid = scene.getLightGrid();
+        for (const uint32_t* it = cell_begin; it != cell_end; ++it) {
+            if (light_grid.reaches(*it, P)) {
+                accumulate_light(shading, lights[*it], 1.0, diffuse_colour, mat, scene, world, P, N, V, view_ray.time);
+            }
+        }
+        return shading;
     }
 
-    return specular_colour;
+    for (const auto& light : lights) {
+        accumulate_light(shading, light, 1.0, diffuse_colour, mat, scene, world, P, N, V, view_ray.time);
+    }
+    return shading;
 }
 #endif //B216602_SHADING_H
\ No newline at end of file
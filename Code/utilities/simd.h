@@ -0,0 +1,95 @@
+//
+// Created by alex on 06/12/2025.
+//
+
+#ifndef B216602_SIMD_H
+#define B216602_SIMD_H
+
+// the simd paths are used when the B216602_SIMD cmake option is on and the target supports sse2.
+#if defined(B216602_SIMD) && defined(__SSE2__)
+#include <immintrin.h>
+#define B216602_SIMD_ENABLED 1
+#endif
+
+#ifdef B216602_SIMD_ENABLED
+
+// four lanes of a scalar type, operated on together.
+// a vector's x, y, and z are loaded into the first three lanes and the fourth lane is zero, so it never contributes to a sum.
+// the vectors themselves are not padded: the extra lane only exists in registers, which keeps shapes and hit records small.
+template <typename T>
+struct Lanes4;
+
+// four floats fit in a single sse register.
+template <>
+struct Lanes4<float> {
+    __m128 v;
+
+    // loads x and y as one 64-bit pair and z on its own, leaving the fourth lane zero.
+    static Lanes4 load(const float* p) {
+        return {_mm_movelh_ps(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(p)), _mm_load_ss(p + 2))};
+    }
+    void store(float* p) const {
+        _mm_storel_pi(reinterpret_cast<__m64*>(p), v);
+        _mm_store_ss(p + 2, _mm_movehl_ps(v, v));
+    }
+    static Lanes4 splat(float s) { return {_mm_set1_ps(s)}; }
+
+    // flips the sign bits, so zero lanes become negative zero like scalar negation.
+    Lanes4 operator-() const { return {_mm_xor_ps(v, _mm_set1_ps(-0.0f))}; }
+    Lanes4 operator+(const Lanes4& o) const { return {_mm_add_ps(v, o.v)}; }
+    Lanes4 operator-(const Lanes4& o) const { return {_mm_sub_ps(v, o.v)}; }
+    Lanes4 operator*(const Lanes4& o) const { return {_mm_mul_ps(v, o.v)}; }
+    Lanes4 operator/(const Lanes4& o) const { return {_mm_div_ps(v, o.v)}; }
+
+    Lanes4 yzx() const { return {_mm_shuffle_ps(v, v, _MM_SHUFFLE(3, 0, 2, 1))}; }
+    float sum() const {
+        // adds the upper pair onto the lower pair, then the two remaining lanes.
+        __m128 pairs = _mm_add_ps(v, _mm_movehl_ps(v, v));
+        return _mm_cvtss_f32(_mm_add_ss(pairs, _mm_shuffle_ps(pairs, pairs, 1)));
+    }
+
+    // the hardware estimate is accurate to about 12 bits, so one newton-raphson step brings it to full float precision.
+    // equation: y' = y * (1.5 - 0.5 * s * y^2)
+    static float rsqrt(float s) {
+        float y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(s)));
+        return y * (1.5f - 0.5f * s * y * y);
+    }
+};
+
+// four doubles are held in two sse registers: (x, y) and (z, w).
+template <>
+struct Lanes4<double> {
+    __m128d lo, hi;
+
+    // the vector is only aligned to a double, so the (x, y) pair uses an unaligned load.
+    static Lanes4 load(const double* p) { return {_mm_loadu_pd(p), _mm_load_sd(p + 2)}; }
+    void store(double* p) const { _mm_storeu_pd(p, lo); _mm_store_sd(p + 2, hi); }
+    static Lanes4 splat(double s) { return {_mm_set1_pd(s), _mm_set1_pd(s)}; }
+
+    Lanes4 operator-() const { return {_mm_xor_pd(lo, _mm_set1_pd(-0.0)), _mm_xor_pd(hi, _mm_set1_pd(-0.0))}; }
+    Lanes4 operator+(const Lanes4& o) const { return {_mm_add_pd(lo, o.lo), _mm_add_pd(hi, o.hi)}; }
+    Lanes4 operator-(const Lanes4& o) const { return {_mm_sub_pd(lo, o.lo), _mm_sub_pd(hi, o.hi)}; }
+    Lanes4 operator*(const Lanes4& o) const { return {_mm_mul_pd(lo, o.lo), _mm_mul_pd(hi, o.hi)}; }
+    Lanes4 operator/(const Lanes4& o) const { return {_mm_div_pd(lo, o.lo), _mm_div_pd(hi, o.hi)}; }
+
+    // (x, y), (z, w) -> (y, z), (x, w)
+    Lanes4 yzx() const { return {_mm_shuffle_pd(lo, hi, 1), _mm_shuffle_pd(lo, hi, 2)}; }
+    double sum() const {
+        __m128d pairs = _mm_add_pd(lo, hi);
+        return _mm_cvtsd_f64(_mm_add_sd(pairs, _mm_unpackhi_pd(pairs, pairs)));
+    }
+
+    static double rsqrt(double s);
+};
+
+// there is no double precision estimate, so the float estimate is refined with two newton-raphson steps
+// (about 12 -> 24 -> 48 bits), which is still cheaper than a square root followed by a divide.
+inline double Lanes4<double>::rsqrt(double s) {
+    double y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast<float>(s))));
+    y = y * (1.5 - 0.5 * s * y * y);
+    return y * (1.5 - 0.5 * s * y * y);
+}
+
+#endif // B216602_SIMD_ENABLED
+
+#endif //B216602_SIMD_H
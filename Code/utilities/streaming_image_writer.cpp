@@ -0,0 +1,80 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "streaming_image_writer.h"
+#include <stdexcept>
+
+StreamingImageWriter::StreamingImageWriter(const Image& image, const std::string& path)
+    : m_image(image), m_path(path), m_file(path, std::ios::binary),
+      m_unfinished_columns(static_cast<size_t>(image.getHeight()), image.getWidth()) {
+    if (!m_file) {
+        throw std::runtime_error("Cannot open file for writing: " + path);
+    }
+    m_image.writeHeader(m_file);
+    m_thread = std::thread([this]() { run(); });
+}
+
+StreamingImageWriter::~StreamingImageWriter() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_changed.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+}
+
+void StreamingImageWriter::blockFinished(int x0, int y0, int x1, int y1) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (int y = y0; y < y1; ++y) {
+        m_unfinished_columns[y] -= x1 - x0;
+    }
+    // only a block finishing the next row to write lets the thread write anything.
+    if (y0 <= m_next_row && m_next_row < y1 && m_unfinished_columns[m_next_row] == 0) {
+        m_changed.notify_all();
+    }
+}
+
+void StreamingImageWriter::finish() {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if (m_next_row < m_image.getHeight() && m_unfinished_columns[m_next_row] != 0) {
+            // nothing more can finish, so the thread would wait forever.
+            m_stopping = true;
+            m_changed.notify_all();
+        }
+    }
+    m_thread.join();
+    if (m_next_row < m_image.getHeight()) {
+        throw std::runtime_error("Image was not finished before writing it to: " + m_path);
+    }
+    m_file.close();
+    if (!m_file) {
+        throw std::runtime_error("Error writing pixel data to file: " + m_path);
+    }
+}
+
+void StreamingImageWriter::run() {
+    const int height = m_image.getHeight();
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_next_row < height) {
+        m_changed.wait(lock, [&]() { return m_unfinished_columns[m_next_row] == 0 || m_stopping; });
+        if (m_unfinished_columns[m_next_row] != 0) {
+            return;
+        }
+        int end = m_next_row;
+        while (end < height && m_unfinished_columns[end] == 0) {
+            end++;
+        }
+
+        // the rows are written without the lock, so the renderer can keep finishing blocks meanwhile.
+        // the pixels of finished rows are no longer written to.
+        int start = m_next_row;
+        lock.unlock();
+        m_image.writeRows(m_file, start, end);
+        lock.lock();
+        m_next_row = end;
+    }
+}
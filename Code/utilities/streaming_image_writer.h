@@ -0,0 +1,49 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_STREAMING_IMAGE_WRITER_H
+#define B216602_STREAMING_IMAGE_WRITER_H
+
+#include "Image.h"
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// writes an image to a ppm file while it is still being rendered. the header is written straight away, and a
+// thread of its own writes each band of rows as soon as every block covering it has finished, so only the last
+// band is left to write once the render is done.
+class StreamingImageWriter {
+public:
+    // throws std::runtime_error if the file cannot be opened. the image must outlive the writer.
+    StreamingImageWriter(const Image& image, const std::string& path);
+    // stops writing, leaving the file incomplete, if finish() was not called.
+    ~StreamingImageWriter();
+    StreamingImageWriter(const StreamingImageWriter&) = delete;
+    StreamingImageWriter& operator=(const StreamingImageWriter&) = delete;
+
+    // marks the columns x0 to x1 of rows y0 to y1 as finished. the pixels must already be in the image.
+    void blockFinished(int x0, int y0, int x1, int y1);
+    // waits for the rest of the image to be written. every pixel must have been finished.
+    // throws std::runtime_error if writing failed.
+    void finish();
+
+private:
+    void run();
+
+    const Image& m_image;
+    std::string m_path;
+    std::ofstream m_file;
+    std::mutex m_mutex;
+    std::condition_variable m_changed;
+    // the columns of each row still to be rendered, and the first row not yet written.
+    std::vector<int> m_unfinished_columns;
+    int m_next_row = 0;
+    bool m_stopping = false;
+    std::thread m_thread;
+};
+
+#endif //B216602_STREAMING_IMAGE_WRITER_H
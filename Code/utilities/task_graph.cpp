@@ -0,0 +1,106 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "task_graph.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+TaskGraph::TaskId TaskGraph::add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies) {
+    TaskId id = m_tasks.size();
+    for (TaskId dependency : dependencies) {
+        if (dependency >= id) {
+            throw std::logic_error("Task '" + name + "' depends on a task added after it.");
+        }
+        m_tasks[dependency].dependents.push_back(id);
+    }
+    m_tasks.push_back(Task{name, std::move(work), {}, dependencies.size()});
+    return id;
+}
+
+void TaskGraph::run(int threads) {
+    m_timings.clear();
+    const auto start = std::chrono::steady_clock::now();
+
+    std::mutex mutex;
+    std::condition_variable changed;
+    std::deque<TaskId> ready;
+    std::vector<size_t> waiting_on(m_tasks.size());
+    std::vector<bool> skipped(m_tasks.size(), false);
+    size_t unfinished = m_tasks.size();
+    std::exception_ptr failure;
+    for (TaskId id = 0; id < m_tasks.size(); ++id) {
+        waiting_on[id] = m_tasks[id].dependency_count;
+        if (waiting_on[id] == 0) {
+            ready.push_back(id);
+        }
+    }
+
+    // takes ready tasks until every task has finished. a finished task releases its dependents, or skips them if
+    // it failed or was skipped itself; skipped tasks are finished straight away, without running.
+    auto worker = [&]() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            changed.wait(lock, [&]() { return !ready.empty() || unfinished == 0; });
+            if (unfinished == 0) {
+                return;
+            }
+            TaskId id = ready.front();
+            ready.pop_front();
+
+            bool failed = skipped[id];
+            if (!failed) {
+                TaskTiming timing;
+                timing.name = m_tasks[id].name;
+                lock.unlock();
+                auto task_start = std::chrono::steady_clock::now();
+                try {
+                    m_tasks[id].work();
+                } catch (...) {
+                    failed = true;
+                    lock.lock();
+                    if (!failure) {
+                        failure = std::current_exception();
+                    }
+                    lock.unlock();
+                }
+                auto task_end = std::chrono::steady_clock::now();
+                timing.start = std::chrono::duration<double>(task_start - start).count();
+                timing.seconds = std::chrono::duration<double>(task_end - task_start).count();
+                lock.lock();
+                m_timings.push_back(timing);
+            }
+
+            for (TaskId dependent : m_tasks[id].dependents) {
+                skipped[dependent] = skipped[dependent] || failed;
+                if (--waiting_on[dependent] == 0) {
+                    ready.push_back(dependent);
+                }
+            }
+            unfinished--;
+            changed.notify_all();
+        }
+    };
+
+    // there is no point starting more threads than there are tasks.
+    int thread_count = static_cast<int>(std::min<size_t>(std::max(1, threads), std::max<size_t>(1, m_tasks.size())));
+    std::vector<std::thread> helpers;
+    for (int t = 1; t < thread_count; ++t) {
+        helpers.emplace_back(worker);
+    }
+    worker();
+    for (std::thread& helper : helpers) {
+        helper.join();
+    }
+
+    std::sort(m_timings.begin(), m_timings.end(), [](const TaskTiming& a, const TaskTiming& b) { return a.start < b.start; });
+    if (failure) {
+        std::rethrow_exception(failure);
+    }
+}
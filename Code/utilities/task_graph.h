@@ -0,0 +1,50 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_TASK_GRAPH_H
+#define B216602_TASK_GRAPH_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+// when a task of a graph ran, in seconds from the start of the run.
+struct TaskTiming {
+    std::string name;
+    double start = 0.0;
+    double seconds = 0.0;
+};
+
+// a set of named tasks and the tasks each must wait for. running the graph starts every task as soon as the tasks
+// it depends on have finished, on a few threads, so independent stages such as decoding textures and building the
+// bvh overlap instead of running one after another.
+class TaskGraph {
+public:
+    using TaskId = size_t;
+
+    // adds a task that starts once every task in 'dependencies' (added earlier) has finished.
+    TaskId add(const std::string& name, std::function<void()> work, const std::vector<TaskId>& dependencies = {});
+
+    // runs every task on up to 'threads' threads, counting the calling thread, and returns once all have finished.
+    // if a task throws, the tasks depending on it are skipped, and the first exception is rethrown once the rest
+    // have finished.
+    void run(int threads);
+
+    // the tasks that ran in the last run, in the order they started.
+    const std::vector<TaskTiming>& timings() const { return m_timings; }
+
+private:
+    struct Task {
+        std::string name;
+        std::function<void()> work;
+        std::vector<TaskId> dependents;
+        size_t dependency_count = 0;
+    };
+
+    std::vector<Task> m_tasks;
+    std::vector<TaskTiming> m_timings;
+};
+
+#endif //B216602_TASK_GRAPH_H
@@ -0,0 +1,178 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "tile_scheduler.h"
+#include <algorithm>
+
+// spreads the low 16 bits of v out to the even bits of the result.
+static uint32_t spread_bits(uint32_t v) {
+    v &= 0x0000FFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+std::vector<Tile> make_tiles(int width, int height, int tile_size) {
+    tile_size = std::max(1, tile_size);
+    int tiles_x = (width + tile_size - 1) / tile_size;
+    int tiles_y = (height + tile_size - 1) / tile_size;
+
+    // the morton code interleaves the bits of the tile's column and row.
+    std::vector<std::pair<uint32_t, Tile>> coded;
+    coded.reserve(static_cast<size_t>(tiles_x) * tiles_y);
+    for (int ty = 0; ty < tiles_y; ++ty) {
+        for (int tx = 0; tx < tiles_x; ++tx) {
+            Tile tile{tx * tile_size, ty * tile_size,
+                      std::min(width, (tx + 1) * tile_size), std::min(height, (ty + 1) * tile_size)};
+            uint32_t code = spread_bits(static_cast<uint32_t>(tx)) | (spread_bits(static_cast<uint32_t>(ty)) << 1);
+            coded.emplace_back(code, tile);
+        }
+    }
+    // a non-square image leaves gaps in the curve, which sorting by code simply skips.
+    std::sort(coded.begin(), coded.end(), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    std::vector<Tile> tiles;
+    tiles.reserve(coded.size());
+    for (const auto& entry : coded) {
+        tiles.push_back(entry.second);
+    }
+    return tiles;
+}
+
+static uint64_t pack_range(uint32_t begin, uint32_t end) {
+    return static_cast<uint64_t>(begin) | (static_cast<uint64_t>(end) << 32);
+}
+
+WorkStealingPool::WorkStealingPool(int threads)
+    : m_thread_count(std::max(1, threads)), m_queues(new Queue[std::max(1, threads)]) {
+    // worker 0 is whichever thread calls run, so only the others get a thread of their own.
+    for (int worker = 1; worker < m_thread_count; ++worker) {
+        m_threads.emplace_back(&WorkStealingPool::workerLoop, this, worker);
+    }
+}
+
+WorkStealingPool::~WorkStealingPool() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_shutdown = true;
+    }
+    m_batch_ready.notify_all();
+    for (std::thread& thread : m_threads) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::initialShare(uint32_t task_count, int worker, uint32_t& begin, uint32_t& end) const {
+    begin = static_cast<uint32_t>(static_cast<uint64_t>(task_count) * worker / m_thread_count);
+    end = static_cast<uint32_t>(static_cast<uint64_t>(task_count) * (worker + 1) / m_thread_count);
+}
+
+void WorkStealingPool::run(uint32_t task_count, const std::function<void(uint32_t, int)>& task) {
+    // gives each worker an equal contiguous share. with tiles in morton order, each share is a compact patch of the image.
+    for (int worker = 0; worker < m_thread_count; ++worker) {
+        uint32_t begin, end;
+        initialShare(task_count, worker, begin, end);
+        m_queues[worker].range.store(pack_range(begin, end), std::memory_order_relaxed);
+    }
+    m_task = &task;
+    runBatch();
+    m_task = nullptr;
+}
+
+void WorkStealingPool::runOnEachWorker(const std::function<void(int)>& function) {
+    m_each_worker = &function;
+    runBatch();
+    m_each_worker = nullptr;
+}
+
+void WorkStealingPool::runBatch() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_busy_workers = m_thread_count - 1;
+        m_generation++;
+    }
+    m_batch_ready.notify_all();
+
+    drain(0);
+
+    // waits for the other workers to finish the tasks they are running.
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_batch_done.wait(lock, [&] { return m_busy_workers == 0; });
+}
+
+void WorkStealingPool::workerLoop(int worker) {
+    uint64_t seen_generation = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_batch_ready.wait(lock, [&] { return m_shutdown || m_generation != seen_generation; });
+            if (m_shutdown) {
+                return;
+            }
+            seen_generation = m_generation;
+        }
+
+        drain(worker);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (--m_busy_workers == 0) {
+            m_batch_done.notify_one();
+        }
+    }
+}
+
+void WorkStealingPool::drain(int worker) {
+    if (m_each_worker) {
+        (*m_each_worker)(worker);
+        return;
+    }
+    uint32_t task;
+    while (popFront(worker, task) || stealBack(worker, task)) {
+        (*m_task)(task, worker);
+    }
+}
+
+bool WorkStealingPool::popFront(int worker, uint32_t& task) {
+    std::atomic<uint64_t>& range = m_queues[worker].range;
+    uint64_t current = range.load(std::memory_order_acquire);
+    while (true) {
+        uint32_t begin = static_cast<uint32_t>(current);
+        uint32_t end = static_cast<uint32_t>(current >> 32);
+        if (begin >= end) {
+            return false;
+        }
+        // on failure, 'current' is reloaded with the range a thief left behind.
+        if (range.compare_exchange_weak(current, pack_range(begin + 1, end), std::memory_order_acq_rel)) {
+            task = begin;
+            return true;
+        }
+    }
+}
+
+bool WorkStealingPool::stealBack(int thief, uint32_t& task) {
+    // visits the other workers in turn, starting with the next one, so thieves spread over different victims.
+    for (int offset = 1; offset < m_thread_count; ++offset) {
+        std::atomic<uint64_t>& range = m_queues[(thief + offset) % m_thread_count].range;
+        uint64_t current = range.load(std::memory_order_acquire);
+        while (true) {
+            uint32_t begin = static_cast<uint32_t>(current);
+            uint32_t end = static_cast<uint32_t>(current >> 32);
+            if (begin >= end) {
+                break;
+            }
+            // takes the back half, rounded up, so a single remaining task can be stolen too.
+            uint32_t middle = begin + (end - begin) / 2;
+            if (range.compare_exchange_weak(current, pack_range(begin, middle), std::memory_order_acq_rel)) {
+                // the thief's own queue is empty, and a range of unfinished tasks can never equal a range a
+                // slower thief read before it emptied, so a plain store cannot be confused with an older value.
+                m_queues[thief].range.store(pack_range(middle + 1, end), std::memory_order_release);
+                task = middle;
+                return true;
+            }
+        }
+    }
+    return false;
+}
@@ -0,0 +1,84 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_TILE_SCHEDULER_H
+#define B216602_TILE_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// a rectangle of pixels rendered as one task, from (x0, y0) up to but not including (x1, y1).
+struct Tile {
+    int x0, y0, x1, y1;
+    int width() const { return x1 - x0; }
+    int height() const { return y1 - y0; }
+};
+
+// splits an image into square tiles of 'tile_size' pixels (smaller along the right and bottom edges),
+// ordered along a morton (z-order) curve, so consecutive tiles are close together on screen and in the scene.
+std::vector<Tile> make_tiles(int width, int height, int tile_size);
+
+// a fixed set of std::threads that run a batch of numbered tasks, such as the tiles of a pass.
+// each batch is split into one contiguous range of tasks per worker. a worker takes tasks from the front of its own
+// range, and once that is empty it steals the back half of another worker's range, so a few expensive tiles
+// only hold up the worker rendering them while the others share out what remains.
+class WorkStealingPool {
+public:
+    // starts the pool with 'threads' workers, counting the thread that calls run.
+    explicit WorkStealingPool(int threads);
+    ~WorkStealingPool();
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    int threadCount() const { return m_thread_count; }
+
+    // calls task(index, worker) for every index in [0, task_count) and returns once all have finished.
+    // 'worker' is in [0, threadCount()) and identifies the calling thread, so tasks can reuse per-worker buffers.
+    // the calling thread is worker 0.
+    void run(uint32_t task_count, const std::function<void(uint32_t, int)>& task);
+
+    // calls function(worker) once on every worker's thread, e.g. to pin it to a cpu, and returns once all have finished.
+    void runOnEachWorker(const std::function<void(int)>& function);
+
+    // the tasks [begin, end) that run gives 'worker' before any are stolen.
+    void initialShare(uint32_t task_count, int worker, uint32_t& begin, uint32_t& end) const;
+
+private:
+    // a worker's remaining tasks, packed as begin (low 32 bits) and end (high 32 bits) so both ends
+    // can be updated with a single compare-and-swap. aligned so that neighbouring queues do not share a cache line.
+    struct alignas(64) Queue {
+        std::atomic<uint64_t> range{0};
+    };
+
+    void workerLoop(int worker);
+    // wakes the other workers for the batch set up by the caller, runs the caller's part and waits for the rest.
+    void runBatch();
+    // runs the worker's part of a batch: the function of runOnEachWorker, or else tasks from the worker's own queue,
+    // then from other queues, until none are left anywhere.
+    void drain(int worker);
+    bool popFront(int worker, uint32_t& task);
+    bool stealBack(int thief, uint32_t& task);
+
+    int m_thread_count;
+    std::unique_ptr<Queue[]> m_queues;
+    std::vector<std::thread> m_threads;
+
+    // hands a batch to the workers: each new batch increments the generation and wakes them.
+    std::mutex m_mutex;
+    std::condition_variable m_batch_ready;
+    std::condition_variable m_batch_done;
+    uint64_t m_generation = 0;
+    int m_busy_workers = 0;
+    bool m_shutdown = false;
+    const std::function<void(uint32_t, int)>* m_task = nullptr;
+    const std::function<void(int)>* m_each_worker = nullptr;
+};
+
+#endif //B216602_TILE_SCHEDULER_H
@@ -0,0 +1,29 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#include "timing_stats.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+TimingStats summarise_timings(std::vector<double> seconds) {
+    TimingStats stats;
+    if (seconds.empty()) {
+        return stats;
+    }
+    std::sort(seconds.begin(), seconds.end());
+    size_t n = seconds.size();
+    stats.min = seconds.front();
+    stats.median = n % 2 == 1 ? seconds[n / 2] : 0.5 * (seconds[n / 2 - 1] + seconds[n / 2]);
+    stats.mean = std::accumulate(seconds.begin(), seconds.end(), 0.0) / n;
+    if (n > 1) {
+        // equation: stddev = sqrt(sum((t - mean)^2) / (n - 1))
+        double squares = 0.0;
+        for (double t : seconds) {
+            squares += (t - stats.mean) * (t - stats.mean);
+        }
+        stats.stddev = std::sqrt(squares / (n - 1));
+    }
+    return stats;
+}
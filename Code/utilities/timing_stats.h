@@ -0,0 +1,21 @@
+//
+// Created by alex on 07/12/2025.
+//
+
+#ifndef B216602_TIMING_STATS_H
+#define B216602_TIMING_STATS_H
+
+#include <vector>
+
+// summary statistics of a set of repeated timings, in seconds.
+struct TimingStats {
+    double min = 0.0;
+    double median = 0.0;
+    double mean = 0.0;
+    // the sample standard deviation. zero with fewer than two timings.
+    double stddev = 0.0;
+};
+
+TimingStats summarise_timings(std::vector<double> seconds);
+
+#endif //B216602_TIMING_STATS_H
@@ -15,7 +15,9 @@
 #include <cmath>
 #include <algorithm>
 #include <cstdlib>
+#include <vector>
 #include "random_utils.h"
+#include "arena.h"
 #include "../config.h"
 
 // Reinhardt Tone Mapping
@@ -143,107 +145,157 @@ inline bool compute_refraction(const Vector3& V_in, const Vector3& N, double ref
 }
 
 
-// recursively traces a ray and calculates the color seen along its path.
-inline Vector3 ray_colour(const Ray& r, const Scene& scene, const HittableList& world, int depth) {
-    // stops recursion if the maximum depth is reached.
-    if (depth <= 0) return Vector3(0, 0, 0);
+// calculates the colour seen by a ray that leaves the scene without hitting anything.
+inline Vector3 background_colour(const Ray& r, const Scene& scene) {
+    if (scene.has_hdr_background()) {
+        double u, v;
+        // converts the ray direction to spherical coordinates.
+        get_sphere_uv(r.direction.normalize(), u, v);
+        // samples the hdr image at the calculated (u, v) coordinates.
+        return scene.get_hdr_background()->sample(u,v);
+    }
+
+    double bg_r = Config::Instance().getDouble("background.r", 0.5);
+    double bg_g = Config::Instance().getDouble("background.g", 0.7);
+    double bg_b = Config::Instance().getDouble("background.b", 1.0);
+    return Vector3(bg_r, bg_g, bg_b); // default background
+}
+
+// a ray waiting to be traced, with the weight its colour contributes to the pixel and the bounces it has left.
+struct PathVertex {
+    Ray ray;
+    // the product of every reflection, transmission, and tint factor between the camera and this ray.
+    Vector3 throughput;
+    int depth;
+    // whether a glossy reflection earlier on this path has already been split into several samples.
+    bool glossy_split;
+};
+
+// the roughness at which a glossy reflection gets the full number of samples. smoother surfaces get proportionally fewer.
+const double GLOSSY_FULL_ROUGHNESS = 0.5;
+
+// picks how many rays a glossy reflection is split into.
+// the count grows with the roughness, so mirror-like surfaces get a single sample,
+// and it is capped by what is left of the camera ray's budget, but never drops below one.
+// equation: samples = clamp(ceil(glossy_samples * roughness / full_roughness), 1, min(glossy_samples, budget_left))
+inline int glossy_split_count(int glossy_samples, double roughness, int budget_left) {
+    double fraction = std::min(1.0, roughness / GLOSSY_FULL_ROUGHNESS);
+    int samples = static_cast<int>(std::ceil(glossy_samples * fraction));
+    samples = std::min(samples, budget_left);
+    return std::max(1, std::min(samples, glossy_samples));
+}
+
+// scales the shininess into the phong exponent of the glossy lobe.
+// the old jitter, an offset within a sphere of radius 1/sqrt(shininess), spread each axis by a variance of 1/(5 * shininess),
+// and a phong lobe spreads by about 1/exponent, so this keeps glossy materials looking as blurred as before.
+const double GLOSSY_LOBE_SCALE = 5.0;
+
+// draws a direction from a phong lobe of the given exponent around 'axis', which must be unit length.
+// the angle to the axis is sampled by inverting the lobe's distribution, so every sample is used and each carries the same weight.
+// a sample that falls below the surface is mirrored back above it, keeping its weight instead of being thrown away.
+// equation: cos(theta) = u1^(1 / (exponent + 1)), phi = 2 * pi * u2
+// (u, v) in [0, 1)^2 picks the direction.
+inline Vector3 sample_phong_lobe(const Vector3& axis, const Vector3& N, double exponent, double u, double v) {
+    double cos_theta = std::pow(u, 1.0 / (std::max(0.0, exponent) + 1.0));
+    double sin_theta = std::sqrt(std::max(0.0, 1.0 - cos_theta * cos_theta));
+    double phi = 2.0 * 3.14159265358979323846 * v;
+
+    // builds two tangents perpendicular to the axis, starting from whichever world axis is least aligned with it.
+    Vector3 helper = std::abs(axis.x) > 0.9 ? Vector3(0, 1, 0) : Vector3(1, 0, 0);
+    Vector3 tangent = helper.cross(axis).normalize();
+    Vector3 bitangent = axis.cross(tangent);
+
+    Vector3 dir = tangent * (sin_theta * std::cos(phi)) + bitangent * (sin_theta * std::sin(phi)) + axis * cos_theta;
+    // equation: folded = dir - 2 * (dir . N) * N
+    double below = dir.dot(N);
+    if (below <= 0) {
+        dir = dir - N * (2.0 * below);
+    }
+    return dir;
+}
+
+// traces a ray and calculates the colour seen along its path.
+// rather than recursing for every reflection and refraction, the rays still to be traced are kept in an explicit work stack.
+// each hit adds its local shading, scaled by the ray's throughput, straight into the result and pushes its secondary rays
+// with their own weights, so the stack use is bounded and the final colour is the same weighted sum the recursion produced.
+// equation: colour = sum over rays(throughput * local_colour)
+inline Vector3 ray_colour(const Ray& primary_ray, const Scene& scene, const HittableList& world, int max_depth) {
+    // the stack lives in the thread's scratch arena and is freed when the ray is finished, so the next ray reuses
+    // the same memory and tracing never allocates from the heap.
+    MonotonicArena& scratch = thread_scratch_arena();
+    ArenaScope scratch_scope(scratch);
+    ArenaStack<PathVertex> pending(scratch, 64);
+    pending.push_back({primary_ray, Vector3(1, 1, 1), max_depth, false});
 
     // gets a small offset value to prevent self-intersection artifacts.
     double epsilon = scene.get_epsilon();
+    double min_throughput = scene.get_min_throughput();
+    bool roulette = scene.roulette_enabled();
+    int roulette_depth = scene.get_roulette_depth();
+    // the number of secondary rays this camera ray may queue before glossy reflections stop being split.
+    int ray_budget = scene.get_glossy_ray_budget();
+    int rays_queued = 0;
+    Vector3 colour(0, 0, 0);
+
+    while (!pending.empty()) {
+        PathVertex vertex = pending.back();
+        pending.pop_back();
+        const Ray& r = vertex.ray;
+        const Vector3& throughput = vertex.throughput;
+        int depth = vertex.depth;
+
+        HitRecord rec;
+        count_ray();
+        // checks if the ray intersects with any object in the world.
+        if (!world.intersect(r, epsilon, 100000.0, rec)) {
+            // if the ray doesn't hit any object, sample the background.
+            colour = colour + component_wise_multiply(throughput, background_colour(r, scene));
+            continue;
+        }
 
-    HitRecord rec;
-    // checks if the ray intersects with any object in the world.
-    if (world.intersect(r, epsilon, 100000.0, rec)) {
         if (scene.rendering_normals()) {
             // Map Normal [-1, 1] to Colour [0, 1]
             // Equation: Colour = 0.5 * (Normal + 1.0)
-            return (rec.normal + Vector3(1, 1, 1)) * 0.5;
+            colour = colour + component_wise_multiply(throughput, (rec.normal + Vector3(1, 1, 1)) * 0.5);
+            continue;
         }
 
-        Vector3 diffuse_ambient = calculate_local_ad(rec, scene, world, r.time);
-        Vector3 specular_highlight = calculate_specular(rec, scene, world, r);
+        // the distance secondary rays start above the surface, scaled up for float positions far from the origin.
+        double offset = ray_offset_epsilon(rec.point, epsilon);
 
-        // initializes reflected and refracted color components.
-        Vector3 reflected_colour(0, 0, 0);
-        Vector3 refracted_colour(0, 0, 0);
+        // the light and glossy samples at this hit use the sampler dimensions of its bounce.
+        if (Sampler* sampler = thread_sampler()) {
+            sampler->setBounce(max_depth - depth);
+        }
+
+        // evaluates the direct lighting once, sharing each light's shadow rays between diffuse and specular.
+        LocalShading local = calculate_local_shading(rec, scene, world, r);
 
         // determines if the material is transparent or reflective.
-        bool is_transparent = rec.mat.transparency > 0;
-        bool has_reflection = rec.mat.reflectivity > 0;
+        bool is_transparent = rec.mat->transparency > 0;
+        bool has_reflection = rec.mat->reflectivity > 0;
 
         // if fresnel is enabled, any transparent object can also be reflective.
         if (is_transparent && scene.fresnel_enabled()) has_reflection = true;
-        if (has_reflection) {
-            // gets the number of samples for glossy reflections.
-            // only uses glossy for a max number of bounces to reduce computation.
-            int samples = scene.get_glossy_samples();
-            if (depth < scene.get_max_bounces()) {
-                samples = 1;
-            }
-            // calculates roughness from shininess for glossy reflections.
-            double roughness = 1.0 / sqrt(rec.mat.shininess);
-
-            // gets the normalized incoming ray direction.
-            Vector3 V = r.direction.normalize();
-            // calculates the perfect reflection direction.
-            Vector3 perfect_reflect_dir = reflect(V, rec.normal).normalize();
-
-            // handles glossy reflections with multiple samples.
-            if (samples > 0) {
-                for (int i = 0; i < samples; i++) {
-                    // creates a random offset in a unit sphere, scaled by roughness.
-                    Vector3 random_offset = random_in_unit_sphere() * roughness;
-                    // calculates a perturbed reflection direction for a glossy effect.
-                    Vector3 target_dir = (perfect_reflect_dir + random_offset).normalize();
-                    // ensures the reflected ray is on the same side of the surface as the normal.
-                    if (target_dir.dot(rec.normal) > 0) {
-                        // creates the reflected ray, offset slightly to avoid self-intersection.
-                        Ray reflect_ray(rec.point + rec.normal * epsilon, target_dir, r.time);
-                        // recursively traces the reflected ray and accumulates color.
-                        reflected_colour = reflected_colour + ray_colour(reflect_ray, scene, world, depth - 1);
-                    }
-                }
-                // averages the color from all glossy samples.
-                reflected_colour = reflected_colour * (1.0 / samples);
-            } else {
-                // handles perfect (mirror) reflection with a single ray.
-                Ray reflect_ray(rec.point + rec.normal * epsilon, perfect_reflect_dir, r.time);
-                // recursively traces the reflected ray.
-                reflected_colour = ray_colour(reflect_ray, scene, world, depth - 1);
-            }
-
-            // for metal materials, the reflected color is tinted by the material's diffuse color.
-            if (rec.mat.type == "metal") {
-                reflected_colour = component_wise_multiply(reflected_colour, rec.mat.diffuse);
-            }
-        }
 
         // gets the base reflection and transmission probabilities from the material.
-        double reflect_prob = rec.mat.reflectivity;
-        double transmit_prob = rec.mat.transparency;
+        double reflect_prob = rec.mat->reflectivity;
+        double transmit_prob = rec.mat->transparency;
 
-        // handles refraction for transparent materials.
+        // the refraction is resolved first, since it decides how the reflected and refracted rays are weighted.
+        Vector3 refract_dir;
+        bool valid_refraction = false;
+        bool total_internal_reflection = false;
         if (is_transparent) {
-            Vector3 refract_dir;
-            double fresnel_reflect_prob = 0.0;
             // gets the normalized incoming ray direction and hit normal.
             Vector3 V_in = r.direction.normalize();
             Vector3 N_hit = rec.normal.normalize();
-
+            double fresnel_reflect_prob = 0.0;
             // computes the refraction direction and fresnel reflection probability.
-            bool valid_refraction = compute_refraction(V_in, N_hit, rec.mat.refractive_index,
-                                                     rec.front_face, refract_dir, fresnel_reflect_prob,
-                                                     scene.fresnel_enabled());
-
-            // if refraction is possible (no total internal reflection).
+            valid_refraction = compute_refraction(V_in, N_hit, rec.mat->refractive_index,
+                                                  rec.front_face, refract_dir, fresnel_reflect_prob,
+                                                  scene.fresnel_enabled());
             if (valid_refraction) {
-                // creates the refracted ray.
-                Ray refract_ray(rec.point, refract_dir.normalize(), r.time);
-                // recursively traces the refracted ray.
-                refracted_colour = ray_colour(refract_ray, scene, world, depth - 1);
-                // tints the refracted color by the material's diffuse color (like colored glass).
-                refracted_colour = component_wise_multiply(refracted_colour, rec.mat.diffuse);
-
                 // if fresnel is enabled, update reflection and transmission probabilities.
                 if (scene.fresnel_enabled()) {
                     reflect_prob = fresnel_reflect_prob;
@@ -252,46 +304,104 @@ inline Vector3 ray_colour(const Ray& r, const Scene& scene, const HittableList&
                 }
             } else {
                 // total internal reflection occurred.
+                total_internal_reflection = true;
                 transmit_prob = 0.0;
                 reflect_prob = 1.0;
-                // if reflection wasn't already calculated, calculate it now.
-                if (!has_reflection) {
-                    // calculates the reflection direction.
-                    Vector3 v_reflect = reflect(V_in, N_hit).normalize();
-                    // creates and traces the reflected ray.
-                    Ray reflect_ray(rec.point + N_hit * epsilon, v_reflect, r.time);
-                    reflected_colour = ray_colour(reflect_ray, scene, world, depth - 1);
-                }
             }
         }
-        // combines local, reflected, and refracted colors for transparent materials.
+
+        // adds the local colour. transparent materials only keep their highlight, opaque ones lose diffuse to reflectivity.
         if (is_transparent) {
-            // final color is a mix based on reflection and transmission probabilities.
-            return (reflected_colour * reflect_prob)
-                 + (refracted_colour * transmit_prob)
-                 + specular_highlight;
+            colour = colour + component_wise_multiply(throughput, local.specular);
         } else {
             // Opaque/Metal
-            return diffuse_ambient * (1.0 - rec.mat.reflectivity)
-                 + reflected_colour * rec.mat.reflectivity
-                 + specular_highlight;
-
+            colour = colour + component_wise_multiply(throughput, local.diffuse_ambient * (1.0 - rec.mat->reflectivity) + local.specular);
         }
-    } else {
-        // if the ray doesn't hit any object, sample the background.
-        if (scene.has_hdr_background()) {
-            double u, v;
-            // converts the ray direction to spherical coordinates.
-            get_sphere_uv(r.direction.normalize(), u, v);
-            // samples the hdr image at the calculated (u, v) coordinates.
-            return scene.get_hdr_background()->sample(u,v);
+
+        // secondary rays at the last bounce would contribute nothing, so they are not queued.
+        if (depth - 1 <= 0) continue;
+
+        // queues a secondary ray, unless its weight is too small to change the image.
+        // 'split' marks rays that descend from a split glossy reflection.
+        auto push = [&](const Ray& ray, Vector3 weight, bool split) {
+            double strength = std::max(weight.x, std::max(weight.y, weight.z));
+            // drops branches whose cumulative weight is at or below the threshold, which includes rays with zero weight.
+            if (strength <= min_throughput) return;
+
+            // after the first few bounces, russian roulette keeps a ray with probability equal to its weight (within limits)
+            // and divides the survivors by that probability, so the expected colour is unchanged.
+            // equation: weight' = weight / p with probability p, otherwise 0
+            int bounce = max_depth - depth + 1;
+            if (roulette && bounce > roulette_depth) {
+                double survival = std::min(1.0, std::max(0.05, strength));
+                if (random_double() >= survival) return;
+                weight = weight * (1.0 / survival);
+            }
+            pending.push_back({ray, weight, depth - 1, split});
+            rays_queued++;
+        };
+
+        if (has_reflection) {
+            // the reflected colour is weighted by the reflection probability.
+            Vector3 reflect_weight = throughput * reflect_prob;
+            // for metal materials, the reflected color is tinted by the material's diffuse color.
+            if (rec.mat->type == "metal") {
+                reflect_weight = component_wise_multiply(reflect_weight, rec.mat->diffuse);
+            }
+
+            // calculates roughness from shininess for glossy reflections.
+            double roughness = 1.0 / sqrt(rec.mat->shininess);
+
+            // gets the number of samples for glossy reflections.
+            int samples = scene.get_glossy_samples();
+            bool split = vertex.glossy_split;
+            if (samples <= 0) {
+                // without glossy sampling, the first bounce is a perfect mirror and later bounces use a single jittered ray.
+                samples = (depth < scene.get_max_bounces()) ? 1 : 0;
+            } else if (!vertex.glossy_split) {
+                // only the first glossy reflection on a path is split, so the ray tree cannot multiply at every bounce.
+                samples = glossy_split_count(samples, roughness, ray_budget - rays_queued);
+                split = true;
+            } else {
+                samples = 1;
+            }
+
+            // gets the normalized incoming ray direction.
+            Vector3 V = r.direction.normalize();
+            // calculates the perfect reflection direction.
+            Vector3 perfect_reflect_dir = reflect(V, rec.normal).normalize();
+
+            // handles glossy reflections with multiple samples.
+            if (samples > 0) {
+                // the samples are drawn in proportion to the lobe, so each one carries an equal share of the reflection.
+                Vector3 sample_weight = reflect_weight * (1.0 / samples);
+                Vector3 N = rec.normal.normalize();
+                for (int i = 0; i < samples; i++) {
+                    // samples a glossy direction from a phong lobe around the mirror direction, its exponent set by the shininess.
+                    double u, v;
+                    sample_bounce_2d(BOUNCE_DIM_GLOSSY, u, v, i, samples);
+                    Vector3 target_dir = sample_phong_lobe(perfect_reflect_dir, N, GLOSSY_LOBE_SCALE * rec.mat->shininess, u, v);
+                    // creates the reflected ray, offset slightly to avoid self-intersection.
+                    push(Ray(rec.point + rec.normal * offset, target_dir, r.time), sample_weight, split);
+                }
+            } else {
+                // handles perfect (mirror) reflection with a single ray.
+                push(Ray(rec.point + rec.normal * offset, perfect_reflect_dir, r.time), reflect_weight, vertex.glossy_split);
+            }
+        } else if (total_internal_reflection) {
+            // if reflection wasn't already calculated, the totally reflected ray is traced on its own.
+            Vector3 V_in = r.direction.normalize();
+            Vector3 N_hit = rec.normal.normalize();
+            Vector3 v_reflect = reflect(V_in, N_hit).normalize();
+            push(Ray(rec.point + N_hit * offset, v_reflect, r.time), throughput * reflect_prob, vertex.glossy_split);
         }
 
-        double bg_r = Config::Instance().getDouble("background.r", 0.5);
-        double bg_g = Config::Instance().getDouble("background.g", 0.7);
-        double bg_b = Config::Instance().getDouble("background.b", 1.0);
-        return Vector3(bg_r, bg_g, bg_b); // default background
+        if (valid_refraction) {
+            // the refracted colour is tinted by the material's diffuse color (like colored glass) and weighted by transmission.
+            push(Ray(rec.point, refract_dir.normalize(), r.time), component_wise_multiply(throughput * transmit_prob, rec.mat->diffuse), vertex.glossy_split);
+        }
     }
+    return colour;
 }
 
 inline Pixel final_colour_to_pixel(const Vector3& colour_vec) {
@@ -7,107 +7,199 @@
 
 
 
+#include <array>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
 #include <iostream>
+#include <type_traits>
+#include "real.h"
+#include "simd.h"
 
 
 // represents a 3d vector for points, directions, and colours.
-class Vector3 {
+// 'template' lets the same class be compiled for different scalar types, here float or double.
+// with the B216602_SIMD option the arithmetic goes through 'Lanes4', so each operator is a few sse instructions.
+template <typename T>
+class Vector3T {
 public:
     // the x, y, and z components of the 3d vector.
-    double x, y, z;
+    T x, y, z;
 
     // default constructor.
     // initialises the vector to (0.0, 0.0, 0.0).
-    Vector3() : x(0.0), y(0.0), z(0.0) {}
+    Vector3T() : x(0), y(0), z(0) {}
 
     // parameterised constructor.
     // initialises the vector with the given x, y, and z values.
-    Vector3(double x_in, double y_in, double z_in) : x(x_in), y(y_in), z(z_in) {}
+    // the components are converted to the scalar type, so callers can keep passing doubles.
+    Vector3T(double x_in, double y_in, double z_in) : x(static_cast<T>(x_in)), y(static_cast<T>(y_in)), z(static_cast<T>(z_in)) {}
 
     // unary negation operator.
     // flips the direction of the vector.
     // equation: -v = (-x, -y, -z)
     // const dictates that this method will not change the state of the vector3 object it is called on.
-    Vector3 operator-() const {
+    Vector3T operator-() const {
         // returns a new vector with each component negated.
-        return Vector3(-x, -y, -z);
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(-lanes());
+#else
+        return Vector3T(-x, -y, -z);
+#endif
     }
 
     // vector subtraction operator.
     // equation: a - b = (a.x - b.x, a.y - b.y, a.z - b.z)
-    Vector3 operator-(const Vector3& other) const {
+    Vector3T operator-(const Vector3T& other) const {
         // returns a new vector representing the difference between this vector and another.
-        return Vector3(x - other.x, y - other.y, z - other.z);
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(lanes() - other.lanes());
+#else
+        return Vector3T(x - other.x, y - other.y, z - other.z);
+#endif
     }
 
     // scalar multiplication operator.
     // equation: v * t = (x * t, y * t, z * t)
-    Vector3 operator*(double t) const {
+    Vector3T operator*(T t) const {
         // returns a new vector scaled by the scalar value t.
-        return Vector3(x * t, y * t, z * t);
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(lanes() * Lanes4<T>::splat(t));
+#else
+        return Vector3T(x * t, y * t, z * t);
+#endif
     }
 
     // scalar division operator.
     // equation: v / t = (x / t, y / t, z / t)
-    Vector3 operator/(double t) const {
+    Vector3T operator/(T t) const {
         // returns a new vector scaled down by the scalar value t.
-        return Vector3(x / t, y / t, z / t);
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(lanes() / Lanes4<T>::splat(t));
+#else
+        return Vector3T(x / t, y / t, z / t);
+#endif
     }
 
     // vector addition operator.
     // equation: a + b = (a.x + b.x, a.y + b.y, a.z + b.z)
-    Vector3 operator+(const Vector3& other) const {
+    Vector3T operator+(const Vector3T& other) const {
         // returns a new vector representing the sum of this vector and another.
-        return Vector3(x + other.x, y + other.y, z + other.z);
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(lanes() + other.lanes());
+#else
+        return Vector3T(x + other.x, y + other.y, z + other.z);
+#endif
+    }
+
+    // multiplies this vector by another component by component, used for colours.
+    // equation: a * b = (a.x * b.x, a.y * b.y, a.z * b.z)
+    Vector3T multiply(const Vector3T& other) const {
+#ifdef B216602_SIMD_ENABLED
+        return fromLanes(lanes() * other.lanes());
+#else
+        return Vector3T(x * other.x, y * other.y, z * other.z);
+#endif
     }
 
     // calculates the dot product of this vector and another.
     // equation: a · b = a.x * b.x + a.y * b.y + a.z * b.z
-    double dot(const Vector3& other) const {
+    T dot(const Vector3T& other) const {
         // returns a scalar value.
+#ifdef B216602_SIMD_ENABLED
+        // multiplies all lanes at once, then sums them. the unused fourth lanes multiply to zero.
+        return (lanes() * other.lanes()).sum();
+#else
         return x * other.x + y * other.y + z * other.z;
+#endif
     }
 
     // calculates the cross product of this vector and another.
     // equation: a x b = (a.y*b.z - a.z*b.y, a.z*b.x - a.x*b.z, a.x*b.y - a.y*b.x)
-    Vector3 cross(const Vector3& other) const {
+    Vector3T cross(const Vector3T& other) const {
         // returns a new vector that is perpendicular to both original vectors.
-        return Vector3(
+#ifdef B216602_SIMD_ENABLED
+        // rotating the lanes once before and once after the subtraction needs three shuffles instead of four.
+        // equation: a x b = yzx(a * yzx(b) - yzx(a) * b)
+        Lanes4<T> a = lanes();
+        Lanes4<T> b = other.lanes();
+        return fromLanes((a * b.yzx() - a.yzx() * b).yzx());
+#else
+        return Vector3T(
             y * other.z - z * other.y,
             z * other.x - x * other.z,
             x * other.y - y * other.x
         );
+#endif
     }
 
     // calculates the magnitude (length) of the vector.
     // equation: |v| = sqrt(x*x + y*y + z*z)
-    double length() const {
+    T length() const {
         // returns the scalar length of the vector.
         return std::sqrt(x * x + y * y + z * z);
     }
 
     // calculates the normalised (unit length) version of the vector.
     // equation: v_norm = v / |v|
-    Vector3 normalize() const {
+    Vector3T normalize() const {
+#ifdef B216602_SIMD_ENABLED
+        // compares the squared length against the squared threshold, so no square root is needed before the check.
+        T len_squared = dot(*this);
+        if (len_squared > 1e-12) {
+            // scales every component by the estimated reciprocal square root instead of dividing each one by the length.
+            return *this * Lanes4<T>::rsqrt(len_squared);
+        }
+#else
         // calculates the length of the vector.
-        double len = length();
+        T len = length();
         // checks if the length is greater than a small threshold to avoid division by zero.
         if (len > 1e-6) {
             // returns a new vector with each component divided by the length.
-            return Vector3(x / len, y / len, z / len);
+            return Vector3T(x / len, y / len, z / len);
         }
+#endif
         // returns a zero vector if the original vector's length is close to zero.
-        return Vector3();
+        return Vector3T();
+    }
+
+    // operator for scalar * vector multiplication (t * v).
+    // allows for writing multiplication in the more conventional order.
+    // 'friend' defines it as a non-template function, so a double scalar still converts for a float vector.
+    friend Vector3T operator*(T t, const Vector3T& v) {
+        return v * t;
+    }
+
+#ifdef B216602_SIMD_ENABLED
+private:
+    // loads the components of the vector into lanes.
+    // the components are copied out as an array, since reading y and z through a pointer to x is undefined.
+    // the compiler turns the copy into the same loads.
+    Lanes4<T> lanes() const {
+        std::array<T, 3> components;
+        std::memcpy(components.data(), this, sizeof(components));
+        return Lanes4<T>::load(components.data());
+    }
+
+    // builds a vector from the first three lanes.
+    static Vector3T fromLanes(const Lanes4<T>& l) {
+        std::array<T, 3> components;
+        l.store(components.data());
+        return Vector3T(components[0], components[1], components[2]);
     }
+#endif
 };
 
+// the vector type used throughout the renderer, at the precision selected for the build.
+using Vector3 = Vector3T<Real>;
 
-// global operator for scalar * vector multiplication (t * v).
-// allows for writing multiplication in the more conventional order.
-inline Vector3 operator*(double t, const Vector3& v) {
-    return v * t;
-}
+#ifdef B216602_SIMD_ENABLED
+// 'lanes' and 'fromLanes' copy the vector as three packed components, x first.
+static_assert(std::is_trivially_copyable_v<Vector3> && std::is_standard_layout_v<Vector3>, "Vector3 must be copyable as bytes.");
+static_assert(sizeof(Vector3) == 3 * sizeof(Real), "Vector3 must hold only its three components.");
+static_assert(offsetof(Vector3, x) == 0 && offsetof(Vector3, y) == sizeof(Real) && offsetof(Vector3, z) == 2 * sizeof(Real),
+              "Vector3 components must be stored as x, y, z.");
+#endif
 
 
 #endif //B216602_VECTOR3_H
\ No newline at end of file